@@ -26,24 +26,125 @@ Editor::~Editor(){
 
 int Editor::execute(){
 
+#ifdef withMPI
+  int processNumber = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &processNumber);
+  if(processNumber > 1)
+    return executeDistributed();
+#endif
+
   contourTree_->setDebugLevel(debug_);
   contourTree_->SetdebugLevel_(debug_);
   contourTree_->SetThreadNumber(core_);
+  contourTree_->SetThreadPool(threadPool_);
 
   contourTree_->SetInputData(grid_);
   contourTree_->SetFieldId(fieldId_);
   contourTree_->ShowSegmentation(true);
   contourTree_->SetLessPartition(lessPartitions_);
+  contourTree_->SetPartitionsPerThread(partitionsPerThread_);
+  contourTree_->SetPartitionGroups(partitionGroups_);
+  contourTree_->SetPruneOnTheFly(pruneOnTheFly_);
+  contourTree_->SetPartitionSort(partitionSort_);
+  contourTree_->SetWorkBalance(workBalance_);
+  contourTree_->SetOverlapWeight(overlapWeight_);
+  contourTree_->SetNumaReplication(numaReplication_);
   contourTree_->SetSimplificationType(method_);
   contourTree_->SetSimplificationThreshold(threshold_);
   contourTree_->SetTreeType(treeType_);
+  contourTree_->SetSortCacheDirectory(cacheDirectory_);
+  contourTree_->SetMeshCacheDirectory(cacheDirectory_);
+  contourTree_->SetThreadAffinity(threadAffinity_);
   contourTree_->Update();
 
+  // run to run variance of the contour tree computation
+  if(runs_ > 0){
+    vector<double> times(runs_);
+    for(int r = 0; r < runs_; r++){
+      DebugTimer timer;
+      contourTree_->SetThreadAffinity(threadAffinity_);
+      contourTree_->Update();
+      times[r] = timer.getElapsedTime();
+    }
+
+    double mean = 0, variance = 0;
+    for(const double &t : times)
+      mean += t/runs_;
+    for(const double &t : times)
+      variance += (t - mean)*(t - mean)/runs_;
+
+    stringstream msg;
+    msg << "[Editor] " << runs_ << " runs: mean " << mean
+      << " s, standard deviation " << sqrt(variance)
+      << " s, min " << *min_element(times.begin(), times.end())
+      << " s, max " << *max_element(times.begin(), times.end())
+      << " s" << endl;
+    dMsg(cout, msg.str(), 1);
+  }
+
+  // the cache is shared by the runs: keep its most recently used files
+  if(cacheDirectory_.length()){
+    const int removed = OsCall::trimDirectory(cacheDirectory_,
+      {"sort_", "mesh_"}, (size_t) max(cacheSize_, 0) << 20);
+    if(removed){
+      stringstream msg;
+      msg << "[Editor] " << removed << " cache file(s) removed from "
+        << cacheDirectory_ << endl;
+      dMsg(cout, msg.str(), 2);
+    }
+  }
+
+  if(treeFilePath_.length()){
+    if(contourTree_->WriteTree(treeFilePath_))
+      return -1;
+  }
+
   grid_->ShallowCopy(contourTree_->GetOutput());
 
   return 0;
 }
 
+#ifdef withMPI
+int Editor::executeDistributed(){
+
+  vtkImageData *image = vtkImageData::SafeDownCast(grid_);
+  vtkDataArray *field = (image) ? image->GetPointData()->GetArray(fieldId_)
+    : NULL;
+  if((!field)||(field->GetNumberOfComponents() != 1)){
+    cerr << "[Editor] Distributed trees need a scalar field on a grid (vti or raw)"
+      << endl;
+    return -1;
+  }
+
+  DistributedContourTree tree;
+  tree.setDebugLevel(debug_);
+  tree.setNbThread(core_);
+  tree.setNbPartitions(core_*partitionsPerThread_);
+
+  int dimensions[3];
+  image->GetDimensions(dimensions);
+  if(tree.setGrid(dimensions))
+    return -1;
+
+  // only the slab of this process is read (raw volumes are memory mapped)
+  void *blockScalars = field->GetVoidPointer(tree.getGlobalIds()[0]);
+
+  int ret = 0;
+  switch(field->GetDataType()){
+    vtkTemplateMacro(ret = tree.build((VTK_TT *) blockScalars));
+  }
+  if(ret)
+    return -1;
+
+  if(treeFilePath_.length()){
+    if(tree.writeTree(treeFilePath_))
+      return -1;
+  }
+
+  return 0;
+}
+#endif
+
 int Editor::init(int &argc, char **argv){
 
   CommandLineParser parser;
@@ -57,6 +158,41 @@ int Editor::init(int &argc, char **argv){
   parser.setIntArgument("m", &method_, "Simplification method : 0 persist, 1 Vertices ...", true);
   parser.setIntArgument("t", &treeType_, "type of tree : 2 is CT", true);
   parser.setOption("l", &lessPartitions_, "Use 2 time less partitions than nb threads");
+  parser.setIntArgument("pt", &partitionsPerThread_,
+    "Partitions per thread, scheduled dynamically (default 1)", true);
+  parser.setIntArgument("pg", &partitionGroups_,
+    "Groups of partitions stitched first, e.g. one per socket (two-level forest, default 1)",
+    true);
+  parser.setOption("p", &pruneOnTheFly_, "Prune noisy branches during the merge trees sweep");
+  parser.setOption("ps", &partitionSort_,
+    "Sort the vertices inside their partition (no global sort, the sort cache is not used)");
+  parser.setOption("wb", &workBalance_,
+    "Place the seeds to balance the work of the partitions, overlaps included");
+  parser.setDoubleArgument("ow", &overlapWeight_,
+    "Move the seeds to smaller level sets, cost of an overlap vertex (default 0: disabled)",
+    true);
+  parser.setOption("tp", &threadPool_,
+    "Run the tasks on a persistent work-stealing thread pool instead of OpenMP");
+  parser.setOption("numa", &numaReplication_,
+    "Copy the scalar field on each NUMA node for the partitions built there");
+  parser.setStringArgument("aff", &threadAffinity_,
+    "Pin the threads: compact, scatter or a list of cores such as 0,2,4-7", true);
+  parser.setIntArgument("runs", &runs_,
+    "Number of timed runs after the first one, to measure their variance", true);
+  parser.setIntArgument("rx", &rawDimensions_[0], "Raw volume dimension along X", true);
+  parser.setIntArgument("ry", &rawDimensions_[1], "Raw volume dimension along Y", true);
+  parser.setIntArgument("rz", &rawDimensions_[2], "Raw volume dimension along Z", true);
+  parser.setStringArgument("rt", &rawType_,
+    "Raw volume type : uchar, char, ushort, short, int, uint, float, double", true);
+  parser.setOption("rb", &rawBigEndian_, "Raw volume is big endian");
+  parser.setStringArgument("o", &treeFilePath_,
+    "Write the tree and its segmentation in a binary file (with MPI: the distributed tree)",
+    true);
+  parser.setStringArgument("cache", &cacheDirectory_,
+    "Sort and mesh preprocessing cache directory (default: TMPDIR or /tmp, none: disabled)",
+    true);
+  parser.setIntArgument("cachesize", &cacheSize_,
+    "Size of the cache files kept in the cache directory, in MB (default 1024)", true);
 
   // now parse the command line
   parser.parse(argc, argv);
@@ -79,12 +215,48 @@ int Editor::init(int &argc, char **argv){
     threshold_ = 0;
   }
 
+  if(overlapWeight_ == -DBL_MAX){
+    overlapWeight_ = 0;
+  }
+
   if (treeType_ == -INT_MAX) {
      treeType_ = 2;
   }
 
   lessPartitions_ &= core_ != 1;
 
+  if(partitionsPerThread_ == -INT_MAX){
+    partitionsPerThread_ = 1;
+  }
+
+  if(partitionGroups_ == -INT_MAX){
+    partitionGroups_ = 1;
+  }
+
+  if(runs_ == -INT_MAX){
+    runs_ = 0;
+  }
+
+  if(rawDimensions_[2] == -INT_MAX){
+    rawDimensions_[2] = 1;
+  }
+
+  if(!rawType_.length()){
+    rawType_ = "float";
+  }
+
+  if(!cacheDirectory_.length()){
+    const char *tmpDir = getenv("TMPDIR");
+    cacheDirectory_ = (tmpDir && tmpDir[0]) ? tmpDir : "/tmp";
+  }
+  else if(cacheDirectory_ == "none"){
+    cacheDirectory_.clear();
+  }
+
+  if(cacheSize_ == -INT_MAX){
+    cacheSize_ = 1024;
+  }
+
   // now load the data to the editor
   loadData();
 
@@ -97,12 +269,45 @@ int Editor::loadData(){
   std::string extension =
           vtksys::SystemTools::GetFilenameLastExtension(inputFilePath_);
 
-  if (extension == ".vtu"){
-    grid_ = ReadAnXMLFile<vtkXMLUnstructuredGridReader> (inputFilePath_.c_str());
+  // raw volumes and appended raw XML files are memory mapped
+  rawReader_.setDebugLevel(debug_);
+  rawReader_.setThreadNumber(core_);
+
+  // distributed runs: each process only reads its slab of the grid
+  bool distributed = false;
+#ifdef withMPI
+  int processRank = 0, processNumber = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &processRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &processNumber);
+  rawReader_.setSlab(processRank, processNumber);
+  distributed = (processNumber > 1);
+#endif
+
+  if (extension == ".raw" || rawDimensions_[0] != -INT_MAX){
+    if (rawDimensions_[0] == -INT_MAX || rawDimensions_[1] == -INT_MAX) {
+      cerr << "Raw volume, need -rx and -ry (and -rz)" << endl;
+      return -1;
+    }
+    grid_ = rawReader_.readRawVolume(inputFilePath_, rawDimensions_,
+                                     RawReader::getVtkType(rawType_), rawBigEndian_);
+  } else if (extension == ".vtu"){
+    grid_ = rawReader_.readAppendedRaw(inputFilePath_);
+    if (!grid_ && !distributed)
+      grid_ = ReadAnXMLFile<vtkXMLUnstructuredGridReader> (inputFilePath_.c_str());
   } else if (extension == ".vti"){
-    grid_ = ReadAnXMLFile<vtkXMLImageDataReader> (inputFilePath_.c_str());
+    grid_ = rawReader_.readAppendedRaw(inputFilePath_);
+    if (!grid_ && !distributed)
+      grid_ = ReadAnXMLFile<vtkXMLImageDataReader> (inputFilePath_.c_str());
   } else {
-    cerr << "Bad format, need vtu" << endl;
+    cerr << "Bad format, need vtu, vti or raw" << endl;
+    return -1;
+  }
+
+  if (!grid_){
+    // the VTK readers would decode the whole grid on each process
+    if (distributed)
+      cerr << "[Editor] Distributed runs need a raw volume or an uncompressed"
+        << " appended raw .vti file" << endl;
     return -1;
   }
 
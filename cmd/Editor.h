@@ -14,6 +14,13 @@
 // vtk wrappers
 #include                  <vtkContourForests.h>
 
+#ifdef withMPI
+#include                  <DistributedContourTree.h>
+#endif
+
+// local includes
+#include                  <RawReader.h>
+
 // VTK includes
 #include                  <vtkDataSet.h>
 
@@ -64,11 +71,33 @@ protected:
  vtkDataSet *       grid_;
  string             inputFilePath_;
  bool               lessPartitions_;
+ int                partitionsPerThread_;
+ int                partitionGroups_;
+ bool               pruneOnTheFly_;
+ bool               partitionSort_;
+ bool               workBalance_;
+ double             overlapWeight_;
+ bool               threadPool_;
+ bool               numaReplication_;
+ string             threadAffinity_;
+ int                runs_;
  int                method_;
  double             threshold_;
+ int                rawDimensions_[3];
+ string             rawType_;
+ bool               rawBigEndian_;
+ RawReader          rawReader_;
+ string             treeFilePath_;
+ string             cacheDirectory_;
+ int                cacheSize_;
 
  int loadData();
 
+#ifdef withMPI
+ // one slab of the grid per MPI process
+ int executeDistributed();
+#endif
+
 };
 
 #endif // EDITOR_H
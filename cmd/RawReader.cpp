@@ -0,0 +1,545 @@
+/*
+ * file:                  RawReader.cpp
+ * description:           Memory mapped readers for raw volumes and
+ *                        appended-raw VTK XML files.
+ * author:                Your Name Here <Your Email Address Here>.
+ * date:                  The Date Here.
+ */
+
+#include                  <RawReader.h>
+
+#include                  <algorithm>
+#include                  <cstdlib>
+#include                  <cstring>
+
+#include                  <fcntl.h>
+#include                  <sys/mman.h>
+#include                  <sys/stat.h>
+#include                  <unistd.h>
+
+static bool isLittleEndian(){
+  const int one = 1;
+  return *((const char *) &one) == 1;
+}
+
+// legacy VTK cell array ([n, id0, ..., idn-1] per cell) from the XML
+// connectivity and offsets (end of each cell) arrays
+template <class connectivityType, class offsetType>
+static void fillLegacyCells(const connectivityType *connectivity,
+  const offsetType *offsets, const vtkIdType &cellNumber,
+  vtkIdType *cells, vtkIdType *locations, const int &threadNumber){
+
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber)
+#endif
+  for(vtkIdType i = 0; i < cellNumber; i++){
+    const vtkIdType begin = (i) ? offsets[i - 1] : 0;
+    const vtkIdType end = offsets[i];
+    const vtkIdType location = begin + i;
+
+    locations[i] = location;
+    cells[location] = end - begin;
+    for(vtkIdType j = begin; j < end; j++)
+      cells[location + 1 + j - begin] = connectivity[j];
+  }
+}
+
+template <class connectivityType>
+static int fillLegacyCells(const connectivityType *connectivity,
+  vtkDataArray *offsets, const vtkIdType &cellNumber,
+  vtkIdType *cells, vtkIdType *locations, const int &threadNumber){
+
+  switch(offsets->GetDataType()){
+    case VTK_TYPE_INT32:
+      fillLegacyCells(connectivity, (const int *) offsets->GetVoidPointer(0),
+        cellNumber, cells, locations, threadNumber);
+      return 0;
+    case VTK_TYPE_INT64:
+      fillLegacyCells(connectivity,
+        (const long long int *) offsets->GetVoidPointer(0),
+        cellNumber, cells, locations, threadNumber);
+      return 0;
+  }
+  return -1;
+}
+
+RawReader::RawReader(){
+
+  slabRank_ = 0;
+  slabNumber_ = 1;
+}
+
+RawReader::~RawReader(){
+
+  for(int i = 0; i < (int) mappings_.size(); i++){
+    munmap(mappings_[i].first, mappings_[i].second);
+  }
+}
+
+int RawReader::getVtkType(const string &name){
+
+  if((name == "UInt8")||(name == "uchar")||(name == "unsigned_char"))
+    return VTK_TYPE_UINT8;
+  if((name == "Int8")||(name == "char"))
+    return VTK_TYPE_INT8;
+  if((name == "UInt16")||(name == "ushort")||(name == "unsigned_short"))
+    return VTK_TYPE_UINT16;
+  if((name == "Int16")||(name == "short"))
+    return VTK_TYPE_INT16;
+  if((name == "UInt32")||(name == "uint")||(name == "unsigned_int"))
+    return VTK_TYPE_UINT32;
+  if((name == "Int32")||(name == "int"))
+    return VTK_TYPE_INT32;
+  if((name == "UInt64")||(name == "unsigned_long_long"))
+    return VTK_TYPE_UINT64;
+  if((name == "Int64")||(name == "long_long"))
+    return VTK_TYPE_INT64;
+  if((name == "Float32")||(name == "float"))
+    return VTK_TYPE_FLOAT32;
+  if((name == "Float64")||(name == "double"))
+    return VTK_TYPE_FLOAT64;
+
+  return -1;
+}
+
+void RawReader::setSlab(const int &rank, const int &size){
+
+  slabRank_ = rank;
+  slabNumber_ = size;
+}
+
+void RawReader::getSlabVertices(const int dims[3], vtkIdType &first,
+  vtkIdType &number) const{
+
+  first = 0;
+  number = ((vtkIdType) dims[0])*dims[1]*dims[2];
+
+#ifdef withMPI
+  if(slabNumber_ > 1){
+    int axis, firstSlice, lastSlice;
+    DistributedContourTree::getSlab(dims, slabRank_, slabNumber_, axis,
+      firstSlice, lastSlice);
+
+    vtkIdType slice = 1;
+    for(int i = 0; i < axis; i++)
+      slice *= dims[i];
+    first = firstSlice*slice;
+    number = (lastSlice - firstSlice)*slice;
+  }
+#endif
+}
+
+int RawReader::mapFile(const string &fileName, char *&data, size_t &size){
+
+  int fd = open(fileName.data(), O_RDONLY);
+  if(fd == -1){
+    stringstream msg;
+    msg << "[RawReader] Could not open '" << fileName << "'." << endl;
+    dMsg(cerr, msg.str(), fatalMsg);
+    return -1;
+  }
+
+  struct stat fileStat;
+  if((fstat(fd, &fileStat) == -1)||(!fileStat.st_size)){
+    close(fd);
+    return -2;
+  }
+  size = fileStat.st_size;
+
+  // private mapping: byte swapping, if any, stays in memory
+  void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED){
+    stringstream msg;
+    msg << "[RawReader] Could not map '" << fileName << "'." << endl;
+    dMsg(cerr, msg.str(), fatalMsg);
+    return -3;
+  }
+
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  mappings_.push_back(pair<void *, size_t>(map, size));
+  data = (char *) map;
+
+  return 0;
+}
+
+int RawReader::swapBytes(void *data, const size_t &number,
+  const int &typeSize) const{
+
+  if(typeSize == 1)
+    return 0;
+
+  char *bytes = (char *) data;
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_)
+#endif
+  for(long long int i = 0; i < (long long int) number; i++){
+    std::reverse(bytes + i*typeSize, bytes + (i + 1)*typeSize);
+  }
+
+  return 0;
+}
+
+vtkImageData *RawReader::readRawVolume(const string &fileName,
+  const int dims[3], const int &vtkType, const bool &bigEndian){
+
+  vtkDataArray *array =
+    (vtkType != -1) ? vtkDataArray::CreateDataArray(vtkType) : NULL;
+  if(!array){
+    stringstream msg;
+    msg << "[RawReader] Unsupported raw type." << endl;
+    dMsg(cerr, msg.str(), fatalMsg);
+    return NULL;
+  }
+
+  const vtkIdType vertexNumber = ((vtkIdType) dims[0])*dims[1]*dims[2];
+  const int typeSize = array->GetDataTypeSize();
+
+  char *data = NULL;
+  size_t size = 0;
+  if(mapFile(fileName, data, size)){
+    array->Delete();
+    return NULL;
+  }
+
+  if((vertexNumber <= 0)||(size < vertexNumber*typeSize)){
+    stringstream msg;
+    msg << "[RawReader] '" << fileName << "' is smaller than "
+      << dims[0] << "x" << dims[1] << "x" << dims[2] << " values." << endl;
+    dMsg(cerr, msg.str(), fatalMsg);
+    array->Delete();
+    return NULL;
+  }
+
+  if(bigEndian == isLittleEndian()){
+    vtkIdType first, number;
+    getSlabVertices(dims, first, number);
+    swapBytes(data + first*typeSize, number, typeSize);
+  }
+
+  array->SetNumberOfComponents(1);
+  array->SetVoidArray(data, vertexNumber, 1);
+  array->SetName("Scalars");
+
+  {
+    stringstream msg;
+    msg << "[RawReader] Mapped raw volume '" << fileName << "' ("
+      << dims[0] << "x" << dims[1] << "x" << dims[2] << ", "
+      << array->GetDataTypeAsString() << ")." << endl;
+    dMsg(cout, msg.str(), infoMsg);
+  }
+
+  vtkImageData *image = vtkImageData::New();
+  image->SetDimensions(dims[0], dims[1], dims[2]);
+  image->GetPointData()->AddArray(array);
+  array->Delete();
+
+  return image;
+}
+
+string RawReader::getAttribute(const string &tag, const string &name) const{
+
+  const string key = " " + name + "=\"";
+  size_t begin = tag.find(key);
+  if(begin == string::npos)
+    return "";
+  begin += key.length();
+
+  size_t end = tag.find('"', begin);
+  if(end == string::npos)
+    return "";
+
+  return tag.substr(begin, end - begin);
+}
+
+int RawReader::getTag(const string &header, const string &tagName,
+  size_t &pos, string &tag) const{
+
+  const string key = "<" + tagName;
+  while((pos = header.find(key, pos)) != string::npos){
+    const size_t next = pos + key.length();
+    if((next < header.length())
+      &&((header[next] == ' ')||(header[next] == '>')||(header[next] == '/')
+      ||(header[next] == '\n')||(header[next] == '\t'))){
+
+      size_t end = header.find('>', pos);
+      if(end == string::npos)
+        return -1;
+      // attributes are searched with a leading space
+      tag = header.substr(pos, end - pos);
+      std::replace(tag.begin(), tag.end(), '\n', ' ');
+      std::replace(tag.begin(), tag.end(), '\t', ' ');
+      pos = end + 1;
+      return 0;
+    }
+    pos = next;
+  }
+
+  return -1;
+}
+
+vtkDataArray *RawReader::getAppendedArray(const string &tag, char *appended,
+  const bool &header64, const bool &swap, const vtkIdType &firstTuple,
+  const vtkIdType &tupleNumber) const{
+
+  if(getAttribute(tag, "format") != "appended")
+    return NULL;
+
+  const int vtkType = getVtkType(getAttribute(tag, "type"));
+  if(vtkType == -1)
+    return NULL;
+  vtkDataArray *array = vtkDataArray::CreateDataArray(vtkType);
+
+  int componentNumber = 1;
+  if(getAttribute(tag, "NumberOfComponents").length())
+    componentNumber = atoi(getAttribute(tag, "NumberOfComponents").data());
+
+  char *block = appended + atoll(getAttribute(tag, "offset").data());
+
+  // block: size in bytes, then the values
+  unsigned long long int blockSize = 0;
+  if(header64){
+    memcpy(&blockSize, block, sizeof(unsigned long long int));
+    if(swap)
+      std::reverse((char *) &blockSize,
+        ((char *) &blockSize) + sizeof(unsigned long long int));
+    block += sizeof(unsigned long long int);
+  }
+  else{
+    unsigned int size32 = 0;
+    memcpy(&size32, block, sizeof(unsigned int));
+    if(swap)
+      std::reverse((char *) &size32, ((char *) &size32) + sizeof(unsigned int));
+    blockSize = size32;
+    block += sizeof(unsigned int);
+  }
+
+  const int typeSize = array->GetDataTypeSize();
+  const size_t valueNumber = blockSize/typeSize;
+
+  if(swap){
+    // only the requested tuples are read
+    size_t first = 0, number = valueNumber;
+    if(tupleNumber >= 0){
+      first = std::min(valueNumber, (size_t) firstTuple*componentNumber);
+      number = std::min(valueNumber - first,
+        (size_t) tupleNumber*componentNumber);
+    }
+    swapBytes(block + first*typeSize, number, typeSize);
+  }
+
+  array->SetNumberOfComponents(componentNumber);
+  array->SetVoidArray(block, valueNumber, 1);
+  array->SetName(getAttribute(tag, "Name").data());
+
+  return array;
+}
+
+vtkDataSet *RawReader::readAppendedRaw(const string &fileName){
+
+  char *data = NULL;
+  size_t size = 0;
+  if(mapFile(fileName, data, size))
+    return NULL;
+
+  vtkDataSet *output = NULL;
+
+  // the XML header is plain text up to the appended section
+  const string appendedKey = "<AppendedData";
+  char *appendedTag = std::search(data, data + size,
+    appendedKey.begin(), appendedKey.end());
+
+  // nothing to map without an appended section
+  string header(data, (appendedTag != data + size) ? appendedTag - data : 0);
+  string tag;
+  size_t pos = 0;
+
+  string appendedTagText;
+  if(appendedTag != data + size){
+    char *tagEnd = std::find(appendedTag, data + size, '>');
+    appendedTagText = string(appendedTag, tagEnd - appendedTag);
+  }
+
+  char *appended = NULL;
+  if((appendedTagText.length())
+    &&(getAttribute(appendedTagText, "encoding") == "raw")){
+    appended = std::find(appendedTag, data + size, '_');
+    if(appended != data + size)
+      appended++;
+    else
+      appended = NULL;
+  }
+
+  if((appended)&&(!getTag(header, "VTKFile", pos, tag))
+    &&(!getAttribute(tag, "compressor").length())){
+
+    const string type = getAttribute(tag, "type");
+    const bool swap =
+      ((getAttribute(tag, "byte_order") == "BigEndian") == isLittleEndian());
+    const bool header64 = (getAttribute(tag, "header_type") == "UInt64");
+
+    // single piece only
+    size_t piecePos = 0;
+    string pieceTag;
+    bool isSinglePiece = !getTag(header, "Piece", piecePos, pieceTag);
+    if(isSinglePiece){
+      size_t nextPiecePos = piecePos;
+      string nextPieceTag;
+      isSinglePiece = (getTag(header, "Piece", nextPiecePos, nextPieceTag) != 0);
+    }
+
+    if(isSinglePiece){
+
+      int extent[6] = {0, 0, 0, 0, 0, 0};
+      double origin[3] = {0, 0, 0};
+      double spacing[3] = {1, 1, 1};
+      vtkIdType firstTuple = 0, tupleNumber = -1;
+      if(type == "ImageData"){
+        pos = 0;
+        getTag(header, "ImageData", pos, tag);
+
+        stringstream extentStream(getAttribute(tag, "WholeExtent"));
+        stringstream originStream(getAttribute(tag, "Origin"));
+        stringstream spacingStream(getAttribute(tag, "Spacing"));
+        for(int i = 0; i < 6; i++)
+          extentStream >> extent[i];
+        for(int i = 0; i < 3; i++){
+          originStream >> origin[i];
+          spacingStream >> spacing[i];
+        }
+
+        const int dims[3] = {extent[1] - extent[0] + 1,
+          extent[3] - extent[2] + 1, extent[5] - extent[4] + 1};
+        getSlabVertices(dims, firstTuple, tupleNumber);
+      }
+
+      // point data
+      vector<vtkDataArray *> pointData;
+      size_t pointDataPos = header.find("<PointData", piecePos);
+      size_t pointDataEnd = header.find("</PointData>", piecePos);
+      if((pointDataPos != string::npos)&&(pointDataEnd != string::npos)){
+        pos = pointDataPos;
+        while((!getTag(header, "DataArray", pos, tag))&&(pos < pointDataEnd)){
+          vtkDataArray *array = getAppendedArray(tag, appended, header64,
+            swap, firstTuple, tupleNumber);
+          if(array)
+            pointData.push_back(array);
+        }
+      }
+
+      if(type == "ImageData"){
+        vtkImageData *image = vtkImageData::New();
+        image->SetExtent(extent);
+        image->SetOrigin(origin);
+        image->SetSpacing(spacing);
+        output = image;
+      }
+      else if(type == "UnstructuredGrid"){
+        const vtkIdType pointNumber =
+          atoll(getAttribute(pieceTag, "NumberOfPoints").data());
+        const vtkIdType cellNumber =
+          atoll(getAttribute(pieceTag, "NumberOfCells").data());
+
+        vtkDataArray *pointArray = NULL;
+        vtkDataArray *connectivity = NULL;
+        vtkDataArray *offsets = NULL;
+        vtkDataArray *types = NULL;
+
+        pos = header.find("<Points", piecePos);
+        if((pos != string::npos)&&(!getTag(header, "DataArray", pos, tag)))
+          pointArray = getAppendedArray(tag, appended, header64, swap);
+
+        pos = header.find("<Cells", piecePos);
+        size_t cellsEnd = header.find("</Cells>", piecePos);
+        while((pos != string::npos)&&(!getTag(header, "DataArray", pos, tag))
+          &&(pos < cellsEnd)){
+          const string name = getAttribute(tag, "Name");
+          if(name == "connectivity")
+            connectivity = getAppendedArray(tag, appended, header64, swap);
+          else if(name == "offsets")
+            offsets = getAppendedArray(tag, appended, header64, swap);
+          else if(name == "types")
+            types = getAppendedArray(tag, appended, header64, swap);
+        }
+
+        // the triangulation reads float points
+        if((pointArray)&&(pointArray->GetDataType() == VTK_FLOAT)
+          &&(pointArray->GetNumberOfTuples() == pointNumber)
+          &&(connectivity)&&(offsets)&&(types)
+          &&(types->GetDataType() == VTK_UNSIGNED_CHAR)
+          &&(offsets->GetNumberOfTuples() == cellNumber)){
+
+          vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+          points->SetData(pointArray);
+
+          vtkSmartPointer<vtkIdTypeArray> cellIds =
+            vtkSmartPointer<vtkIdTypeArray>::New();
+          cellIds->SetNumberOfValues(
+            cellNumber + connectivity->GetNumberOfTuples());
+          vtkSmartPointer<vtkIdTypeArray> locations =
+            vtkSmartPointer<vtkIdTypeArray>::New();
+          locations->SetNumberOfValues(cellNumber);
+
+          int ret = -1;
+          if(connectivity->GetDataType() == VTK_TYPE_INT32){
+            ret = fillLegacyCells(
+              (const int *) connectivity->GetVoidPointer(0), offsets,
+              cellNumber, cellIds->GetPointer(0), locations->GetPointer(0),
+              threadNumber_);
+          }
+          else if(connectivity->GetDataType() == VTK_TYPE_INT64){
+            ret = fillLegacyCells(
+              (const long long int *) connectivity->GetVoidPointer(0), offsets,
+              cellNumber, cellIds->GetPointer(0), locations->GetPointer(0),
+              threadNumber_);
+          }
+
+          if(!ret){
+            vtkSmartPointer<vtkCellArray> cells =
+              vtkSmartPointer<vtkCellArray>::New();
+            cells->SetCells(cellNumber, cellIds);
+
+            vtkUnstructuredGrid *grid = vtkUnstructuredGrid::New();
+            grid->SetPoints(points);
+            grid->SetCells(vtkUnsignedCharArray::SafeDownCast(types),
+              locations, cells);
+            output = grid;
+          }
+        }
+
+        if(pointArray)
+          pointArray->Delete();
+        if(connectivity)
+          connectivity->Delete();
+        if(offsets)
+          offsets->Delete();
+        if(types)
+          types->Delete();
+      }
+
+      if(output){
+        for(int i = 0; i < (int) pointData.size(); i++)
+          output->GetPointData()->AddArray(pointData[i]);
+      }
+      for(int i = 0; i < (int) pointData.size(); i++)
+        pointData[i]->Delete();
+    }
+  }
+
+  if(!output){
+    // not mappable, leave it to the VTK readers
+    munmap(mappings_.back().first, mappings_.back().second);
+    mappings_.pop_back();
+    return NULL;
+  }
+
+  {
+    stringstream msg;
+    msg << "[RawReader] Mapped appended raw data of '" << fileName << "'."
+      << endl;
+    dMsg(cout, msg.str(), infoMsg);
+  }
+
+  return output;
+}
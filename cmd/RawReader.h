@@ -0,0 +1,87 @@
+/*
+ * file:                  RawReader.h
+ * description:           Memory mapped readers for raw volumes and
+ *                        appended-raw VTK XML files.
+ * author:                Your Name Here <Your Email Address Here>.
+ * date:                  The Date Here.
+ */
+
+#ifndef RAWREADER_H
+#define RAWREADER_H
+
+// base code includes
+#include                  <Debug.h>
+
+#ifdef withMPI
+#include                  <DistributedContourTree.h>
+#endif
+
+// VTK includes
+#include                  <vtkCellArray.h>
+#include                  <vtkDataArray.h>
+#include                  <vtkDataSet.h>
+#include                  <vtkIdTypeArray.h>
+#include                  <vtkImageData.h>
+#include                  <vtkPointData.h>
+#include                  <vtkPoints.h>
+#include                  <vtkSmartPointer.h>
+#include                  <vtkType.h>
+#include                  <vtkUnsignedCharArray.h>
+#include                  <vtkUnstructuredGrid.h>
+
+/// The input files are mapped in memory and their buffers are handed to VTK
+/// without copy (vtkDataArray::SetVoidArray), so the triangulation and the
+/// scalar field read directly from the page cache. The mappings live as long
+/// as the reader: the returned data-sets must not outlive it.
+class RawReader : public Debug {
+
+public:
+
+    RawReader();
+
+    ~RawReader();
+
+    /// Map a headerless raw volume of dimensions dims and VTK type vtkType.
+    /// \return The image data, NULL on failure.
+    vtkImageData *readRawVolume(const string &fileName, const int dims[3],
+      const int &vtkType, const bool &bigEndian);
+
+    /// Map a single piece .vti or .vtu file whose arrays are stored in an
+    /// uncompressed appended raw section.
+    /// \return The data-set, NULL if the file cannot be mapped (inline or
+    /// compressed data, several pieces, ...): use the regular VTK reader then.
+    vtkDataSet *readAppendedRaw(const string &fileName);
+
+    /// Only read the slab of rank among size ranks of the grids (see
+    /// DistributedContourTree::setGrid): the values of the other slabs stay
+    /// mapped but are never touched, nor converted to the host byte order.
+    void setSlab(const int &rank, const int &size);
+
+    /// VTK type from a name: XML names (UInt8, Float32, ...) or VTK names
+    /// (unsigned_char, float, ...). -1 if unknown.
+    static int getVtkType(const string &name);
+
+protected:
+
+ vector<pair<void *, size_t> > mappings_;
+ int                           slabRank_, slabNumber_;
+
+ int mapFile(const string &fileName, char *&data, size_t &size);
+
+ int swapBytes(void *data, const size_t &number, const int &typeSize) const;
+
+ // first vertex and vertex number of the slab in a grid of dims vertices
+ void getSlabVertices(const int dims[3], vtkIdType &first,
+   vtkIdType &number) const;
+
+ // appended raw XML helpers
+ string getAttribute(const string &tag, const string &name) const;
+ int getTag(const string &header, const string &tagName, size_t &pos,
+   string &tag) const;
+ vtkDataArray *getAppendedArray(const string &tag, char *appended,
+   const bool &header64, const bool &swap, const vtkIdType &firstTuple = 0,
+   const vtkIdType &tupleNumber = -1) const;
+
+};
+
+#endif // RAWREADER_H
@@ -10,15 +10,26 @@
 
 int main(int argc, char **argv) {
 
-  // init editor
-  Editor editor;
-  editor.init(argc, argv);
+#ifdef withMPI
+  // one grid slab per process when run with mpirun
+  MPI_Init(&argc, &argv);
+#endif
 
-  // execute data processing
-  editor.execute();
+  {
+    // init editor
+    Editor editor;
+    editor.init(argc, argv);
 
-  // save the output
-  //editor.saveData("output.vti");
+    // execute data processing
+    editor.execute();
+
+    // save the output
+    //editor.saveData("output.vti");
+  }
+
+#ifdef withMPI
+  MPI_Finalize();
+#endif
 
   return 0;
 }
@@ -0,0 +1,76 @@
+/// \brief the tree stitched by groups of partitions equals the sequential one,
+/// on a field full of ties.
+///
+/// Usage: stitchGroups [threads]
+
+#include                  <ParallelContourTree.h>
+#include                  <Triangulation.h>
+
+using namespace std;
+using namespace wtfit;
+
+// for each vertex, the vertices of its node or of the ends of its arc
+static vector<pair<int, int> > getMapping(ParallelContourTree &tree,
+  const int &vertexNumber){
+
+  vector<pair<int, int> > mapping(vertexNumber, make_pair(-2, -2));
+  for(int v = 0; v < vertexNumber; v++){
+    if(tree.isCorrespondingNode(v)){
+      mapping[v] = make_pair(v, -1);
+    }
+    else if(tree.isCorrespondingArc(v)){
+      SuperArc *arc = tree.getSuperArc(tree.getCorrespondingSuperArcId(v));
+      mapping[v] = make_pair(
+        (int) tree.getNode(arc->getDownNodeId())->getVertexId(),
+        (int) tree.getNode(arc->getUpNodeId())->getVertexId());
+    }
+  }
+  return mapping;
+}
+
+int main(int argc, char **argv){
+
+  numThread threadNumber = (argc > 1) ? atoi(argv[1]) : 4;
+
+  Triangulation triangulation;
+  triangulation.setInputGrid(0, 0, 0, 1, 1, 1, 24, 24, 24);
+  triangulation.preprocessEdges();
+  triangulation.preprocessVertexNeighbors();
+
+  // large plateaus: the order of the vertices is decided by the tie break
+  const int vertexNumber = triangulation.getNumberOfVertices();
+  vector<float> scalars(vertexNumber);
+  for(int i = 0; i < vertexNumber; i++){
+    float x = 0, y = 0, z = 0;
+    triangulation.getVertexPoint(i, x, y, z);
+    scalars[i] = ((int) (7*x + 3*y + z))%11;
+  }
+
+  numThread sequentialNumber = 1;
+  ParallelContourTree reference(sequentialNumber);
+  reference.setTriangulation(&triangulation);
+  reference.setVertexScalars(scalars.data());
+  reference.build<float>(true, true, 0);
+  const vector<pair<int, int> > expected
+    = getMapping(reference, vertexNumber);
+
+  int failed = 0;
+  const unsigned groupNumbers[] = {1, 2, 4, 8};
+  for(const unsigned &groupNumber : groupNumbers){
+    ParallelContourTree tree(threadNumber);
+    tree.setTriangulation(&triangulation);
+    tree.setVertexScalars(scalars.data());
+    tree.setNbPartitions(16);
+    tree.setNbGroups(groupNumber);
+    tree.build<float>(true, true, 0);
+
+    if(getMapping(tree, vertexNumber) != expected){
+      cerr << "[stitchGroups] " << groupNumber
+        << " group(s) of 16 partitions differ from the sequential tree"
+        << endl;
+      failed = 1;
+    }
+  }
+
+  return failed;
+}
@@ -0,0 +1,74 @@
+/// \brief the OpenMP threads get their cores back after a pinned build().
+///
+/// Usage: threadAffinity [threads]
+
+#include                  <ParallelContourTree.h>
+#include                  <Triangulation.h>
+
+#include                  <sched.h>
+
+using namespace std;
+using namespace wtfit;
+
+// cores of each thread of an OpenMP team
+static vector<cpu_set_t> getTeamAffinity(const int &threadNumber){
+
+  vector<cpu_set_t> cores(threadNumber);
+#ifdef withOpenMP
+#pragma omp parallel num_threads(threadNumber)
+#endif
+  {
+    int t = 0;
+#ifdef withOpenMP
+    t = omp_get_thread_num();
+#endif
+    CPU_ZERO(&cores[t]);
+    sched_getaffinity(0, sizeof(cpu_set_t), &cores[t]);
+  }
+  return cores;
+}
+
+int main(int argc, char **argv){
+
+  const int threadNumber = (argc > 1) ? atoi(argv[1]) : 4;
+
+  Triangulation triangulation;
+  triangulation.setInputGrid(0, 0, 0, 1, 1, 1, 16, 16, 16);
+  triangulation.preprocessEdges();
+  triangulation.preprocessVertexNeighbors();
+
+  const int vertexNumber = triangulation.getNumberOfVertices();
+  vector<double> scalars(vertexNumber);
+  for(int i = 0; i < vertexNumber; i++){
+    float x = 0, y = 0, z = 0;
+    triangulation.getVertexPoint(i, x, y, z);
+    scalars[i] = sin(x*0.5) + cos(y*0.4) + sin(z*0.3) + 1e-6*i;
+  }
+
+  const vector<cpu_set_t> before = getTeamAffinity(threadNumber);
+
+  // pinning is not observable on a single core
+  if(CPU_COUNT(&before[0]) < 2){
+    cout << "[threadAffinity] needs at least 2 cores, skipped" << endl;
+    return 77;
+  }
+
+  ParallelContourTree tree(threadNumber);
+  tree.setTriangulation(&triangulation);
+  tree.setVertexScalars(scalars.data());
+  tree.setThreadAffinity("compact");
+  tree.build<double>(true, true, 0);
+
+  const vector<cpu_set_t> after = getTeamAffinity(threadNumber);
+
+  int failed = 0;
+  for(int t = 0; t < threadNumber; t++){
+    if(!CPU_EQUAL(&before[t], &after[t])){
+      cerr << "[threadAffinity] thread " << t << " is still pinned after build()"
+        << endl;
+      failed = 1;
+    }
+  }
+
+  return failed;
+}
@@ -57,6 +57,8 @@
     include_directories(${MPI_INCLUDE_PATH})
     set(PROJECT_FLAGS "${PROJECT_FLAGS} -DwithMPI"
       CACHE INTERNAL "PROJECT_FLAGS")
+    set(PROJECT_DEP "${PROJECT_DEP} ${MPI_LIBRARIES}"
+      CACHE INTERNAL "PROJECT_DEP")
   endif(withMPI)
 
   message(STATUS
@@ -94,6 +96,10 @@
     set(PROJECT_FLAGS
       "${PROJECT_FLAGS} -Wall -fPIC ${CXX_FLAGS}"
       CACHE INTERNAL "PROJECT_FLAGS")
+    # std::thread (thread pool executor)
+    set(PROJECT_FLAGS "${PROJECT_FLAGS} -pthread"
+      CACHE INTERNAL "PROJECT_FLAGS")
+    set(PROJECT_DEP "${PROJECT_DEP} -pthread")
     if(NOT CMAKE_BUILD_TYPE MATCHES Debug)
       set (PROJECT_FLAGS
         "${PROJECT_FLAGS} -O3"
@@ -12,6 +12,7 @@ Debug::Debug() {
   threadNumber_ = omp_get_num_procs();
 #endif
   wrapper_ = NULL;
+  executor_ = NULL;
  
   debugLevel_ = infoMsg;
   
@@ -78,5 +79,15 @@ int Debug::setWrapper(const Wrapper *wrapper){
   wrapper_ = (Wrapper *) wrapper;
   setDebugLevel(((Debug *) wrapper)->debugLevel_);
   setThreadNumber(((Debug *) wrapper)->threadNumber_);
+  setExecutor(((Debug *) wrapper)->executor_);
   return 0;
 }
+
+Executor *Debug::getExecutor() const{
+  
+  static OpenMPExecutor openMPExecutor;
+  
+  if(executor_)
+    return executor_;
+  return &openMPExecutor;
+}
@@ -17,6 +17,8 @@
   #include              <omp.h>
 #endif
 
+#include                <Executor.h>
+
 #include                <cerrno>
 #include                <fstream>
 #include                <iostream>
@@ -90,6 +92,18 @@ namespace wtfit{
         return 0;
       }
       
+      /// Run the parallel loops and tasks with executor instead of OpenMP
+      /// teams (NULL: OpenMP). The executor is not owned.
+      /// \sa Executor
+      int setExecutor(Executor *executor){
+        
+        executor_ = executor;
+        return 0;
+      }
+      
+      /// Executor running the parallel loops and tasks.
+      Executor *getExecutor() const;
+      
       /// Specify a pointer to a calling object that wraps the current class 
       /// deriving from wtfit::Debug.
       /// 
@@ -106,6 +120,7 @@ namespace wtfit{
       bool                    lastObject_;
       mutable int             debugLevel_, threadNumber_;
       Wrapper                 *wrapper_;
+      Executor                *executor_;
   };
 }
 
@@ -0,0 +1,374 @@
+#include                <Executor.h>
+#include                <Debug.h>
+
+using namespace std;
+using namespace wtfit;
+
+// children counter of the task running on this thread (tasks spawned outside
+// of a task use a counter per thread)
+static thread_local atomic<int> threadChildren_(0);
+static thread_local atomic<int> *currentChildren_ = NULL;
+
+// queue of the thread, when it is a worker of a pool
+static thread_local const ThreadPoolExecutor *currentPool_ = NULL;
+static thread_local int currentQueue_ = 0;
+
+// core of the thread when pinned by an executor, and its cores before
+static thread_local int pinnedCore_ = -1;
+static thread_local vector<int> freeCores_;
+
+static atomic<int> &getChildren(){
+  if(!currentChildren_)
+    currentChildren_ = &threadChildren_;
+  return *currentChildren_;
+}
+
+void Executor::parallelBlocks(const long &begin, const long &end,
+  const function<void(const long &, const long &)> &block,
+  const int &threadNumber, long grain){
+
+  if(begin >= end)
+    return;
+
+  const long threads = (threadNumber > 0) ? threadNumber : getThreadNumber();
+  if(grain <= 0)
+    grain = max(1L, (end - begin)/(8*max(1L, threads)));
+
+  if(end - begin <= grain){
+    block(begin, end);
+    return;
+  }
+
+  run([&](){
+    for(long first = begin; first < end; first += grain){
+      const long last = min(end, first + grain);
+      spawn([&block, first, last](){ block(first, last); });
+    }
+    wait();
+  }, threadNumber);
+}
+
+void Executor::setAffinity(const vector<int> &cores){
+
+  lock_guard<mutex> lock(affinityLock_);
+  affinity_ = cores;
+  affinityVersion_++;
+}
+
+vector<int> Executor::getAffinity() const{
+
+  lock_guard<mutex> lock(affinityLock_);
+  return affinity_;
+}
+
+vector<int> Executor::getAffinityCores(const string &policy){
+
+  if((policy != "compact")&&(policy != "scatter"))
+    return OsCall::parseCoreList(policy);
+
+  // allowed cores of each NUMA node
+  const vector<int> &coreNodes = OsCall::getCoreNumaNodes();
+  vector<vector<int> > nodeCores(OsCall::getNumberOfNumaNodes());
+  for(const int &core : OsCall::getThreadAffinity()){
+    const int node = (core < (int) coreNodes.size()) ? coreNodes[core] : 0;
+    nodeCores[node].push_back(core);
+  }
+
+  vector<int> cores;
+  if(policy == "compact"){
+    for(const auto &node : nodeCores)
+      cores.insert(cores.end(), node.begin(), node.end());
+  }
+  else{
+    for(size_t i = 0; ; i++){
+      const size_t previousSize = cores.size();
+      for(const auto &node : nodeCores){
+        if(i < node.size())
+          cores.push_back(node[i]);
+      }
+      if(cores.size() == previousSize)
+        break;
+    }
+  }
+  return cores;
+}
+
+void Executor::pinThread(const int &t){
+
+  int core = -1;
+  {
+    lock_guard<mutex> lock(affinityLock_);
+    if(!affinity_.empty())
+      core = affinity_[t % affinity_.size()];
+  }
+
+  if(core == pinnedCore_)
+    return;
+  if(core < 0){
+    unpinThread();
+    return;
+  }
+
+  if(pinnedCore_ < 0)
+    freeCores_ = OsCall::getThreadAffinity();
+  if(!OsCall::setThreadAffinity(vector<int>(1, core)))
+    pinnedCore_ = core;
+}
+
+void Executor::unpinThread(){
+
+  if(pinnedCore_ < 0)
+    return;
+
+  OsCall::setThreadAffinity(freeCores_);
+  pinnedCore_ = -1;
+}
+
+// OpenMPExecutor
+int OpenMPExecutor::getThreadNumber() const{
+#ifdef withOpenMP
+  if(threadNumber_ <= 0)
+    return omp_get_max_threads();
+#endif
+  return (threadNumber_ > 0) ? threadNumber_ : 1;
+}
+
+void OpenMPExecutor::run(const function<void()> &root,
+  const int &threadNumber){
+
+#ifdef withOpenMP
+  if(omp_in_parallel()){
+    root();
+    wait();
+    return;
+  }
+
+  const int threads = (threadNumber > 0) ? threadNumber : getThreadNumber();
+#pragma omp parallel num_threads(threads)
+  {
+    pinThread(omp_get_thread_num());
+#pragma omp single nowait
+    root();
+    // the tasks of the team complete at the barrier
+#pragma omp barrier
+    unpinThread();
+  }
+#else
+  root();
+#endif
+}
+
+void OpenMPExecutor::spawn(const function<void()> &task){
+#ifdef withOpenMP
+  function<void()> t = task;
+#pragma omp task firstprivate(t)
+  t();
+#else
+  task();
+#endif
+}
+
+void OpenMPExecutor::wait(){
+#ifdef withOpenMP
+#pragma omp taskwait
+#endif
+}
+
+void OpenMPExecutor::parallelBlocks(const long &begin, const long &end,
+  const function<void(const long &, const long &)> &block,
+  const int &threadNumber, long grain){
+
+#ifdef withOpenMP
+  // inside a team: tasks
+  if(omp_in_parallel()){
+    Executor::parallelBlocks(begin, end, block, threadNumber, grain);
+    return;
+  }
+
+  const int threads = (threadNumber > 0) ? threadNumber : getThreadNumber();
+  if(grain <= 0)
+    grain = max(1L, (end - begin)/(8L*threads));
+
+#pragma omp parallel num_threads(threads)
+  {
+    pinThread(omp_get_thread_num());
+#pragma omp for schedule(dynamic)
+    for(long first = begin; first < end; first += grain){
+      block(first, min(end, first + grain));
+    }
+    unpinThread();
+  }
+#else
+  if(begin < end)
+    block(begin, end);
+#endif
+}
+
+// ThreadPoolExecutor
+ThreadPoolExecutor::ThreadPoolExecutor(const int &threadNumber):
+  queues_((threadNumber > 0) ? threadNumber
+    : max(1U, thread::hardware_concurrency())){
+
+  threadNumber_ = queues_.size();
+  stop_ = false;
+  queuedTasks_ = 0;
+
+  for(int i = 0; i < threadNumber_ - 1; i++)
+    workers_.emplace_back(&ThreadPoolExecutor::work, this, i);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor(){
+
+  {
+    lock_guard<mutex> lock(sleepLock_);
+    stop_ = true;
+  }
+  wakeUp_.notify_all();
+
+  for(auto &w : workers_)
+    w.join();
+
+  for(auto &q : queues_){
+    for(Task *t : q.tasks_)
+      delete t;
+  }
+}
+
+void ThreadPoolExecutor::run(const function<void()> &root,
+  const int &threadNumber){
+
+  // the calling thread is the last one of the pool
+  const bool caller = (currentPool_ != this);
+  if(caller)
+    pinThread(threadNumber_ - 1);
+
+  root();
+  wait();
+
+  if(caller)
+    unpinThread();
+}
+
+void ThreadPoolExecutor::spawn(const function<void()> &task){
+
+  Task *t = new Task;
+  t->run_ = task;
+  t->parent_ = &getChildren();
+  t->parent_->fetch_add(1);
+
+  TaskQueue &q = (currentPool_ == this) ? queues_[currentQueue_]
+    : queues_.back();
+  {
+    lock_guard<mutex> lock(q.lock_);
+    q.tasks_.push_back(t);
+    queuedTasks_++;
+  }
+  notify();
+}
+
+void ThreadPoolExecutor::wait(){
+
+  atomic<int> &children = getChildren();
+  while(children.load()){
+    if(!runPending())
+      this_thread::yield();
+  }
+}
+
+void ThreadPoolExecutor::notify(){
+
+  if(workers_.empty())
+    return;
+
+  // the lock orders this notification after the check of a sleeping worker
+  { lock_guard<mutex> lock(sleepLock_); }
+  wakeUp_.notify_one();
+}
+
+bool ThreadPoolExecutor::runPending(){
+
+  if(!queuedTasks_.load())
+    return false;
+
+  const int self = (currentPool_ == this) ? currentQueue_
+    : queues_.size() - 1;
+  Task *task = NULL;
+
+  // own queue first (most recent task), then steal the oldest ones
+  for(size_t i = 0; i < queues_.size() && !task; i++){
+    TaskQueue &q = queues_[(self + i) % queues_.size()];
+    lock_guard<mutex> lock(q.lock_);
+    if(q.tasks_.empty())
+      continue;
+    if(!i){
+      task = q.tasks_.back();
+      q.tasks_.pop_back();
+    }
+    else{
+      task = q.tasks_.front();
+      q.tasks_.pop_front();
+    }
+    queuedTasks_--;
+  }
+
+  if(!task)
+    return false;
+
+  execute(task);
+  return true;
+}
+
+void ThreadPoolExecutor::execute(Task *task){
+
+  atomic<int> children(0);
+  atomic<int> *previous = currentChildren_;
+  currentChildren_ = &children;
+
+  task->run_();
+  wait();
+
+  currentChildren_ = previous;
+  task->parent_->fetch_sub(1);
+  delete task;
+}
+
+void ThreadPoolExecutor::work(const int &queueId){
+
+  currentPool_ = this;
+  currentQueue_ = queueId;
+  int affinityVersion = -1;
+
+  while(true){
+    if(affinityVersion != affinityVersion_.load()){
+      affinityVersion = affinityVersion_.load();
+      pinThread(queueId);
+    }
+
+    if(runPending())
+      continue;
+
+    unique_lock<mutex> lock(sleepLock_);
+    wakeUp_.wait(lock, [this](){
+      return stop_.load() || queuedTasks_.load() > 0;
+    });
+    if(stop_)
+      return;
+  }
+}
+
+// ExternalExecutor
+ExternalExecutor::~ExternalExecutor(){
+
+  // the submitted functions use this executor
+  while(submitted_.load())
+    this_thread::yield();
+}
+
+void ExternalExecutor::notify(){
+
+  submitted_++;
+  submit_([this](){
+    runPending();
+    submitted_--;
+  });
+}
@@ -0,0 +1,265 @@
+/// \ingroup baseCode
+/// \class wtfit::Executor
+/// \date October 2016.
+///
+/// \brief Threading backend of the parallel loops and task graphs.
+///
+/// %Executor runs the parallel loops and the tasks of the baseCode packages
+/// (parallel for, task spawn and wait) so that the library can share the
+/// threads of its host application instead of creating its own teams:
+///   - OpenMPExecutor: OpenMP teams and tasks (default),
+///   - ThreadPoolExecutor: persistent work-stealing pool,
+///   - ExternalExecutor: tasks submitted to a pool of the host application.
+///
+/// A task waits for its own children only (wait()), and the waiting thread
+/// runs pending tasks meanwhile. A task also waits for its children before
+/// completing.
+///
+/// The threads can be pinned to cores (setAffinity()), the tasks spawned by
+/// a task then run on the same pinned threads.
+/// \sa Debug::setExecutor()
+
+#ifndef                 _EXECUTOR_H
+#define                 _EXECUTOR_H
+
+#include                <atomic>
+#include                <condition_variable>
+#include                <deque>
+#include                <functional>
+#include                <mutex>
+#include                <string>
+#include                <thread>
+#include                <vector>
+
+#ifdef withOpenMP
+#include                <omp.h>
+#endif
+
+namespace wtfit{
+
+  class Executor{
+
+    public:
+
+      Executor(){
+        affinityVersion_ = 0;
+      };
+
+      virtual ~Executor(){};
+
+      /// Number of threads running the tasks.
+      virtual int getThreadNumber() const = 0;
+
+      /// Run root, which can spawn tasks, with at most threadNumber threads
+      /// (0: getThreadNumber()). Returns when root and its tasks are done.
+      virtual void run(const std::function<void()> &root,
+        const int &threadNumber = 0) = 0;
+
+      /// Spawn a child task of the calling task.
+      virtual void spawn(const std::function<void()> &task) = 0;
+
+      /// Wait for the child tasks spawned by the calling task.
+      virtual void wait() = 0;
+
+      /// Call block(first, last) on blocks of grain indices covering
+      /// [begin, end) (0: a few blocks per thread).
+      virtual void parallelBlocks(const long &begin, const long &end,
+        const std::function<void(const long &, const long &)> &block,
+        const int &threadNumber = 0, long grain = 0);
+
+      /// Call body(i) for i in [begin, end).
+      template <class loopBody>
+        inline void parallelFor(const long &begin, const long &end,
+          const loopBody &body, const int &threadNumber = 0,
+          const long &grain = 0){
+
+        parallelBlocks(begin, end, [&body](const long &first,
+          const long &last){
+          for(long i = first; i < last; i++)
+            body(i);
+        }, threadNumber, grain);
+      }
+
+      /// Call chunk(c, first, last) for chunkNumber contiguous chunks of
+      /// [begin, end): c indexes the storage that a loop used to index with
+      /// the thread number.
+      template <class chunkBody>
+        inline void parallelChunks(const int &chunkNumber, const long &begin,
+          const long &end, const chunkBody &chunk){
+
+        const long size = end - begin;
+        parallelBlocks(0, chunkNumber, [&](const long &first,
+          const long &last){
+          for(long c = first; c < last; c++)
+            chunk(c, begin + (c*size)/chunkNumber,
+              begin + ((c + 1)*size)/chunkNumber);
+        }, chunkNumber, 1);
+      }
+
+      /// Pin the thread t of the teams to the core cores[t % cores.size()]
+      /// while it runs tasks (empty: no pinning). The OpenMP team threads
+      /// and the calling thread of run() get their previous cores back on
+      /// return.
+      virtual void setAffinity(const std::vector<int> &cores);
+
+      std::vector<int> getAffinity() const;
+
+      /// Cores of an affinity policy: "compact" (the cores of a NUMA node
+      /// first), "scatter" (alternating the NUMA nodes) or an explicit list
+      /// such as "0,2,4-7". Only the cores allowed to the calling thread are
+      /// used by the policies.
+      static std::vector<int> getAffinityCores(const std::string &policy);
+
+    protected:
+
+      /// Pin the calling thread, thread t of its team.
+      void pinThread(const int &t);
+
+      /// Give its cores before pinThread() back to the calling thread.
+      static void unpinThread();
+
+      mutable std::mutex        affinityLock_;
+      std::atomic<int>          affinityVersion_;
+      std::vector<int>          affinity_;
+  };
+
+  /// Pins the threads of an executor during its lifetime, then restores the
+  /// previous affinity (no effect with no cores).
+  class ExecutorAffinity{
+
+    public:
+
+      ExecutorAffinity(Executor *executor, const std::vector<int> &cores){
+        executor_ = cores.empty() ? NULL : executor;
+        if(executor_){
+          previous_ = executor_->getAffinity();
+          executor_->setAffinity(cores);
+        }
+      };
+
+      ~ExecutorAffinity(){
+        if(executor_)
+          executor_->setAffinity(previous_);
+      };
+
+    protected:
+
+      Executor                  *executor_;
+      std::vector<int>          previous_;
+  };
+
+  class OpenMPExecutor : public Executor{
+
+    public:
+
+      /// threadNumber: default size of the teams (0: OpenMP default).
+      OpenMPExecutor(const int &threadNumber = 0){
+        threadNumber_ = threadNumber;
+      };
+
+      int getThreadNumber() const;
+
+      void run(const std::function<void()> &root,
+        const int &threadNumber = 0);
+
+      void spawn(const std::function<void()> &task);
+
+      void wait();
+
+      void parallelBlocks(const long &begin, const long &end,
+        const std::function<void(const long &, const long &)> &block,
+        const int &threadNumber = 0, long grain = 0);
+
+    protected:
+
+      int               threadNumber_;
+  };
+
+  class ThreadPoolExecutor : public Executor{
+
+    public:
+
+      /// threadNumber threads run the tasks: threadNumber - 1 persistent
+      /// workers and the thread calling run() or wait()
+      /// (0: number of cores). Each worker has its own task queue, idle
+      /// threads steal the oldest tasks of the other queues.
+      /// The threadNumber argument of run() and parallelBlocks() is ignored.
+      ThreadPoolExecutor(const int &threadNumber = 0);
+
+      ~ThreadPoolExecutor();
+
+      int getThreadNumber() const{
+        return threadNumber_;
+      }
+
+      void run(const std::function<void()> &root,
+        const int &threadNumber = 0);
+
+      void spawn(const std::function<void()> &task);
+
+      void wait();
+
+    protected:
+
+      struct Task{
+        std::function<void()>   run_;
+        std::atomic<int>        *parent_;
+      };
+
+      struct TaskQueue{
+        std::mutex              lock_;
+        std::deque<Task *>      tasks_;
+      };
+
+      /// Called after a task was queued.
+      virtual void notify();
+
+      /// Run one queued task, if any.
+      bool runPending();
+
+      /// Run a task, then wait for its children.
+      void execute(Task *task);
+
+      void work(const int &queueId);
+
+      int                       threadNumber_;
+      std::atomic<bool>         stop_;
+      std::atomic<long>         queuedTasks_;
+      std::mutex                sleepLock_;
+      std::condition_variable   wakeUp_;
+      std::vector<std::thread>  workers_;
+      // one queue per worker, the last one for the other threads
+      std::vector<TaskQueue>    queues_;
+  };
+
+  class ExternalExecutor : public ThreadPoolExecutor{
+
+    public:
+
+      /// The tasks are run by a pool of the host application: submit(f) must
+      /// eventually call f() on one of its threadNumber threads.
+      /// The destructor waits for the submitted functions.
+      ExternalExecutor(const std::function<void(
+        const std::function<void()> &)> &submit, const int &threadNumber):
+        ThreadPoolExecutor(1){
+        submit_ = submit;
+        submitted_ = 0;
+        threadNumber_ = threadNumber;
+      };
+
+      ~ExternalExecutor();
+
+      /// The threads belong to the host application: no pinning.
+      void setAffinity(const std::vector<int> &cores){};
+
+    protected:
+
+      void notify();
+
+      std::function<void(const std::function<void()> &)>
+                                submit_;
+      std::atomic<long>         submitted_;
+  };
+}
+
+#endif // _EXECUTOR_H
@@ -0,0 +1,67 @@
+/// \ingroup baseCode
+/// \class wtfit::Hash
+/// \date October 2016.
+///
+/// \brief Fast (non cryptographic) hash of memory buffers, used to key the
+/// on-disk caches.
+
+#ifndef                 _HASH_H
+#define                 _HASH_H
+
+#include                <cstdint>
+#include                <cstring>
+#include                <vector>
+
+#ifdef withOpenMP
+#include                <omp.h>
+#endif
+
+namespace wtfit{
+
+  class Hash{
+
+    public:
+
+      inline static uint64_t mix(uint64_t h, const uint64_t &w){
+        h ^= w*0x87c37b91114253d5ull;
+        h = (h << 31) | (h >> 33);
+        return h*0x4cf5ad432745937full + 0x52dce729ull;
+      }
+
+      /// Hash size bytes of data, starting from seed.
+      /// Chunks are hashed in parallel and combined in order: the result does
+      /// not depend on the number of threads.
+      inline static uint64_t buffer(const void *data, const size_t &size,
+        uint64_t seed = 0){
+
+        const char          *bytes = (const char *) data;
+        const size_t        chunkSize = 1 << 20;
+        const size_t        chunkNumber = (size + chunkSize - 1)/chunkSize;
+        std::vector<uint64_t> chunkHash(chunkNumber);
+
+#ifdef withOpenMP
+#pragma omp parallel for schedule(static)
+#endif
+        for(size_t c = 0; c < chunkNumber; c++){
+          const char *chunk = bytes + c*chunkSize;
+          const size_t end = std::min(chunkSize, size - c*chunkSize);
+          uint64_t h = c, w;
+          size_t i = 0;
+          for(; i + 8 <= end; i += 8){
+            memcpy(&w, chunk + i, 8);
+            h = mix(h, w);
+          }
+          w = 0;
+          memcpy(&w, chunk + i, end - i);
+          chunkHash[c] = mix(h, w);
+        }
+
+        for(size_t c = 0; c < chunkNumber; c++)
+          seed = mix(seed, chunkHash[c]);
+
+        return mix(seed, size);
+      }
+  };
+}
+
+#endif // _HASH_H
@@ -12,6 +12,7 @@
 
 #include                <algorithm>
 #include                <sstream>
+#include                <tuple>
 
 #include                <Debug.h>
 
@@ -44,6 +45,10 @@
 #include                <unistd.h>
 #endif
 
+#ifdef __linux__
+#include                <sched.h>
+#endif
+
 #ifdef __APPLE__
 #include                <climits>
 #include                <cfloat>
@@ -131,6 +136,84 @@ namespace wtfit{
         return 1;
       }
       
+      /// NUMA node of each logical core, read from /sys/devices/system/node
+      /// under Linux (empty otherwise: a single node).
+      inline static const vector<int> &getCoreNumaNodes(){
+        static const vector<int> coreNodes = readCoreNumaNodes();
+        return coreNodes;
+      }
+      
+      inline static int getNumberOfNumaNodes(){
+        const vector<int> &coreNodes = getCoreNumaNodes();
+        if(coreNodes.empty())
+          return 1;
+        return *max_element(coreNodes.begin(), coreNodes.end()) + 1;
+      }
+      
+      /// NUMA node of the core running the calling thread.
+      inline static int getCurrentNumaNode(){
+        #ifdef __linux__
+          const int core = sched_getcpu();
+          const vector<int> &coreNodes = getCoreNumaNodes();
+          if((core >= 0)&&(core < (int) coreNodes.size()))
+            return coreNodes[core];
+        #endif
+        return 0;
+      }
+      
+      /// Cores of a list of cores and ranges, such as 0,2,4-7 (in this
+      /// order).
+      inline static vector<int> parseCoreList(const string &list){
+        
+        vector<int> cores;
+        stringstream listStream(list);
+        string range;
+        while(getline(listStream, range, ',')){
+          stringstream rangeStream(range);
+          int first, last;
+          char dash;
+          if(!(rangeStream >> first))
+            continue;
+          if(!(rangeStream >> dash >> last))
+            last = first;
+          for(int core = max(first, 0); core <= last; core++)
+            cores.push_back(core);
+        }
+        return cores;
+      }
+      
+      /// Cores the calling thread can run on (empty if unknown).
+      inline static vector<int> getThreadAffinity(){
+        
+        vector<int> cores;
+        #ifdef __linux__
+          cpu_set_t mask;
+          CPU_ZERO(&mask);
+          if(!sched_getaffinity(0, sizeof(mask), &mask)){
+            for(int core = 0; core < CPU_SETSIZE; core++){
+              if(CPU_ISSET(core, &mask))
+                cores.push_back(core);
+            }
+          }
+        #endif
+        return cores;
+      }
+      
+      /// Restrict the calling thread to the given cores (Linux only).
+      inline static int setThreadAffinity(const vector<int> &cores){
+        
+        #ifdef __linux__
+          cpu_set_t mask;
+          CPU_ZERO(&mask);
+          for(const int &core : cores){
+            if((core >= 0)&&(core < CPU_SETSIZE))
+              CPU_SET(core, &mask);
+          }
+          return sched_setaffinity(0, sizeof(mask), &mask);
+        #endif
+        return -1;
+      }
+      
       inline static double getTimeStamp(){
         #ifdef _WIN32
           LARGE_INTEGER frequency;
@@ -300,6 +383,50 @@ namespace wtfit{
         return system(cmd.str().data());
       }
       
+      /// Mark a file as just used (modification time set to now).
+      inline static int touchFile(const string &fileName){
+        #ifdef _WIN32
+          return -1;
+        #else
+          return utimes(fileName.data(), NULL);
+        #endif
+      }
+      
+      /// Remove the least recently used files of directoryName whose name
+      /// starts with one of the prefixes until they use at most maxSize
+      /// bytes. Returns the number of removed files.
+      inline static int trimDirectory(const string &directoryName,
+        const vector<string> &prefixes, const size_t &maxSize){
+        
+        int removed = 0;
+        #ifndef _WIN32
+          // (modification time, size, path) of the matching files
+          vector<tuple<time_t, size_t, string> > files;
+          size_t size = 0;
+          for(const string &path : listFilesInDirectory(directoryName, "")){
+            const string name = path.substr(path.find_last_of('/') + 1);
+            bool match = false;
+            for(const string &prefix : prefixes)
+              match |= (name.compare(0, prefix.size(), prefix) == 0);
+            struct stat fileStat;
+            if((!match)||(stat(path.data(), &fileStat))
+              ||(!S_ISREG(fileStat.st_mode)))
+              continue;
+            files.emplace_back(fileStat.st_mtime, fileStat.st_size, path);
+            size += fileStat.st_size;
+          }
+          
+          sort(files.begin(), files.end());
+          for(size_t i = 0; (i < files.size())&&(size > maxSize); i++){
+            if(!unlink(get<2>(files[i]).data())){
+              size -= get<1>(files[i]);
+              removed++;
+            }
+          }
+        #endif
+        return removed;
+      }
+      
       int static roundToNearestInt(const double &val){
         
         const double upperBound = ceil(val);
@@ -316,6 +443,29 @@ namespace wtfit{
       
     protected:
       
+      // cpulist of each node
+      inline static vector<int> readCoreNumaNodes(){
+        
+        vector<int> coreNodes;
+        #ifdef __linux__
+          for(int node = 0; node < 256; node++){
+            stringstream fileName;
+            fileName << "/sys/devices/system/node/node" << node << "/cpulist";
+            ifstream file(fileName.str().data(), ios::in);
+            if(!file)
+              continue;
+            
+            string list;
+            getline(file, list);
+            for(const int &core : parseCoreList(list)){
+              if(core >= (int) coreNodes.size())
+                coreNodes.resize(core + 1, 0);
+              coreNodes[core] = node;
+            }
+          }
+        #endif
+        return coreNodes;
+      }
       
     private:
       
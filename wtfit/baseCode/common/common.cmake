@@ -1 +1,2 @@
-wtfit_wrapup_library(libDebug "Debug.cpp")
\ No newline at end of file
+wtfit_wrapup_library(libDebug "Debug.cpp")
+wtfit_wrapup_library(libExecutor "Executor.cpp")
@@ -0,0 +1,234 @@
+/*
+ * file:                  DistributedContourTree.cpp
+ * description:           DistributedContourTree processing package.
+ * author:                Gueunet Charles
+ * date:                  Octobre 2016
+ */
+
+#ifdef withMPI
+
+#include <DistributedContourTree.h>
+
+#include <cstring>
+
+DistributedContourTree::DistributedContourTree(MPI_Comm comm)
+    : comm_(comm),
+      rank_(0),
+      size_(1),
+      nbThread_(1),
+      nbPartitions_(0),
+      mesh_(nullptr),
+      nbGlobalVertices_(0)
+{
+   MPI_Comm_rank(comm_, &rank_);
+   MPI_Comm_size(comm_, &size_);
+}
+
+// Block
+// {
+
+void DistributedContourTree::getSlab(const int dims[3], const int rank, const int size,
+                                     int &axis, int &first, int &last)
+{
+   // slabs along the last dimension of the grid
+   axis = 2;
+   while (axis > 0 && dims[axis] <= 1) {
+      --axis;
+   }
+
+   first = ((idGlobal)dims[axis] * rank) / size;
+   last  = ((idGlobal)dims[axis] * (rank + 1)) / size;
+}
+
+int DistributedContourTree::setGrid(const int dims[3])
+{
+   int axis, first, last;
+   getSlab(dims, rank_, size_, axis, first, last);
+
+   idGlobal slice = 1;
+   for (int d = 0; d < axis; ++d) {
+      slice *= dims[d];
+   }
+
+   const int nbSlices = last - first;
+   if (nbSlices < 2) {
+      err("[DistributedContourTree] the grid has less than 2 slices per rank\n", fatalMsg);
+      return -1;
+   }
+
+   int blockDims[3] = {dims[0], dims[1], dims[2]};
+   blockDims[axis]  = nbSlices;
+   gridBlock_.setInputGrid(0, 0, 0, 1, 1, 1, blockDims[0], blockDims[1], blockDims[2]);
+   gridBlock_.preprocessEdges();
+   gridBlock_.preprocessVertexNeighbors();
+   mesh_ = &gridBlock_;
+
+   const idVertex nbVertices = gridBlock_.getNumberOfVertices();
+   const idGlobal offset     = first * slice;
+   globalIds_.resize(nbVertices);
+   for (idVertex v = 0; v < nbVertices; ++v) {
+      globalIds_[v] = offset + v;
+   }
+
+   // edges between two consecutive slices: the grid is invariant by
+   // translation, the ones of a grid of 2 slices are the same everywhere
+   int stencilDims[3] = {dims[0], dims[1], dims[2]};
+   stencilDims[axis]  = 2;
+   Triangulation stencilGrid;
+   stencilGrid.setInputGrid(0, 0, 0, 1, 1, 1, stencilDims[0], stencilDims[1], stencilDims[2]);
+   stencilGrid.preprocessVertexNeighbors();
+
+   crossEdges_.clear();
+   for (idVertex a = 0; a < slice; ++a) {
+      const idVertex nbNeighbors = stencilGrid.getVertexNeighborNumber(a);
+      for (idVertex n = 0; n < nbNeighbors; ++n) {
+         idVertex b;
+         stencilGrid.getVertexNeighbor(a, n, b);
+         if (b < slice) {
+            continue;
+         }
+         b -= slice;
+
+         // a in the last slice of the previous rank, b in our first one
+         if (first > 0) {
+            crossEdges_.emplace_back(b, offset - slice + a);
+         }
+         // a in our last slice, b in the first one of the next rank
+         if (last < dims[axis]) {
+            crossEdges_.emplace_back((nbSlices - 1) * slice + a, offset + nbSlices * slice + b);
+         }
+      }
+   }
+
+   return 0;
+}
+
+int DistributedContourTree::setBlock(Triangulation *mesh, const vector<idGlobal> &globalIds,
+                                     const vector<pair<idVertex, idGlobal>> &crossEdges)
+{
+#ifndef withKamikaze
+   if (!mesh || (idVertex)globalIds.size() != mesh->getNumberOfVertices()) {
+      err("[DistributedContourTree] one global id is needed per vertex of the block\n", fatalMsg);
+      return -1;
+   }
+#endif
+
+   mesh_       = mesh;
+   globalIds_  = globalIds;
+   crossEdges_ = crossEdges;
+
+   return 0;
+}
+
+// }
+// Output
+// {
+
+// Records of the tree file, see DistributedContourTree.h for the layout.
+
+static const char     distributedTreeMagic[8] = {'W', 'T', 'F', 'I', 'T', 'D', 'T', '\0'};
+static const uint32_t distributedTreeVersion  = 1;
+
+struct DistributedTreeHeader {
+   char     magic[8];
+   uint32_t version;
+   uint32_t padding;
+   uint64_t nbVertices;
+   uint64_t nbNodes;
+   uint64_t nbArcs;
+};
+
+static_assert(sizeof(DistributedTreeHeader) == 40, "DistributedTreeHeader is not packed");
+
+static inline bool distributedTreeLittleEndian(void)
+{
+   const uint16_t one = 1;
+   return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+int DistributedContourTree::writeTree(const string &fileName) const
+{
+   if (!distributedTreeLittleEndian()) {
+      err("[DistributedContourTree] trees are only written on little-endian hosts\n", fatalMsg);
+      return -1;
+   }
+
+   DebugTimer timer;
+
+   MPI_File file;
+   if (MPI_File_open(comm_, const_cast<char *>(fileName.c_str()),
+                     MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+      err("[DistributedContourTree] cannot open " + fileName + "\n", fatalMsg);
+      return -1;
+   }
+   MPI_File_set_size(file, 0);
+
+   // the tree is known by the rank 0 only
+   uint64_t sizes[2] = {nodeVertices_.size(), arcs_.size()};
+   MPI_Bcast(sizes, 2, MPI_UINT64_T, 0, comm_);
+
+   const MPI_Offset nodesOffset     = sizeof(DistributedTreeHeader);
+   const MPI_Offset arcsOffset      = nodesOffset + sizes[0] * sizeof(int64_t);
+   const MPI_Offset vert2treeOffset = (arcsOffset + sizes[1] * 2 * sizeof(uint32_t) + 7) & ~7;
+
+   int failed = 0;
+   if (!rank_) {
+      DistributedTreeHeader header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, distributedTreeMagic, sizeof(header.magic));
+      header.version    = distributedTreeVersion;
+      header.nbVertices = nbGlobalVertices_;
+      header.nbNodes    = sizes[0];
+      header.nbArcs     = sizes[1];
+
+      vector<int64_t> nodes(nodeVertices_.begin(), nodeVertices_.end());
+      vector<uint32_t> arcs;
+      arcs.reserve(2 * sizes[1]);
+      for (const auto &arc : arcs_) {
+         arcs.emplace_back(arc.first);
+         arcs.emplace_back(arc.second);
+      }
+
+      failed |= MPI_File_write_at(file, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+      failed |= MPI_File_write_at(file, nodesOffset, nodes.data(), nodes.size(), MPI_INT64_T,
+                                  MPI_STATUS_IGNORE);
+      failed |= MPI_File_write_at(file, arcsOffset, arcs.data(), arcs.size(), MPI_UINT32_T,
+                                  MPI_STATUS_IGNORE);
+   }
+
+   // each rank writes its runs of consecutive global ids
+   const vector<int64_t> codes(vert2tree_.begin(), vert2tree_.end());
+   const size_t          nbVertices = globalIds_.size();
+   for (size_t begin = 0; begin < nbVertices;) {
+      size_t end = begin + 1;
+      while (end < nbVertices && globalIds_[end] == globalIds_[end - 1] + 1) {
+         ++end;
+      }
+      failed |= MPI_File_write_at(file, vert2treeOffset + globalIds_[begin] * sizeof(int64_t),
+                                  codes.data() + begin, end - begin, MPI_INT64_T,
+                                  MPI_STATUS_IGNORE);
+      begin = end;
+   }
+
+   MPI_File_close(&file);
+
+   int anyFailed = 0;
+   MPI_Allreduce(&failed, &anyFailed, 1, MPI_INT, MPI_LOR, comm_);
+   if (anyFailed) {
+      err("[DistributedContourTree] cannot write " + fileName + "\n", fatalMsg);
+      return -1;
+   }
+
+   if (!rank_) {
+      stringstream msg;
+      msg << "[DistributedContourTree] tree written in " << fileName << " in "
+          << timer.getElapsedTime() << " s" << endl;
+      dMsg(cout, msg.str(), timeMsg);
+   }
+
+   return 0;
+}
+
+// }
+
+#endif // withMPI
@@ -0,0 +1,172 @@
+/*
+ * file:                  DistributedContourTree.h
+ * description:           DistributedContourTree processing package.
+ * author:                Gueunet Charles
+ * date:                  Octobre 2016
+ */
+
+///\ingroup baseCode
+///\class wtfit::DistributedContourTree
+///\brief %DistributedContourTree processing package.
+///
+///%DistributedContourTree computes the contour tree of a scalar field
+/// distributed over MPI processes: each rank owns a block of the vertices.
+///
+/// Each rank computes the contour tree of its block with the partition
+/// pipeline of ParallelContourTree, and sends to the rank 0 only its reduced
+/// tree: the critical points and the boundary vertices, linked by the chains
+/// of the local arcs, and the edges crossing the blocks. The rank 0 computes
+/// the contour tree of this graph, which is the global tree, then each rank
+/// places its regular vertices on the global arcs.
+///
+/// Vertices are compared by value then by global id, which gives the same
+/// tree as the shared-memory path when the global ids are the vertex ids.
+///\sa ParallelContourTree
+
+#ifndef _DISTRIBUTEDCONTOURTREE_H
+#define _DISTRIBUTEDCONTOURTREE_H
+
+#ifdef withMPI
+
+#include <ParallelContourTree.h>
+
+#include <mpi.h>
+#include <numeric>
+
+namespace wtfit
+{
+   /// \brief vertex index in the whole distributed domain
+   using idGlobal = long long int;
+
+   class DistributedContourTree : public Debug
+   {
+     public:
+      DistributedContourTree(MPI_Comm comm = MPI_COMM_WORLD);
+
+      // -----------------
+      // Getter & Setter
+      // -----------------
+      // {
+
+      // Threads of the local trees
+      inline void setNbThread(const numThread nbThread)
+      {
+         nbThread_ = nbThread;
+      }
+
+      // Partitions of the local trees (0: one per thread)
+      inline void setNbPartitions(const unsigned nbPartitions)
+      {
+         nbPartitions_ = nbPartitions;
+      }
+
+      inline const int &getRank(void) const
+      {
+         return rank_;
+      }
+
+      inline const int &getSize(void) const
+      {
+         return size_;
+      }
+
+      /// \brief split a grid of dims vertices in one slab per rank along its
+      /// last dimension (vertex ids of vtkImageData).
+      int setGrid(const int dims[3]);
+
+      /// \brief slices [first, last) along axis of the slab of rank among
+      /// size ranks (see setGrid), without communication
+      static void getSlab(const int dims[3], const int rank, const int size, int &axis,
+                          int &first, int &last);
+
+      /// \brief block of this rank: the mesh of its vertices (edges and
+      /// vertex neighbors preprocessed), their global ids, in increasing order,
+      /// and the edges crossing to another rank (local vertex, global id of
+      /// the other end).
+      int setBlock(Triangulation *mesh, const vector<idGlobal> &globalIds,
+                   const vector<pair<idVertex, idGlobal>> &crossEdges);
+
+      inline const vector<idGlobal> &getGlobalIds(void) const
+      {
+         return globalIds_;
+      }
+
+      inline const idGlobal &getNumberOfGlobalVertices(void) const
+      {
+         return nbGlobalVertices_;
+      }
+
+      /// \brief for each vertex of the block: arc of the global tree,
+      /// or -1 - node (see MergeTree vert2tree).
+      inline const vector<idCorresp> &getVert2Tree(void) const
+      {
+         return vert2tree_;
+      }
+
+      // }
+      // -----------------
+      // Build
+      // -----------------
+      // {
+
+      /// \brief compute the global contour tree, blockScalars being the
+      /// values of the vertices of this rank (collective)
+      template <typename scalarType>
+      int build(const scalarType *blockScalars);
+
+      // }
+      // -----------------
+      // Output
+      // -----------------
+      // {
+
+      // Little-endian, written by all the ranks with MPI-IO:
+      // header | nodes (global vertex id, int64) | arcs (down and up nodes,
+      // uint32 each) | vert2tree of each global vertex (int64)
+
+      /// \brief write the global tree and the vert2tree of all the ranks in
+      /// fileName (collective)
+      int writeTree(const string &fileName) const;
+
+      // }
+
+     protected:
+      // Rank 0: monotone path of arcs of tree between the vertices x < y
+      template <typename scalarType>
+      int getPath(ParallelContourTree &tree, const scalarType *scalars,
+                  const idVertex &x, const idVertex &y, vector<idSuperArc> &path) const;
+
+      // Rank 0 receives the local vectors of all the ranks, with their offsets
+      template <typename type>
+      int gather(const vector<type> &local, vector<type> &all, vector<int> &offsets) const;
+
+      // Each rank receives its part of the vectors of the rank 0
+      template <typename type>
+      int scatter(const vector<vector<type>> &parts, vector<type> &local) const;
+
+      MPI_Comm comm_;
+      int      rank_, size_;
+
+      numThread nbThread_;
+      unsigned  nbPartitions_;
+
+      // block of this rank
+      Triangulation                      *mesh_;
+      Triangulation                      gridBlock_;
+      vector<idGlobal>                   globalIds_;
+      vector<pair<idVertex, idGlobal>>   crossEdges_;
+      idGlobal                           nbGlobalVertices_;
+
+      // result: vert2tree of the block, nodes and arcs of the global tree
+      // (rank 0 only)
+      vector<idCorresp>                  vert2tree_;
+      vector<idGlobal>                   nodeVertices_;
+      vector<pair<idNode, idNode>>       arcs_;
+   };
+
+#include <DistributedContourTreeTemplate.h>
+}
+
+#endif // withMPI
+
+#endif // _DISTRIBUTEDCONTOURTREE_H
@@ -0,0 +1,438 @@
+/**
+ * @file DistributedContourTreeTemplate.h
+ * @brief Template function for distributed contour tree processing
+ * @author Gueunet Charles
+ * @version 1
+ * @date 2016-10-20
+ */
+
+#ifndef DISTRIBUTEDCONTOURTREETEMPLATE_H
+#define DISTRIBUTEDCONTOURTREETEMPLATE_H
+
+#include <DistributedContourTree.h>
+
+// Build
+// {
+
+template <typename scalarType>
+int DistributedContourTree::build(const scalarType *blockScalars)
+{
+   if (!mesh_) {
+      err("[DistributedContourTree] no block, call setGrid() or setBlock()\n", fatalMsg);
+      return -1;
+   }
+
+   DebugTimer timerTotal;
+
+   const idVertex nbVertices = mesh_->getNumberOfVertices();
+   const idGlobal nbLocal    = nbVertices;
+   MPI_Allreduce(&nbLocal, &nbGlobalVertices_, 1, MPI_LONG_LONG, MPI_SUM, comm_);
+
+   // -----------------
+   // Local tree
+   // -----------------
+   // {
+
+   DebugTimer timerLocal;
+
+   ParallelContourTree local(nbThread_);
+   local.setDebugLevel(debugLevel_);
+   if (executor_) {
+      local.setExecutor(executor_);
+   }
+   local.setTriangulation(mesh_);
+   local.setVertexScalars((scalarType *)blockScalars);
+   local.setNbPartitions(nbPartitions_);
+   local.build<scalarType>(true, true, 0);
+
+   // }
+   // -----------------
+   // Reduced tree
+   // -----------------
+   // {
+
+   // kept vertices: nodes of the local tree and boundary vertices
+   vector<char> kept(nbVertices, 0);
+   for (const auto &e : crossEdges_) {
+      kept[e.first] = 1;
+   }
+   for (idVertex v = 0; v < nbVertices; ++v) {
+      if (local.isCorrespondingNode(v)) {
+         kept[v] = 1;
+      }
+   }
+
+   // regular vertices of each arc, in increasing order
+   const idSuperArc nbLocalArcs = local.getNumberOfSuperArcs();
+   vector<idVertex> arcOffsets(nbLocalArcs + 1, 0);
+   for (idVertex v = 0; v < nbVertices; ++v) {
+      if (!local.isCorrespondingNode(v)) {
+         const idSuperArc a = local.getCorrespondingSuperArcId(v);
+#ifndef withKamikaze
+         // the stitching covers every vertex, whatever the number of partitions
+         if (a >= nbLocalArcs || !local.getSuperArc(a)->isVisible()) {
+            stringstream msg;
+            msg << "[DistributedContourTree] rank " << rank_ << ": vertex " << v
+                << " is not on the local tree" << endl;
+            err(msg.str(), fatalMsg);
+            MPI_Abort(comm_, -1);
+            return -1;
+         }
+#endif
+         ++arcOffsets[a + 1];
+      }
+   }
+   partial_sum(arcOffsets.begin(), arcOffsets.end(), arcOffsets.begin());
+
+   vector<idVertex> arcVertices(arcOffsets.back());
+   vector<idVertex> arcFill(arcOffsets.begin(), arcOffsets.end() - 1);
+   for (const idVertex &v : local.getSortedVertices()) {
+      if (!local.isCorrespondingNode(v)) {
+         arcVertices[arcFill[local.getCorrespondingSuperArcId(v)]++] = v;
+      }
+   }
+
+   // chains of the arcs between consecutive kept vertices, the regular
+   // vertices remember the chain they lie on
+   vector<pair<idGlobal, idGlobal>> chains;
+   vector<idVertex>                 chainOf(nbVertices, -1);
+   for (idSuperArc a = 0; a < nbLocalArcs; ++a) {
+      SuperArc *arc = local.getSuperArc(a);
+      if (!arc->isVisible()) {
+         continue;
+      }
+
+      idVertex lower = local.getNode(arc->getDownNodeId())->getVertexId();
+      for (idVertex i = arcOffsets[a]; i < arcOffsets[a + 1]; ++i) {
+         const idVertex &v = arcVertices[i];
+         if (kept[v]) {
+            chains.emplace_back(globalIds_[lower], globalIds_[v]);
+            lower = v;
+         } else {
+            chainOf[v] = chains.size();
+         }
+      }
+      const idVertex upper = local.getNode(arc->getUpNodeId())->getVertexId();
+      chains.emplace_back(globalIds_[lower], globalIds_[upper]);
+   }
+
+   vector<idGlobal>   keptIds;
+   vector<scalarType> keptScalars;
+   for (idVertex v = 0; v < nbVertices; ++v) {
+      if (kept[v]) {
+         keptIds.emplace_back(globalIds_[v]);
+         keptScalars.emplace_back(blockScalars[v]);
+      }
+   }
+
+   // each crossing edge is sent once, by the owner of its lower global id
+   vector<pair<idGlobal, idGlobal>> crossing;
+   for (const auto &e : crossEdges_) {
+      if (globalIds_[e.first] < e.second) {
+         crossing.emplace_back(globalIds_[e.first], e.second);
+      }
+   }
+
+   {
+      stringstream msg;
+      msg << "[DistributedContourTree] rank " << rank_ << ": " << nbVertices << " vertices, "
+          << keptIds.size() << " kept, " << chains.size() << " chains, " << crossing.size()
+          << " crossing edges in " << timerLocal.getElapsedTime() << " s" << endl;
+      dMsg(cout, msg.str(), advancedInfoMsg);
+   }
+
+   // }
+   // -----------------
+   // Global tree
+   // -----------------
+   // {
+
+   DebugTimer timerGlobal;
+
+   vector<idGlobal>                 allIds;
+   vector<scalarType>               allScalars;
+   vector<pair<idGlobal, idGlobal>> allChains, allCrossing;
+   vector<int>                      keptOffsets, chainOffsets, crossingOffsets;
+   gather(keptIds, allIds, keptOffsets);
+   gather(keptScalars, allScalars, keptOffsets);
+   gather(chains, allChains, chainOffsets);
+   gather(crossing, allCrossing, crossingOffsets);
+
+   // per rank: vert2tree of its kept vertices, and for each of its chains,
+   // the arcs of the global tree going from its lower to its upper vertex
+   // with their upper vertex
+   vector<vector<idCorresp>>  keptCodes(size_);
+   vector<vector<idVertex>>   pathOffsets(size_);
+   vector<vector<idCorresp>>  pathArcs(size_);
+   vector<vector<idGlobal>>   pathIds(size_);
+   vector<vector<scalarType>> pathScalars(size_);
+
+   if (!rank_) {
+      // the graph vertices follow the global ids, hence the same simulation
+      // of simplicity
+      const idVertex   nbKept = allIds.size();
+      vector<idVertex> order(nbKept);
+      iota(order.begin(), order.end(), 0);
+      sort(order.begin(), order.end(),
+           [&](const idVertex &a, const idVertex &b) { return allIds[a] < allIds[b]; });
+
+      vector<idGlobal>   graphIds(nbKept);
+      vector<scalarType> graphScalars(nbKept);
+      for (idVertex i = 0; i < nbKept; ++i) {
+         graphIds[i]     = allIds[order[i]];
+         graphScalars[i] = allScalars[order[i]];
+      }
+      auto graphId = [&](const idGlobal &g) {
+         return (idVertex)(lower_bound(graphIds.begin(), graphIds.end(), g) - graphIds.begin());
+      };
+
+      // chains and crossing edges as 1D cells
+      vector<long long int> cells;
+      cells.reserve(3 * (allChains.size() + allCrossing.size()));
+      for (const auto *edges : {&allChains, &allCrossing}) {
+         for (const auto &e : *edges) {
+            cells.emplace_back(2);
+            cells.emplace_back(graphId(e.first));
+            cells.emplace_back(graphId(e.second));
+         }
+      }
+      vector<float> points(3 * nbKept, 0);
+
+      Triangulation graph;
+      graph.setInputPoints(nbKept, points.data());
+      graph.setInputCells(cells.size() / 3, cells.data());
+      graph.preprocessEdges();
+      graph.preprocessVertexNeighbors();
+
+      // the isovalue partitions need a mesh: a single one on the graph
+      ParallelContourTree global(nbThread_);
+      global.setDebugLevel(debugLevel_);
+      if (executor_) {
+         global.setExecutor(executor_);
+      }
+      global.setTriangulation(&graph);
+      global.setVertexScalars(graphScalars.data());
+      global.setNbPartitions(1);
+      global.build<scalarType>(true, true, 0);
+
+      vector<idSuperArc> path;
+      for (int r = 0; r < size_; ++r) {
+         for (int i = keptOffsets[r]; i < keptOffsets[r + 1]; ++i) {
+            const idVertex v = graphId(allIds[i]);
+            keptCodes[r].emplace_back(global.isCorrespondingNode(v)
+                                          ? -(idCorresp)global.getCorrespondingNode(v) - 1
+                                          : (idCorresp)global.getCorrespondingSuperArcId(v));
+         }
+
+         pathOffsets[r].emplace_back(0);
+         for (int c = chainOffsets[r]; c < chainOffsets[r + 1]; ++c) {
+            if (getPath(global, graphScalars.data(), graphId(allChains[c].first),
+                        graphId(allChains[c].second), path)) {
+               err("[DistributedContourTree] no monotone path for a chain\n", fatalMsg);
+               MPI_Abort(comm_, -1);
+               return -1;
+            }
+            for (const idSuperArc &a : path) {
+               const idVertex upper =
+                   global.getNode(global.getSuperArc(a)->getUpNodeId())->getVertexId();
+               pathArcs[r].emplace_back(a);
+               pathIds[r].emplace_back(graphIds[upper]);
+               pathScalars[r].emplace_back(graphScalars[upper]);
+            }
+            pathOffsets[r].emplace_back(pathArcs[r].size());
+         }
+      }
+
+      const idNode nbNodes = global.getNumberOfNodes();
+      nodeVertices_.resize(nbNodes);
+      for (idNode n = 0; n < nbNodes; ++n) {
+         nodeVertices_[n] = graphIds[global.getNode(n)->getVertexId()];
+      }
+
+      const idSuperArc nbArcs = global.getNumberOfSuperArcs();
+      arcs_.resize(nbArcs);
+      for (idSuperArc a = 0; a < nbArcs; ++a) {
+         arcs_[a] = make_pair(global.getSuperArc(a)->getDownNodeId(),
+                              global.getSuperArc(a)->getUpNodeId());
+      }
+
+      stringstream msg;
+      msg << "[DistributedContourTree] global tree of " << nbKept << " vertices, "
+          << nbNodes << " nodes in " << timerGlobal.getElapsedTime() << " s" << endl;
+      dMsg(cout, msg.str(), timeMsg);
+   }
+
+   // }
+   // -----------------
+   // Regular vertices
+   // -----------------
+   // {
+
+   DebugTimer timerPlace;
+
+   vector<idCorresp>  codes, arcs;
+   vector<idVertex>   offsets;
+   vector<idGlobal>   upperIds;
+   vector<scalarType> upperScalars;
+   scatter(keptCodes, codes);
+   scatter(pathOffsets, offsets);
+   scatter(pathArcs, arcs);
+   scatter(pathIds, upperIds);
+   scatter(pathScalars, upperScalars);
+
+   // a regular vertex is on the first arc of its chain path ending above it
+   vert2tree_.resize(nbVertices);
+   idVertex keptId = 0;
+   for (idVertex v = 0; v < nbVertices; ++v) {
+      if (kept[v]) {
+         vert2tree_[v] = codes[keptId++];
+         continue;
+      }
+
+      const idVertex &c = chainOf[v];
+      for (idVertex p = offsets[c]; p < offsets[c + 1]; ++p) {
+         if (blockScalars[v] < upperScalars[p] ||
+             (blockScalars[v] == upperScalars[p] && globalIds_[v] < upperIds[p])) {
+            vert2tree_[v] = arcs[p];
+            break;
+         }
+      }
+   }
+
+   {
+      stringstream msg;
+      msg << "[DistributedContourTree] regular vertices placed in "
+          << timerPlace.getElapsedTime() << " s" << endl;
+      msg << "[DistributedContourTree] distributed tree computed in "
+          << timerTotal.getElapsedTime() << " s" << endl;
+      if (!rank_) {
+         dMsg(cout, msg.str(), timeMsg);
+      }
+   }
+
+   // }
+
+   return 0;
+}
+
+// }
+// Path
+// {
+
+template <typename scalarType>
+int DistributedContourTree::getPath(ParallelContourTree &tree, const scalarType *scalars,
+                                    const idVertex &x, const idVertex &y,
+                                    vector<idSuperArc> &path) const
+{
+   auto isLower = [&](const idVertex &a, const idVertex &b) {
+      return scalars[a] < scalars[b] || (scalars[a] == scalars[b] && a < b);
+   };
+   auto upVertex = [&](const idSuperArc &a) {
+      return tree.getNode(tree.getSuperArc(a)->getUpNodeId())->getVertexId();
+   };
+
+   const bool       yNode = tree.isCorrespondingNode(y);
+   const idSuperArc yArc  = (yNode) ? nullSuperArc : tree.getCorrespondingSuperArcId(y);
+   auto reaches = [&](const idSuperArc &a) { return a == yArc || (yNode && upVertex(a) == y); };
+
+   // arcs explored upward from x, with the index of the previous one: the
+   // arcs ending above y are pruned
+   vector<pair<idSuperArc, idVertex>> explored;
+   vector<idVertex>                   stack;
+   auto goUp = [&](const idNode &n, const idVertex &previous) {
+      Node *node = tree.getNode(n);
+      for (unsigned char i = 0; i < node->getNumberOfUpSuperArcs(); ++i) {
+         const idSuperArc a = node->getUpSuperArcId(i);
+         if (tree.getSuperArc(a)->isVisible() && (reaches(a) || isLower(upVertex(a), y))) {
+            explored.emplace_back(a, previous);
+            stack.emplace_back(explored.size() - 1);
+         }
+      }
+   };
+
+   if (tree.isCorrespondingNode(x)) {
+      goUp(tree.getCorrespondingNode(x), -1);
+   } else {
+      explored.emplace_back(tree.getCorrespondingSuperArcId(x), -1);
+      stack.emplace_back(0);
+   }
+
+   path.clear();
+   while (!stack.empty()) {
+      const idVertex e = stack.back();
+      stack.pop_back();
+
+      if (reaches(explored[e].first)) {
+         for (idVertex p = e; p != -1; p = explored[p].second) {
+            path.emplace_back(explored[p].first);
+         }
+         reverse(path.begin(), path.end());
+         return 0;
+      }
+
+      goUp(tree.getSuperArc(explored[e].first)->getUpNodeId(), e);
+   }
+
+   return -1;
+}
+
+// }
+// Communications
+// {
+
+template <typename type>
+int DistributedContourTree::gather(const vector<type> &local, vector<type> &all,
+                                   vector<int> &offsets) const
+{
+   MPI_Datatype mpiType;
+   MPI_Type_contiguous(sizeof(type), MPI_BYTE, &mpiType);
+   MPI_Type_commit(&mpiType);
+
+   const int   count = local.size();
+   vector<int> counts((rank_) ? 0 : size_);
+   MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm_);
+
+   offsets.assign((rank_) ? 0 : size_ + 1, 0);
+   if (!rank_) {
+      partial_sum(counts.begin(), counts.end(), offsets.begin() + 1);
+      all.resize(offsets.back());
+   }
+
+   const int ret = MPI_Gatherv(local.data(), count, mpiType, all.data(), counts.data(),
+                               offsets.data(), mpiType, 0, comm_);
+   MPI_Type_free(&mpiType);
+
+   return (ret == MPI_SUCCESS) ? 0 : -1;
+}
+
+template <typename type>
+int DistributedContourTree::scatter(const vector<vector<type>> &parts, vector<type> &local) const
+{
+   MPI_Datatype mpiType;
+   MPI_Type_contiguous(sizeof(type), MPI_BYTE, &mpiType);
+   MPI_Type_commit(&mpiType);
+
+   vector<int>  counts, offsets;
+   vector<type> all;
+   if (!rank_) {
+      for (const auto &part : parts) {
+         counts.emplace_back(part.size());
+         offsets.emplace_back(all.size());
+         all.insert(all.end(), part.begin(), part.end());
+      }
+   }
+
+   int count;
+   MPI_Scatter(counts.data(), 1, MPI_INT, &count, 1, MPI_INT, 0, comm_);
+   local.resize(count);
+
+   const int ret = MPI_Scatterv(all.data(), counts.data(), offsets.data(), mpiType,
+                                local.data(), count, mpiType, 0, comm_);
+   MPI_Type_free(&mpiType);
+
+   return (ret == MPI_SUCCESS) ? 0 : -1;
+}
+
+// }
+
+#endif /* end of include guard: DISTRIBUTEDCONTOURTREETEMPLATE_H */
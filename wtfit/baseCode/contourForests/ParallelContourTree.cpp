@@ -20,7 +20,17 @@ ParallelContourTree::ParallelContourTree(const numThread &nbThread)
       nbInterfaces_(nbThread - 1),
       nbPartitions_(nbThread),
       partitionNum_(-1),
-      lessPartition_(false)
+      lessPartition_(false),
+      pruneOnTheFly_(false),
+      treeSelection_(TreeSelection::JoinAndSplit),
+      incrementalUpdate_(false),
+      partitionSort_(false),
+      nbGroups_(1),
+      workBalance_(false),
+      criticalWeight_(4),
+      speedFeedback_(false),
+      overlapWeight_(0),
+      numaReplication_(false)
 {
 #ifndef withKamikaze
    if (nbThread_ == 0) {
@@ -70,19 +80,32 @@ ParallelContourTree::~ParallelContourTree()
 // {
 void ParallelContourTree::initInterfaces()
 {
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+
    // We have nbThread_ partition of the same size through all vertices
-   size_t partitionSize = mesh_->getNumberOfVertices() / nbPartitions_;
+   size_t partitionSize = nbVert / nbPartitions_;
 
    // ------------------
    // Seeds
    // ------------------
    // {
 
+   vector<idVertex> seedPos(nbInterfaces_);
+   if (workBalance_ && nbInterfaces_ && nbVert > nbPartitions_) {
+      getBalancedSeeds(seedPos);
+   } else if (overlapWeight_ > 0 && nbInterfaces_ && nbVert > nbPartitions_) {
+      getSmallOverlapSeeds(seedPos);
+   } else {
+      for (decltype(nbInterfaces_) i = 0; i < nbInterfaces_; ++i) {
+         seedPos[i] = partitionSize * (i + 1);
+      }
+   }
+
    // We initiate interface with their seed (isovalue) and their adjacent partition
    //  and each partition with it size and bounds.
    for (decltype(nbInterfaces_) i = 0; i < nbInterfaces_; ++i) {
       // interfaces have their first vertex of the sorted array as seed
-      vect_interfaces_.emplace_back(sortedVertices_[partitionSize * (i + 1)]);
+      vect_interfaces_.emplace_back(sortedVertices_[seedPos[i]]);
    }
 
    // }
@@ -104,12 +127,201 @@ void ParallelContourTree::initInterfaces()
    // }
 }
 
+void ParallelContourTree::getOverlapProfile(vector<idVertex> &lowerCount,
+                                            vector<idVertex> &upperCount, vector<double> &work)
+{
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+   const unsigned nbThreadProfile = getNbThreadReal();
+
+   // v is in the lower overlap of the seeds in ]pos(v), pos(highest neighbor)]
+   // and in the upper overlap of the seeds in ]pos(lowest neighbor), pos(v)] :
+   // difference arrays, summed below
+   lowerCount.assign(nbVert + 2, 0);
+   upperCount.assign(nbVert + 2, 0);
+   work.assign(nbVert + 1, 0);
+
+#pragma omp parallel for num_threads(nbThreadProfile) schedule(static)
+   for (idVertex v = 0; v < nbVert; ++v) {
+      const idVertex pos     = mirrorOffsets_[v];
+      const idVertex nbNeigh = mesh_->getVertexNeighborNumber(v);
+      idVertex       minPos = pos, maxPos = pos;
+
+      for (idVertex n = 0; n < nbNeigh; ++n) {
+         idVertex neigh;
+         mesh_->getVertexNeighbor(v, n, neigh);
+         minPos = min(minPos, mirrorOffsets_[neigh]);
+         maxPos = max(maxPos, mirrorOffsets_[neigh]);
+      }
+
+      if (maxPos > pos) {
+#pragma omp atomic update
+         ++lowerCount[pos + 1];
+#pragma omp atomic update
+         --lowerCount[maxPos + 1];
+      }
+      if (minPos < pos) {
+#pragma omp atomic update
+         ++upperCount[minPos + 1];
+#pragma omp atomic update
+         --upperCount[pos + 1];
+      }
+
+      // local extrema create the arcs of the merge trees
+      const bool extremum = minPos == pos || maxPos == pos;
+      work[pos + 1]       = (extremum) ? criticalWeight_ : 1;
+   }
+
+   // speeds measured on the partitions of the last build
+   if (speedFeedback_ && feedbackBounds_.size() && feedbackBounds_.back() == nbVert) {
+      const float meanSpeed =
+          accumulate(feedbackSpeed_.cbegin(), feedbackSpeed_.cend(), 0.f) / feedbackSpeed_.size();
+
+      for (size_t p = 0; p < feedbackSpeed_.size(); ++p) {
+         if (feedbackSpeed_[p] <= 0) {
+            continue;
+         }
+         const double factor = meanSpeed / feedbackSpeed_[p];
+         for (idVertex pos = feedbackBounds_[p]; pos < feedbackBounds_[p + 1]; ++pos) {
+            work[pos + 1] *= factor;
+         }
+      }
+   }
+
+   for (idVertex pos = 0; pos < nbVert; ++pos) {
+      lowerCount[pos + 1] += lowerCount[pos];
+      upperCount[pos + 1] += upperCount[pos];
+      work[pos + 1] += work[pos];
+   }
+   lowerCount.resize(nbVert + 1);
+   upperCount.resize(nbVert + 1);
+}
+
+void ParallelContourTree::getBalancedSeeds(vector<idVertex> &seedPos)
+{
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+
+   vector<idVertex> lowerCount, upperCount;
+   vector<double>   work;
+   getOverlapProfile(lowerCount, upperCount, work);
+
+   // a partition [a, b[ sweeps its range, the lower overlap of the
+   // interface at a and the upper overlap of the interface at b
+   auto cost = [&](const idVertex &a, const idVertex &b) {
+      return work[b] - work[a] + lowerCount[a] + upperCount[b];
+   };
+
+   // maximal cost of the partitions for these seeds
+   auto maxCost = [&](const vector<idVertex> &pos) {
+      double   res = 0;
+      idVertex a   = 0;
+      for (const idVertex &b : pos) {
+         res = max(res, cost(a, b));
+         a   = b;
+      }
+      return max(res, cost(a, nbVert));
+   };
+
+   // each partition takes as many vertices as possible under the target,
+   // keeping at least one vertex for each of the next ones
+   vector<idVertex> pos(nbInterfaces_);
+   auto place = [&](const double &target) {
+      idVertex a = 0;
+      for (decltype(nbInterfaces_) i = 0; i < nbInterfaces_; ++i) {
+         idVertex lo = a + 1, hi = nbVert - (nbInterfaces_ - i);
+         while (lo < hi) {
+            const idVertex mid = lo + (hi - lo + 1) / 2;
+            if (cost(a, mid) <= target) {
+               lo = mid;
+            } else {
+               hi = mid - 1;
+            }
+         }
+         pos[i] = a = lo;
+      }
+      return maxCost(pos);
+   };
+
+   // start from the same number of vertices per partition
+   const idVertex partitionSize = nbVert / nbPartitions_;
+   for (decltype(nbInterfaces_) i = 0; i < nbInterfaces_; ++i) {
+      seedPos[i] = partitionSize * (i + 1);
+   }
+   const double equalCost = maxCost(seedPos);
+   double       bestCost  = equalCost;
+
+   // dichotomy on the maximal cost
+   double lo = work[nbVert] / nbPartitions_, hi = equalCost;
+   for (int it = 0; it < 32 && lo < hi; ++it) {
+      const double target = (lo + hi) / 2;
+      const double res    = place(target);
+      if (res < bestCost) {
+         bestCost = res;
+         seedPos  = pos;
+      }
+      if (res <= target) {
+         hi = target;
+      } else {
+         lo = target;
+      }
+   }
+
+   if (debugLevel_ > 2) {
+      stringstream msg;
+      msg << "[ParallelContourTree] predicted work of the largest partition : " << bestCost
+          << " (same size partitions : " << equalCost << ")" << endl;
+      dMsg(cout, msg.str(), infoMsg);
+   }
+}
+
+void ParallelContourTree::getSmallOverlapSeeds(vector<idVertex> &seedPos)
+{
+   const idVertex nbVert        = mesh_->getNumberOfVertices();
+   const idVertex partitionSize = nbVert / nbPartitions_;
+
+   vector<idVertex> lowerCount, upperCount;
+   vector<double>   work;
+   getOverlapProfile(lowerCount, upperCount, work);
+
+   // the search windows of two interfaces do not intersect: seeds stay ordered
+   const idVertex radius = max(0, (partitionSize - 1) / 2);
+
+   idVertex equalOverlap = 0, overlap = 0;
+
+#pragma omp parallel for num_threads(nbThread_) schedule(dynamic) \
+    reduction(+ : equalOverlap, overlap)
+   for (unsigned i = 0; i < nbInterfaces_; i++) {
+      const idVertex equalPos = partitionSize * (i + 1);
+      double         bestCost = overlapWeight_ * (lowerCount[equalPos] + upperCount[equalPos]);
+      seedPos[i]              = equalPos;
+
+      for (idVertex pos = max(1, equalPos - radius); pos <= min(nbVert - 1, equalPos + radius);
+           ++pos) {
+         const double cost =
+             abs(pos - equalPos) + overlapWeight_ * (lowerCount[pos] + upperCount[pos]);
+         if (cost < bestCost) {
+            bestCost   = cost;
+            seedPos[i] = pos;
+         }
+      }
+
+      equalOverlap += lowerCount[equalPos] + upperCount[equalPos];
+      overlap += lowerCount[seedPos[i]] + upperCount[seedPos[i]];
+   }
+
+   if (debugLevel_ > 2) {
+      stringstream msg;
+      msg << "[ParallelContourTree] overlap vertices : " << overlap
+          << " (same size partitions : " << equalOverlap << ")" << endl;
+      dMsg(cout, msg.str(), infoMsg);
+   }
+}
+
 void ParallelContourTree::initOverlap()
 {
    const idEdge nbEdges = mesh_->getNumberOfEdges();
 
    // if we choose to have less partition, we still want to use all thread for overlap init.
-   const unsigned nbThreadOverlap = (lessPartition_)?nbPartitions_*2:nbPartitions_;
+   const unsigned nbThreadOverlap = getNbThreadReal();
 
    // ------------------
    // Parallel find border vertices
@@ -124,45 +336,49 @@ void ParallelContourTree::initOverlap()
         uppers[p].resize(nbInterfaces_);
    }
 
-#pragma omp parallel for num_threads(nbThreadOverlap) schedule(static)
-   for (idEdge e = 0; e < nbEdges; e++) {
-
-#ifdef withOpenMP
-       unsigned part = omp_get_thread_num();
-#else
-       unsigned part = 0;
-#endif
+   getExecutor()->parallelChunks(
+       nbThreadOverlap, 0, nbEdges, [&](const unsigned &part, const idEdge &first, const idEdge &last) {
+          vector<vector<idVertex>> &localUppers = uppers[part];
+          vector<vector<idVertex>> &localLowers = lowers[part];
+
+          for (idEdge e = first; e < last; e++) {
+             idVertex v0, v1;
+             mesh_->getEdgeVertex(e, 0, v0);
+             mesh_->getEdgeVertex(e, 1, v1);
+
+             for (unsigned i = 0; i < nbInterfaces_; i++) {
+                const bool side0 = isEqHigher(v0, vect_interfaces_[i].getSeed());
+                const bool side1 = isEqHigher(v1, vect_interfaces_[i].getSeed());
+
+                if (side0 != side1) {
+                   // edge cross this interface, add both extrema in it
+                   if (side0) {
+                      // The seed is already in the partition, we do not want to have it twice
+                      //if (v0 != vect_interfaces_[i].getSeed()) {
+                      localUppers[i].emplace_back(v0);
+                      //}
+                      localLowers[i].emplace_back(v1);
+                   } else {
+                      //if (v1 != vect_interfaces_[i].getSeed()) {
+                      localUppers[i].emplace_back(v1);
+                      //}
+                      localLowers[i].emplace_back(v0);
+                   }
+                }
+             }
+          }
+       });
 
-       vector<vector<idVertex>> &localUppers = uppers[part];
-       vector<vector<idVertex>> &localLowers = lowers[part];
+   // }
 
-       idVertex v0, v1;
-       mesh_->getEdgeVertex(e,0,v0);
-       mesh_->getEdgeVertex(e,1,v1);
+   fillOverlap(lowers, uppers);
+}
 
-       for (unsigned i = 0; i < nbInterfaces_; i++) {
-           const bool side0 = isEqHigher(v0, vect_interfaces_[i].getSeed());
-           const bool side1 = isEqHigher(v1, vect_interfaces_[i].getSeed());
-
-           if(side0 != side1){
-              // edge cross this interface, add both extrema in it
-              if(side0){
-                 // The seed is already in the partition, we do not want to have it twice
-                 //if (v0 != vect_interfaces_[i].getSeed()) {
-                    localUppers[i].emplace_back(v0);
-                 //}
-                 localLowers[i].emplace_back(v1);
-              } else {
-                 //if (v1 != vect_interfaces_[i].getSeed()) {
-                    localUppers[i].emplace_back(v1);
-                 //}
-                 localLowers[i].emplace_back(v0);
-              }
-           }
-       }
-   }
+void ParallelContourTree::fillOverlap(vector<vector<vector<idVertex>>> &lowers,
+                                      vector<vector<vector<idVertex>>> &uppers)
+{
+   const unsigned nbThreadOverlap = lowers.size();
 
-   // }
    // --------------------------
    // Insert in interfaces
    // --------------------------
@@ -203,8 +419,7 @@ void ParallelContourTree::initOverlap()
         return isLower(a,b);
    };
 
-#pragma omp parallel for num_threads(nbInterfaces_) schedule(static)
-   for (unsigned i = 0; i < nbInterfaces_; i++) {
+   getExecutor()->parallelFor(0, nbInterfaces_, [&](const unsigned &i) {
       vector<idVertex> &upOverlap = vect_interfaces_[i].getUpper();
       vector<idVertex> &loOverlap = vect_interfaces_[i].getLower();
 
@@ -214,7 +429,7 @@ void ParallelContourTree::initOverlap()
       sort(loOverlap.begin(), loOverlap.end(), isLowerComp);
       auto loLast = unique(loOverlap.begin(), loOverlap.end());
       loOverlap.erase(loLast, loOverlap.end());
-   }
+   }, nbThread_, 1);
 
    // }
    // -----------
@@ -245,9 +460,209 @@ void ParallelContourTree::initOverlap()
 void ParallelContourTree::flush(void)
 {
    MergeTree::flush();
+   vect_interfaces_.clear();
    vect_interfaces_.reserve(nbInterfaces_);
    vect_ct_.resize(nbPartitions_);
 }
+
+void ParallelContourTree::clearUnionFind(vector<ExtendedUnionFind *> &vect_UF)
+{
+   // each union-find is created at a single extremum, the other vertices
+   // share it: keep one pointer per object
+   vect_UF.erase(remove(vect_UF.begin(), vect_UF.end(), nullptr), vect_UF.end());
+   sort(vect_UF.begin(), vect_UF.end());
+   vect_UF.erase(unique(vect_UF.begin(), vect_UF.end()), vect_UF.end());
+   for (auto *uf : vect_UF) {
+      delete uf;
+   }
+   vector<ExtendedUnionFind *>().swap(vect_UF);
+}
+
+void ParallelContourTree::sortBySize(vector<idPartition> &partitions) const
+{
+   if (nbPartitions_ <= nbThread_) {
+      return;
+   }
+
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+
+   // main range and overlaps
+   auto size = [&](const idPartition &i) {
+      const idVertex start = (i == 0) ? 0 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
+      const idVertex end =
+          (i == nbInterfaces_) ? nbVert : mirrorOffsets_[vect_interfaces_[i].getSeed()];
+      idVertex res = end - start;
+      if (i != 0)
+         res += vect_interfaces_[i - 1].getNbLower();
+      if (i != nbInterfaces_)
+         res += vect_interfaces_[i].getNbUpper();
+      return res;
+   };
+
+   stable_sort(partitions.begin(), partitions.end(),
+               [&](const idPartition &a, const idPartition &b) { return size(a) > size(b); });
+}
+// }
+
+// Update
+// {
+
+void ParallelContourTree::getOverlapMembership(const vector<idVertex> &border,
+                                               vector<char> &          membership)
+{
+   // 1 : upper overlap of the interface, 2 : lower overlap, 0 : none
+   // same rule as initOverlap : an edge of the vertex crosses the interface
+   const idVertex nbBorder = border.size();
+   membership.assign(nbBorder * nbInterfaces_, 0);
+
+   getExecutor()->parallelFor(0, nbBorder, [&](const idVertex &b) {
+      const idVertex &v       = border[b];
+      const idVertex  nbNeigh = mesh_->getVertexNeighborNumber(v);
+
+      for (unsigned i = 0; i < nbInterfaces_; i++) {
+         const bool side = isEqHigher(v, vect_interfaces_[i].getSeed());
+
+         for (idVertex n = 0; n < nbNeigh; n++) {
+            idVertex neigh;
+            mesh_->getVertexNeighbor(v, n, neigh);
+            if (isEqHigher(neigh, vect_interfaces_[i].getSeed()) != side) {
+               membership[b * nbInterfaces_ + i] = (side) ? 1 : 2;
+               break;
+            }
+         }
+      }
+   }, nbThread_);
+}
+
+void ParallelContourTree::updateOverlap(const vector<idVertex> &border,
+                                        const vector<char> &changedBorder,
+                                        const vector<char> &before, vector<char> &toBuild)
+{
+   const idVertex nbBorder = border.size();
+
+   vector<char> after;
+   getOverlapMembership(border, after);
+
+   // An interface is modified if a vertex enters or leaves its overlap,
+   // or if a changed vertex is in it (the overlap is sorted).
+   vector<char> modified(nbInterfaces_, 0);
+   for (unsigned i = 0; i < nbInterfaces_; i++) {
+      for (idVertex b = 0; b < nbBorder; b++) {
+         const char &bef = before[b * nbInterfaces_ + i];
+         const char &aft = after[b * nbInterfaces_ + i];
+         if (bef != aft || (changedBorder[b] && (bef || aft))) {
+            modified[i] = 1;
+            // the partitions on both sides use this overlap
+            toBuild[i]     = 1;
+            toBuild[i + 1] = 1;
+            break;
+         }
+      }
+   }
+
+   auto isLowerComp = [&](const idVertex &a, const idVertex &b) { return isLower(a, b); };
+
+   auto isBorder = [&](const idVertex &v) {
+      return binary_search(border.cbegin(), border.cend(), v);
+   };
+
+   getExecutor()->parallelFor(0, nbInterfaces_, [&](const unsigned &i) {
+      if (!modified[i])
+         return;
+
+      vector<idVertex> &upOverlap = vect_interfaces_[i].getUpper();
+      vector<idVertex> &loOverlap = vect_interfaces_[i].getLower();
+
+      // remove the border vertices and put them back where they now belong
+      upOverlap.erase(remove_if(upOverlap.begin(), upOverlap.end(), isBorder), upOverlap.end());
+      loOverlap.erase(remove_if(loOverlap.begin(), loOverlap.end(), isBorder), loOverlap.end());
+
+      for (idVertex b = 0; b < nbBorder; b++) {
+         const char &aft = after[b * nbInterfaces_ + i];
+         if (aft == 1) {
+            upOverlap.emplace_back(border[b]);
+         } else if (aft == 2) {
+            loOverlap.emplace_back(border[b]);
+         }
+      }
+
+      sort(upOverlap.begin(), upOverlap.end(), isLowerComp);
+      sort(loOverlap.begin(), loOverlap.end(), isLowerComp);
+   }, nbThread_, 1);
+}
+
+void ParallelContourTree::copyPartitionVert2Tree(const idPartition &i, const bool save)
+{
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+
+   vector<idCorresp> &vert2tree = *vect_ct_[i].vect_vert2tree_;
+   vector<idCorresp> &saved     = vect_partitions_[i].vert2tree_;
+
+   const idVertex start = (i == 0) ? 0 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
+   const idVertex end =
+       (i == nbInterfaces_) ? nbVert : mirrorOffsets_[vect_interfaces_[i].getSeed()];
+
+   const vector<idVertex> &lowerOverlap =
+       (i == 0) ? vector<idVertex>() : vect_interfaces_[i - 1].getLower();
+   const vector<idVertex> &upperOverlap =
+       (i == nbInterfaces_) ? vector<idVertex>() : vect_interfaces_[i].getUpper();
+
+   if (save) {
+      saved.resize(lowerOverlap.size() + (end - start) + upperOverlap.size());
+   }
+
+   size_t pos = 0;
+   auto copyVertex = [&](const idVertex &v) {
+      if (save) {
+         saved[pos++] = vert2tree[v];
+      } else {
+         vert2tree[v] = saved[pos++];
+      }
+   };
+
+   for (const idVertex &v : lowerOverlap) {
+      copyVertex(v);
+   }
+   for (idVertex p = start; p < end; ++p) {
+      copyVertex(sortedVertices_[p]);
+   }
+   for (const idVertex &v : upperOverlap) {
+      copyVertex(v);
+   }
+}
+
+void ParallelContourTree::savePartition(const idPartition &i)
+{
+   const ContourTree &ct    = vect_ct_[i];
+   Partition &        saved = vect_partitions_[i];
+
+   saved.superArcs_         = ct.vect_superArcs_;
+   saved.nodes_             = ct.vect_nodes_;
+   saved.leaves_            = ct.vect_leaves_;
+   saved.roots_             = ct.vect_roots_;
+   saved.arcsCrossingBelow_ = ct.vect_arcsCrossingBelow_;
+   saved.arcsCrossingAbove_ = ct.vect_arcsCrossingAbove_;
+
+   copyPartitionVert2Tree(i, true);
+}
+
+void ParallelContourTree::restorePartition(const idPartition &i)
+{
+   ContourTree &    ct    = vect_ct_[i];
+   const Partition &saved = vect_partitions_[i];
+
+   // the segmentation is not copied: the stitching and the unification
+   // only move the arcs bounds in the lists of the merge trees.
+   ct.vect_superArcs_         = saved.superArcs_;
+   ct.vect_nodes_             = saved.nodes_;
+   ct.vect_leaves_            = saved.leaves_;
+   ct.vect_roots_             = saved.roots_;
+   ct.vect_arcsCrossingBelow_ = saved.arcsCrossingBelow_;
+   ct.vect_arcsCrossingAbove_ = saved.arcsCrossingAbove_;
+
+   copyPartitionVert2Tree(i, false);
+}
+
 // }
 
 // Process
@@ -271,6 +686,66 @@ void ParallelContourTree::stitch()
 }
 
 void ParallelContourTree::stitchTree(const char treetype)
+{
+   const bool DEBUG = false;
+
+   // crossing arcs of each tree already stitched with the tree above
+   vector<size_t> stitched(nbPartitions_, 0);
+
+   // first level: the interfaces inside a group of consecutive partitions
+   // only modify the trees of the group
+   const idPartition nbGroups = min(nbGroups_, nbPartitions_);
+   if (nbGroups > 1) {
+      getExecutor()->parallelFor(0, nbGroups, [&](const idPartition &g) {
+         const idPartition first = g * nbPartitions_ / nbGroups;
+         const idPartition last  = (g + 1) * nbPartitions_ / nbGroups;
+         for (idInterface i = first; i + 1 < last; ++i) {
+            stitched[i] = stitchInterface(treetype, i, 0);
+         }
+      }, nbThread_, 1);
+   }
+
+   // second level, in order: the interfaces between the groups (all of them
+   // with a single level). An arc stitched through an interface may cross the
+   // next one too: it is added to the crossing arcs of the tree above, which
+   // are stitched from where they stopped.
+   for (idInterface i = 0; i < nbInterfaces_; ++i) {
+      stitched[i] = stitchInterface(treetype, i, stitched[i]);
+   }
+
+   // the overlap of each tree is replaced by its neighbours: its arcs, never
+   // reached by the unification, are hidden not to be counted in the valence
+   // of the nodes they lead to
+   getExecutor()->parallelFor(0, nbPartitions_, [&](const idPartition &p) {
+      MergeTree *tree = &vect_ct_[p];
+      if (treetype == 0) {
+         tree = vect_ct_[p].getJoinTree();
+      } else if (treetype == 1) {
+         tree = vect_ct_[p].getSplitTree();
+      }
+
+      const idSuperArc nbArcs = tree->getNumberOfSuperArcs();
+      for (idSuperArc a = 0; a < nbArcs; ++a) {
+         SuperArc *arc = tree->getSuperArc(a);
+         if (!arc->isVisible() || arc->getDownCT() != p || arc->getUpCT() != p) {
+            continue;
+         }
+
+         const idVertex down = tree->getNode(arc->getDownNodeId())->getVertexId();
+         if ((p > 0 && isLower(down, vect_interfaces_[p - 1].getSeed())) ||
+             (p < nbInterfaces_ && !isLower(down, vect_interfaces_[p].getSeed()))) {
+            arc->hide();
+         }
+      }
+   }, nbThread_, 1);
+
+   if (DEBUG) {
+     printVectCT();
+   }
+}
+
+size_t ParallelContourTree::stitchInterface(const char treetype, const idInterface i,
+                                            const size_t firstArc)
 {
 
     const bool DEBUG = false;
@@ -288,206 +763,240 @@ void ParallelContourTree::stitchTree(const char treetype)
       return &vect_ct_[i];
    };
 
-   // the last partition can't stitch above
-   for (int i = 0; i < nbPartitions_-1; i++) {
-      MergeTree *tree = getTree(i);
-      // we stitch with above tree
-      for (const auto &arc : tree->vect_arcsCrossingAbove_) {
-         SuperArc *crossing = tree->getSuperArc(arc);
-
-         // ignore useless arc (should not happend)
-         if (!crossing->isVisible()) {
-            if (DEBUG) {
-               cout << "ignore hidden arc : " << tree->printArc(arc) << endl;
-               cout << endl;
-            }
-            continue;
+   MergeTree *tree = getTree(i);
+   // we stitch with above tree
+   // only the arc ids are kept: the insertions below reallocate the arcs
+   const vector<idSuperArc> crossingArcs(tree->vect_arcsCrossingAbove_.begin() + firstArc,
+                                         tree->vect_arcsCrossingAbove_.end());
+   // arcs whose part above the seed does not match the tree above (the
+   // vertices there may be masked): stitched last, along the arc of the
+   // tree above leaving the same vertex below the seed
+   vector<idSuperArc> deferredArcs;
+   for (int pass = 0; pass < 2; ++pass) {
+   for (const idSuperArc arc : (pass ? deferredArcs : crossingArcs)) {
+      const idPartition crossingDown = tree->getSuperArc(arc)->getDownCT();
+
+      // ignore useless arc (should not happend)
+      if (!tree->getSuperArc(arc)->isVisible()) {
+         if (DEBUG) {
+            cout << "ignore hidden arc : " << tree->printArc(arc) << endl;
+            cout << endl;
          }
+         continue;
+      }
+
+      if (DEBUG) {
+         cout << "crossing above ->" << tree->printArc(arc) << endl;
+         cout << " (part: " << i << ")" << endl;
+      }
 
+      const pair<idVertex, bool> &seed = make_pair(vect_interfaces_[i].getSeed(), false);
+      if (isLower(tree->getNode(tree->getSuperArc(arc)->getUpNodeId())->getVertexId(),
+                  seed.first)) {
          if (DEBUG) {
-            cout << "crossing above ->" << tree->printArc(arc) << endl;
-            cout << " (part: " << i << ")" << endl;
+            cout << "up is below seed !! " << endl;
          }
+         continue;
+      }
 
-         const pair<idVertex, bool> &seed = make_pair(vect_interfaces_[i].getSeed(), false);
-         if (isLower(tree->getNode(crossing->getUpNodeId())->getVertexId(), seed.first)) {
-            if (DEBUG) {
-               cout << "up is below seed !! " << endl;
+      // info about the other side
+      // the arc cross above, that mean we are not on the last partition
+      const idPartition &otherPartition = i + 1;
+      idVertex           stitchVert     = tree->getVertAboveSeed(arc, seed);
+      idSuperArc         aboveArc       = nullSuperArc;
+
+      if (crossingDown == i) {
+         const idVertex below =
+             tree->cutArcBelowSeed(arc, seed, getTree(otherPartition)->vect_vert2tree_);
+         if (isLower(below, seed.first) &&
+             !getTree(otherPartition)->isLeadingTo(below, stitchVert)) {
+            if (!pass) {
+               deferredArcs.emplace_back(arc);
+               continue;
             }
-            continue;
+            aboveArc = getTree(otherPartition)->getArcCrossingFrom(below, seed.first);
          }
+      }
 
-         // info about the other side
-         // the arc cross above, that mean we are not on the last partition
-         const idPartition &otherPartition = i + 1;
-         const idVertex stitchVert = tree->cutArcAboveSeed(arc, seed);
-
-         // Curent tree stitch node
+      if (aboveArc != nullSuperArc) {
+         // the tree above gives the stitch vertex, the crossing arc now ends on it
+         tree->cutArcAboveSeed(arc, seed);
+         stitchVert = getTree(otherPartition)->getVertAboveSeed(aboveArc, seed);
          if (!tree->isCorrespondingNode(stitchVert)) {
-            auto newNodeId = tree->makeNode(stitchVert);
-            tree->updateCorrespondingArc(stitchVert, arc);
-
-            if (DEBUG) {
-               idSuperArc sa = tree->getCorrespondingSuperArcId(stitchVert);
-               cout << "insert node in current in : ";
-               cout << tree->printArc(sa);
-               cout << endl;
-            }
-
-            tree->insertNode(tree->getNode(newNodeId), false, true);
-            tree->getNode(newNodeId)->setUpValence(1);
-            tree->getNode(newNodeId)->setDownValence(1);
+            tree->makeNode(stitchVert);
          }
-         const idNode curTreeStitchNodeId = tree->getCorrespondingNode(stitchVert);
+         const idNode newUpNodeId = tree->getCorrespondingNode(stitchVert);
+         SuperArc *   crossing    = tree->getSuperArc(arc);
+         tree->getNode(crossing->getUpNodeId())->removeDownSuperArc(arc);
+         crossing->setUpNodeId(newUpNodeId);
+         tree->getNode(newUpNodeId)->addDownSuperArcId(arc);
 
-         if(DEBUG){
-            cout << "stitch vertex is : " << stitchVert << endl;
-         }
-
-         // Above tree stitch node
-         idSuperArc toHideAbove = nullSuperArc;
-         if (getTree(otherPartition)->isCorrespondingArc(stitchVert)) {
-            if (DEBUG) {
-               idSuperArc arcOtherTree =
-                   getTree(otherPartition)->getCorrespondingSuperArcId(stitchVert);
-               cout << "rev. insert node in: ";
-               cout << getTree(otherPartition)->printArc(arcOtherTree);
-               cout << endl;
-            }
-
-            // insert stitchpoint
-            toHideAbove =
-                getTree(otherPartition)
-                    ->reverseInsertNode(tree->getNode(curTreeStitchNodeId), segmentation_, true);
-            tree->getNode(curTreeStitchNodeId)->setUpValence(1);
-            tree->getNode(curTreeStitchNodeId)->setDownValence(1);
-         }
-         const idNode otherTreeStitchNodeId = getTree(otherPartition)->getCorrespondingNode(stitchVert);
-
-         if(DEBUG){
-            cout << "verify vertex : " << otherTreeStitchNodeId << " id : "
-                 << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId() << endl;
-
-            cout << "degree : " << static_cast<unsigned>(getTree(otherPartition)
-                                                             ->getNode(otherTreeStitchNodeId)
-                                                             ->getNumberOfDownSuperArcs());
-            cout << " - " << static_cast<unsigned>(getTree(otherPartition)
-                                                       ->getNode(otherTreeStitchNodeId)
-                                                       ->getNumberOfUpSuperArcs());
-            cout << " hidden : "
-                 << static_cast<unsigned>(
-                        getTree(otherPartition)->getNode(otherTreeStitchNodeId)->isHidden())
+         if (DEBUG) {
+            cout << "retarget on above arc : " << getTree(otherPartition)->printArc(aboveArc)
                  << endl;
-
-            if (getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId() != stitchVert) {
-                cout << "stitching problem : " << endl;
-                cout << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId()
-                    << " should be " << stitchVert << endl;
-            }
          }
+      } else {
+         stitchVert = tree->cutArcAboveSeed(arc, seed);
+      }
 
-         if (getTree(otherPartition)->getNode(otherTreeStitchNodeId)->isHidden()) {
-            cout << "------> is hidden !" << endl;
-            continue;
+      // Curent tree stitch node
+      if (!tree->isCorrespondingNode(stitchVert)) {
+         auto newNodeId = tree->makeNode(stitchVert);
+         tree->updateCorrespondingArc(stitchVert, arc);
+
+         if (DEBUG) {
+            idSuperArc sa = tree->getCorrespondingSuperArcId(stitchVert);
+            cout << "insert node in current in : ";
+            cout << tree->printArc(sa);
+            cout << endl;
          }
 
-         //if(toHideHere != nullSuperArc){
-             //tree->hideArc(toHideHere);
-             //if (DEBUG) {
-                //cout << " hide in current : " << tree->printArc(toHideHere) << endl;
-             //}
-         //}
+         tree->insertNode(tree->getNode(newNodeId), false, true);
+         tree->getNode(newNodeId)->setUpValence(1);
+         tree->getNode(newNodeId)->setDownValence(1);
+      }
+      const idNode curTreeStitchNodeId = tree->getCorrespondingNode(stitchVert);
 
-         idSuperArc leading = nullSuperArc;
+      if(DEBUG){
+         cout << "stitch vertex is : " << stitchVert << endl;
+      }
 
-         // Hide in tree above, arc leading to stitch
-         if(toHideAbove != nullSuperArc){
-             getTree(otherPartition)->hideArc(toHideAbove);
-             leading = 0;
-             if (DEBUG) {
-                cout << " hide in above : " << getTree(otherPartition)->printArc(toHideAbove)
-                     << endl;
-             }
-         } else if(crossing->getDownCT() == i){
+      // Above tree stitch node
+      idSuperArc toHideAbove = nullSuperArc;
+      if (getTree(otherPartition)->isCorrespondingArc(stitchVert)) {
+         if (DEBUG) {
+            idSuperArc arcOtherTree =
+                getTree(otherPartition)->getCorrespondingSuperArcId(stitchVert);
+            cout << "rev. insert node in: ";
+            cout << getTree(otherPartition)->printArc(arcOtherTree);
+            cout << endl;
+         }
 
-            // hide and disconnect arc leading to : current -> can be node or segmentation
-            const idVertex below =
-                tree->cutArcBelowSeed(arc, seed, getTree(otherPartition)->vect_vert2tree_);
-            leading = getTree(otherPartition)->hideAndClearLeadingTo(otherTreeStitchNodeId, below);
+         // insert stitchpoint
+         toHideAbove =
+             getTree(otherPartition)
+                 ->reverseInsertNode(tree->getNode(curTreeStitchNodeId), segmentation_, true);
+         tree->getNode(curTreeStitchNodeId)->setUpValence(1);
+         tree->getNode(curTreeStitchNodeId)->setDownValence(1);
+      }
+      const idNode otherTreeStitchNodeId = getTree(otherPartition)->getCorrespondingNode(stitchVert);
+
+      if(DEBUG){
+         cout << "verify vertex : " << otherTreeStitchNodeId << " id : "
+              << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId() << endl;
+
+         cout << "degree : " << static_cast<unsigned>(getTree(otherPartition)
+                                                          ->getNode(otherTreeStitchNodeId)
+                                                          ->getNumberOfDownSuperArcs());
+         cout << " - " << static_cast<unsigned>(getTree(otherPartition)
+                                                    ->getNode(otherTreeStitchNodeId)
+                                                    ->getNumberOfUpSuperArcs());
+         cout << " hidden : "
+              << static_cast<unsigned>(
+                     getTree(otherPartition)->getNode(otherTreeStitchNodeId)->isHidden())
+              << endl;
 
-            if (DEBUG) {
-               cout << " hide in above leading to at vert : " << static_cast<unsigned>(below);
-               if(leading != nullSuperArc){
-                  cout << " arc : " << getTree(otherPartition)->printArc(leading) << endl;
-               } else {
-                  cout << " no arc found " << endl;
-               }
-            }
+         if (getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId() != stitchVert) {
+             cout << "stitching problem : " << endl;
+             cout << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId()
+                 << " should be " << stitchVert << endl;
          }
+      }
 
-         // avoid duplicate if : /\      |
-         if (tree->alreadyExtLinked(curTreeStitchNodeId, otherPartition, otherTreeStitchNodeId)) {
-            if (DEBUG) {
-               cout << "This arc already exist" << endl << endl;
-            }
-            continue;
-         }
+      if (getTree(otherPartition)->getNode(otherTreeStitchNodeId)->isHidden()) {
+         cout << "------> is hidden !" << endl;
+         continue;
+      }
 
-         // For gaussian 2 threads : hide all noise
-         tree->getNode(curTreeStitchNodeId)->clearUpSuperArcs();
+      //if(toHideHere != nullSuperArc){
+          //tree->hideArc(toHideHere);
+          //if (DEBUG) {
+             //cout << " hide in current : " << tree->printArc(toHideHere) << endl;
+          //}
+      //}
 
-         // Insert
+      idSuperArc leading = nullSuperArc;
 
-         // Arc from top to bottom
-         // TODO TODO Might overlap above !! not necessarly false
-         // If true, add in the vector !!
-         bool stillAbove = false;
+      // Hide in tree above, arc leading to stitch
+      if(toHideAbove != nullSuperArc){
+          getTree(otherPartition)->hideArc(toHideAbove);
+          leading = 0;
+          if (DEBUG) {
+             cout << " hide in above : " << getTree(otherPartition)->printArc(toHideAbove)
+                  << endl;
+          }
+      } else if(crossingDown == i){
 
-         if(i < nbPartitions_-2){
-           const idVertex nextSeed = vect_interfaces_[otherPartition].getSeed();
-           stillAbove = isLower(nextSeed, stitchVert);
-         }
-         getTree(otherPartition)
-             ->vect_superArcs_.emplace_back(curTreeStitchNodeId, otherTreeStitchNodeId, true,
-                                            stillAbove, i, otherPartition);
-         getTree(otherPartition)
-             ->getNode(otherTreeStitchNodeId)
-             ->addDownSuperArcId(getTree(otherPartition)->vect_superArcs_.size() - 1);
-         if(stillAbove){
-            const idSuperArc & lastArc = getTree(otherPartition)->vect_superArcs_.size() - 1;
-            getTree(otherPartition)->addCrossingAbove(lastArc);
+         // hide and disconnect arc leading to : current -> can be node or segmentation
+         const idVertex below =
+             tree->cutArcBelowSeed(arc, seed, getTree(otherPartition)->vect_vert2tree_);
+         leading = getTree(otherPartition)->hideAndClearLeadingTo(otherTreeStitchNodeId, below);
 
-            if (DEBUG) {
-               cout << "add new crossing above arc" << endl;
+         if (DEBUG) {
+            cout << " hide in above leading to at vert : " << static_cast<unsigned>(below);
+            if(leading != nullSuperArc){
+               cout << " arc : " << getTree(otherPartition)->printArc(leading) << endl;
+            } else {
+               cout << " no arc found " << endl;
             }
          }
+      }
 
-         // VERY UGLY FIX
-         if (leading == nullSuperArc) {
-            getTree(otherPartition)->getSuperArc(
-                    getTree(otherPartition)->getNumberOfSuperArcs() -1)->hide();
+      // avoid duplicate if : /\      |
+      if (tree->alreadyExtLinked(curTreeStitchNodeId, otherPartition, otherTreeStitchNodeId)) {
+         if (DEBUG) {
+            cout << "This arc already exist" << endl << endl;
          }
+         continue;
+      }
+
+      // For gaussian 2 threads : hide all noise
+      tree->getNode(curTreeStitchNodeId)->clearUpSuperArcs();
 
-         // Arc bottom to top
-         tree->vect_superArcs_.emplace_back(curTreeStitchNodeId, otherTreeStitchNodeId, false, true,
-                                            i, otherPartition);
-         tree->getNode(curTreeStitchNodeId)->addUpSuperArcId(tree->vect_superArcs_.size() - 1);
+      // Insert
+
+      // Arc from top to bottom
+      // TODO TODO Might overlap above !! not necessarly false
+      // If true, add in the vector !!
+      bool stillAbove = false;
+
+      if(i < nbPartitions_-2){
+        // the next seed is in the partition above the next interface
+        const idVertex nextSeed = vect_interfaces_[otherPartition].getSeed();
+        stillAbove = !isLower(stitchVert, nextSeed);
+      }
+      getTree(otherPartition)
+          ->vect_superArcs_.emplace_back(curTreeStitchNodeId, otherTreeStitchNodeId, true,
+                                         stillAbove, i, otherPartition);
+      getTree(otherPartition)
+          ->getNode(otherTreeStitchNodeId)
+          ->addDownSuperArcId(getTree(otherPartition)->vect_superArcs_.size() - 1);
+      if(stillAbove){
+         const idSuperArc & lastArc = getTree(otherPartition)->vect_superArcs_.size() - 1;
+         getTree(otherPartition)->addCrossingAbove(lastArc);
 
          if (DEBUG) {
-             cout << "added in " << static_cast<unsigned>(otherPartition) << " and current ";
-             cout << "arc "
-                  << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId();
-             cout << " - " << tree->getNode(curTreeStitchNodeId)->getVertexId();
-             cout << " stitch with above done" << endl;
-             cout << endl;
+            cout << "add new crossing above arc" << endl;
          }
-      }  // for each arc of this tree
+      }
 
-   }  // for each partition
+      // Arc bottom to top
+      tree->vect_superArcs_.emplace_back(curTreeStitchNodeId, otherTreeStitchNodeId, false, true,
+                                         i, otherPartition);
+      tree->getNode(curTreeStitchNodeId)->addUpSuperArcId(tree->vect_superArcs_.size() - 1);
 
-   if (DEBUG) {
-     printVectCT();
-   }
+      if (DEBUG) {
+          cout << "added in " << static_cast<unsigned>(otherPartition) << " and current ";
+          cout << "arc "
+               << getTree(otherPartition)->getNode(otherTreeStitchNodeId)->getVertexId();
+          cout << " - " << tree->getNode(curTreeStitchNodeId)->getVertexId();
+          cout << " stitch with above done" << endl;
+          cout << endl;
+      }
+   }  // for each arc of this tree
+   }  // for each pass
+
+   return tree->vect_arcsCrossingAbove_.size();
 }
 
 void ParallelContourTree::unify()
@@ -800,6 +1309,9 @@ void ParallelContourTree::unifyCT()
    vect_nodes_     = tmpTree.vect_nodes_;
    vect_vert2tree_->swap(*tmpTree.vect_vert2tree_);
    vect_leaves_.swap(tmpTree.vect_leaves_);
+
+   delete tmpTree.vect_vert2tree_;
+   tmpTree.vect_vert2tree_ = nullptr;
 }
 
 void ParallelContourTree::unifyMT()
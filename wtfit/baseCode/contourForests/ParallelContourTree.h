@@ -105,6 +105,24 @@ namespace wtfit
       // }
    };
 
+   // Local contour tree of a partition as it was before the stitching.
+   // Kept to update the forest when only a few vertices change: the partitions
+   // not touched by the change are restored from here instead of being rebuilt.
+   class Partition
+   {
+      friend class ParallelContourTree;
+
+     private:
+      vector<SuperArc>   superArcs_;
+      vector<Node>       nodes_;
+      vector<idNode>     leaves_, roots_;
+      vector<idSuperArc> arcsCrossingBelow_, arcsCrossingAbove_;
+
+      // vert2tree of the vertices processed by this partition, in the
+      // processing order : lower overlap, main range, upper overlap
+      vector<idCorresp> vert2tree_;
+   };
+
    class ParallelContourTree : public ContourTree
    {
      private:
@@ -114,9 +132,34 @@ namespace wtfit
       idPartition nbPartitions_;
       int partitionNum_;
       bool lessPartition_;
+      bool pruneOnTheFly_;
+      TreeSelection treeSelection_;
+      bool incrementalUpdate_;
+      bool partitionSort_;
+      idPartition nbGroups_;
+
+      // seeds balancing the predicted work of the partitions
+      bool   workBalance_;
+      double criticalWeight_;
+      bool   speedFeedback_;
+      double overlapWeight_;
+      // bounds (sorted positions) and speed of the partitions of the last build
+      vector<idVertex> feedbackBounds_;
+      vector<float>    feedbackSpeed_;
+
+      // copies of the scalars and SoS offsets for each NUMA node, made by the
+      // first partition built on the node
+      bool                     numaReplication_;
+      vector<vector<char>>     numaScalars_;
+      vector<vector<idVertex>> numaOffsets_;
+      mutex                    numaLock_;
+
+      // cores of the threads during the build (see Executor::getAffinityCores)
+      string threadAffinity_;
 
       vector<Interface>   vect_interfaces_;
       vector<ContourTree> vect_ct_;
+      vector<Partition>   vect_partitions_;
 
       // vector<vector<Node> *> vect_corrNodes_;
       // vector<vector<SuperArc> *> vect_corrSuperArc_;
@@ -156,6 +199,34 @@ namespace wtfit
          vect_ct_.resize(nbPartitions_);
       }
 
+      // Over-decomposition: nbPartitions partitions are processed by the
+      // nbThread_ threads with a dynamic schedule, largest first
+      // (0 : one partition per thread). To call after setNbThread.
+      inline void setNbPartitions(const unsigned nbPartitions)
+      {
+         nbPartitions_ = (nbPartitions)
+                             ? min(nbPartitions, (unsigned)numeric_limits<idPartition>::max())
+                             : nbThread_;
+         nbInterfaces_ = nbPartitions_ - 1;
+
+         vect_interfaces_.reserve(nbInterfaces_);
+         // a resize would copy the local trees, which own their merge trees
+         vector<ContourTree>(nbPartitions_).swap(vect_ct_);
+         vect_partitions_.clear();
+      }
+
+      inline idPartition getNbPartitions(void) const
+      {
+         return nbPartitions_;
+      }
+
+      // threads used: the merge trees of a partition have one thread each
+      // with lessPartition_
+      inline unsigned getNbThreadReal(void) const
+      {
+         return (lessPartition_) ? nbThread_ * 2 : nbThread_;
+      }
+
       inline void setPartitionNum(int p)
       {
           partitionNum_ = p;
@@ -166,19 +237,179 @@ namespace wtfit
           lessPartition_ = l;
       }
 
+      // fold noisy branches during the merge trees sweep
+      // instead of waiting the local simplification
+      inline void setPruneOnTheFly(bool p)
+      {
+          pruneOnTheFly_ = p;
+      }
+
+      // 0 : join tree, 1 : split tree, 2 : contour tree, 3 : both merge trees
+      // when the contour tree is not computed, only the selected merge trees are built
+      inline void setTreeSelection(int t)
+      {
+         switch (t) {
+            case 0:
+               treeSelection_ = TreeSelection::Join;
+               break;
+            case 1:
+               treeSelection_ = TreeSelection::Split;
+               break;
+            case 2:
+               treeSelection_ = TreeSelection::Contour;
+               break;
+            default:
+               treeSelection_ = TreeSelection::JoinAndSplit;
+               break;
+         }
+      }
+
+      // Warm start for time-varying data: the next build sorts the vertices
+      // starting from previousOrder (getSortedVertices() of the previous
+      // timestep). The cost then depends on the number of vertices out of place.
+      inline void warmStart(const vector<idVertex> &previousOrder)
+      {
+         sortedVertices_.clear();
+         mirrorOffsets_.clear();
+         setSortHint(previousOrder);
+      }
+
+      // Keep the local trees before the stitching so update() can rebuild
+      // only the partitions touched by the changed vertices.
+      inline void setIncrementalUpdate(bool u)
+      {
+         incrementalUpdate_ = u;
+         if (!u) {
+            vect_partitions_.clear();
+         }
+      }
+
+      // Sort the vertices inside their partition instead of globally: seeds
+      // are quantiles of a sample, the vertices are bucketed by value and each
+      // partition sorts its bucket while the overlap is computed.
+      // A warm start, when available, is used instead; the sort cache is not.
+      inline void setPartitionSort(bool p)
+      {
+         partitionSort_ = p;
+      }
+
+      // Place the seeds so that the partitions have the same predicted work
+      // (main range plus overlaps) instead of the same number of vertices.
+      // Not used with the partition sort, whose seeds come before the order.
+      inline void setWorkBalance(bool b)
+      {
+         workBalance_ = b;
+      }
+
+      // cost of a local extremum in the predicted work, a regular vertex costs 1
+      inline void setCriticalWeight(double w)
+      {
+         criticalWeight_ = w;
+      }
+
+      // correct the predicted work with the speed of each partition
+      // measured during the last build
+      inline void setSpeedFeedback(bool f)
+      {
+         speedFeedback_ = f;
+         if (!f) {
+            feedbackBounds_.clear();
+            feedbackSpeed_.clear();
+         }
+      }
+
+      // Move each seed, within half a partition of its equal count position,
+      // to a smaller level set: a seed moved by d vertices with an overlap of
+      // k vertices costs d + w * k. 0 keeps the equal count positions.
+      // Not used with the work balance, which already counts the overlaps.
+      inline void setOverlapWeight(double w)
+      {
+         overlapWeight_ = w;
+      }
+
+      // Two-level contour forest: the partitions are split in nbGroups groups
+      // of consecutive ranges (e.g. one per socket). The interfaces inside the
+      // groups are stitched first, the groups in parallel, then the interfaces
+      // between the groups. 1: a single level.
+      inline void setNbGroups(const unsigned nbGroups)
+      {
+         nbGroups_ = max(1u, min(nbGroups, (unsigned)numeric_limits<idPartition>::max()));
+      }
+
+      // The partitions read the scalars and the SoS offsets from a copy
+      // local to their NUMA node. Without effect on a single node.
+      inline void setNumaReplication(bool r)
+      {
+         numaReplication_ = r;
+      }
+
+      // Pin the threads building the partitions and their merge trees:
+      // compact, scatter or a list of cores (0,2,4-7). Empty: not pinned.
+      inline void setThreadAffinity(const string &affinity)
+      {
+         threadAffinity_ = affinity;
+      }
+
+      inline bool needJoinTree(void) const
+      {
+         return computeContourTree_ || treeSelection_ != TreeSelection::Split;
+      }
+
+      inline bool needSplitTree(void) const
+      {
+         return computeContourTree_ || treeSelection_ != TreeSelection::Join;
+      }
+
       // }
 
       // Init
       // {
       void initInterfaces();
 
+      // Sorted positions of the seeds minimizing the maximal predicted work
+      void getBalancedSeeds(vector<idVertex> &seedPos);
+
+      // Sorted positions of the seeds trading balance for smaller overlaps
+      void getSmallOverlapSeeds(vector<idVertex> &seedPos);
+
+      // For a seed at each sorted position: number of vertices in its lower and
+      // upper overlap (size nbVert + 1). work is the prefix sum of the vertices
+      // cost, a local extremum costing criticalWeight_.
+      void getOverlapProfile(vector<idVertex> &lowerCount, vector<idVertex> &upperCount,
+                             vector<double> &work);
+
       void initOverlap();
 
+      // move the border vertices found by each thread in the interfaces, sorted
+      void fillOverlap(vector<vector<vector<idVertex>>> &lowers,
+                       vector<vector<vector<idVertex>>> &uppers);
+
+      // sortInput + initInterfaces + initOverlap without a global sort
+      template <typename scalarType>
+      void partitionSort(void);
+
       template <typename scalarType>
       void initLocalCT(decltype(nbPartitions_) i);
 
+      // called by the thread building the partition, which first touches
+      // its buffers (the union-find of each merge tree is allocated by its task)
+      template <typename scalarType>
+      void initPartition(const idPartition &i, const double threshold);
+
+      // point the local tree to the copies of the NUMA node of the calling thread
+      template <typename scalarType>
+      void initNumaReplica(const idPartition &i);
+
       void flush(void);
 
+      // delete the union-find objects of a merge tree build and release
+      // the vertex table pointing to them
+      static void clearUnionFind(vector<ExtendedUnionFind *> &vect_UF);
+
+      // largest partitions first: with more partitions than threads,
+      // the dynamic schedule ends with the small ones
+      void sortBySize(vector<idPartition> &partitions) const;
+
       //}
 
       // Process
@@ -187,13 +418,42 @@ namespace wtfit
       template <typename scalarType>
       int build(const bool ct, const bool segment, const double threshold);
 
+      // Update the forest of the last build (setIncrementalUpdate(true)) after
+      // the values of changedVertices have changed in the scalar field.
+      // Only the partitions whose range or overlap contain a changed vertex
+      // (before or after the change) are rebuilt, the others are restored.
+      // The seeds are kept: if one of them changed, a full build is done.
+      // threshold must be the one of the last build. With a simplification
+      // threshold, the result matches a build using the same seeds.
+      template <typename scalarType>
+      int update(const vector<idVertex> &changedVertices, const double threshold);
+
       template <typename scalarType>
-      int parallelBuild(vector<vector<ExtendedUnionFind *>> &baseUF_JT,
-                        vector<vector<ExtendedUnionFind *>> &baseUF_ST, const double threshold);
+      int parallelBuild(const vector<idPartition> &partitions, const double threshold);
+
+      // Move the changed vertices (sorted by previous position) to their
+      // new place in sortedVertices_ and update mirrorOffsets_
+      template <typename scalarType>
+      void updateOrder(const vector<idVertex> &changed);
+
+      // Recompute the overlap of the interfaces for the border vertices
+      // (changed vertices and their neighbors, sorted by id), before is their
+      // membership before the change. Mark the partitions using a modified overlap.
+      void updateOverlap(const vector<idVertex> &border, const vector<char> &changedBorder,
+                         const vector<char> &before, vector<char> &toBuild);
+      void getOverlapMembership(const vector<idVertex> &border, vector<char> &membership);
+
+      void savePartition(const idPartition &i);
+      void restorePartition(const idPartition &i);
+      void copyPartitionVert2Tree(const idPartition &i, const bool save);
 
       void stitch(void);
       void stitchTree(const char tree);
 
+      // stitch the arcs crossing above the partition i, from the firstArc-th
+      // one, with the tree above. Returns the number of crossing arcs.
+      size_t stitchInterface(const char tree, const idInterface i, const size_t firstArc);
+
       // replace distributed tree by a global one, will be removed
       void unify();
       void unifyCT();
@@ -40,6 +40,196 @@ void ParallelContourTree::initLocalCT(decltype(nbPartitions_) i)
    vect_ct_[i].flush();
 }
 
+template <typename scalarType>
+void ParallelContourTree::initPartition(const idPartition &i, const double threshold)
+{
+   const auto nbVert = mesh_->getNumberOfVertices();
+
+   // CT
+   initLocalCT<scalarType>(i);
+   initNumaReplica<scalarType>(i);
+   vect_ct_[i].initDataMT<scalarType>();
+
+   // on the fly pruning
+   vect_ct_[i].jt_->setPruneThreshold<scalarType>((pruneOnTheFly_) ? threshold : 0);
+   vect_ct_[i].st_->setPruneThreshold<scalarType>((pruneOnTheFly_) ? threshold : 0);
+
+   // JT
+   if (needJoinTree()) {
+      vect_ct_[i].jt_->vect_nodes_.reserve((nbVert / nbPartitions_) / 10);
+      vect_ct_[i].jt_->vect_superArcs_.reserve((nbVert / nbPartitions_) / 10);
+   }
+
+   // ST
+   if (needSplitTree()) {
+      vect_ct_[i].st_->vect_nodes_.reserve((nbVert / nbPartitions_) / 10);
+      vect_ct_[i].st_->vect_superArcs_.reserve((nbVert / nbPartitions_) / 10);
+   }
+}
+
+template <typename scalarType>
+void ParallelContourTree::initNumaReplica(const idPartition &i)
+{
+   if (numaScalars_.empty() || !soSOffsets_) {
+      return;
+   }
+
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+   const int      node   = OsCall::getCurrentNumaNode();
+   if (node >= (int)numaScalars_.size()) {
+      return;
+   }
+
+   {
+      // the first partition of the node makes the copy, on this node
+      lock_guard<mutex> lock(numaLock_);
+      if (numaScalars_[node].empty()) {
+         const char *scalars = (const char *)scalars_;
+         numaScalars_[node].assign(scalars, scalars + nbVert * sizeof(scalarType));
+         numaOffsets_[node].assign(soSOffsets_, soSOffsets_ + nbVert);
+      }
+   }
+
+   // initDataMT gives them to the merge trees
+   vect_ct_[i].setVertexScalars<scalarType>((scalarType *)numaScalars_[node].data());
+   vect_ct_[i].setVertexSoSoffsets(numaOffsets_[node].data());
+}
+
+template <typename scalarType>
+void ParallelContourTree::partitionSort(void)
+{
+   const idVertex nbVert  = mesh_->getNumberOfVertices();
+   const idEdge   nbEdges = mesh_->getNumberOfEdges();
+
+   // if we choose to have less partition, we still want to use all thread for the sort.
+   const unsigned nbThreadSort = getNbThreadReal();
+
+   auto isLowerComp = [&](const idVertex &a, const idVertex &b) {
+      return isLower<scalarType>(a, b);
+   };
+
+   // ------------------
+   // Seeds
+   // ------------------
+   // {
+
+   // quantiles of a regular sample of the vertices: seed i is the lowest
+   // vertex of partition i + 1. build() keeps nbPartitions_ <= nbVert, so
+   // there are at least as many samples as partitions and the seeds are
+   // distinct: no partition is empty
+   const idVertex   nbSamples = min(nbVert, (idVertex)nbPartitions_ * 256);
+   vector<idVertex> samples(nbSamples);
+   for (idVertex s = 0; s < nbSamples; ++s) {
+      samples[s] = (2ll * s + 1) * nbVert / (2ll * nbSamples);
+   }
+   sort(samples.begin(), samples.end(), isLowerComp);
+
+   vector<idVertex> seeds(nbInterfaces_);
+   for (decltype(nbInterfaces_) i = 0; i < nbInterfaces_; ++i) {
+      seeds[i] = samples[(long long)(i + 1) * nbSamples / nbPartitions_];
+      vect_interfaces_.emplace_back(seeds[i]);
+   }
+
+   // }
+   // ------------------
+   // Buckets
+   // ------------------
+   // {
+
+   // vertex v goes in partition p if seed p-1 <= v < seed p
+   vector<idPartition>      partition(nbVert);
+   vector<vector<idVertex>> offsets(nbThreadSort, vector<idVertex>(nbPartitions_, 0));
+   vector<idVertex>         bucketStart(nbPartitions_ + 1, 0);
+
+   sortedVertices_.resize(nbVert);
+   mirrorOffsets_.resize(nbVert);
+
+   Executor *executor = getExecutor();
+
+   // both loops use the same chunks: a chunk scatters the vertices it counted
+   executor->parallelChunks(
+       nbThreadSort, 0, nbVert, [&](const unsigned &chunk, const idVertex &first, const idVertex &last) {
+          vector<idVertex> &chunkOffsets = offsets[chunk];
+          for (idVertex v = first; v < last; ++v) {
+             partition[v] = upper_bound(seeds.cbegin(), seeds.cend(), v, isLowerComp) - seeds.cbegin();
+             ++chunkOffsets[partition[v]];
+          }
+       });
+
+   idVertex start = 0;
+   for (idPartition p = 0; p < nbPartitions_; ++p) {
+      bucketStart[p] = start;
+      for (unsigned c = 0; c < nbThreadSort; ++c) {
+         const idVertex count = offsets[c][p];
+         offsets[c][p]        = start;
+         start += count;
+      }
+   }
+   bucketStart[nbPartitions_] = start;
+
+   executor->parallelChunks(
+       nbThreadSort, 0, nbVert, [&](const unsigned &chunk, const idVertex &first, const idVertex &last) {
+          vector<idVertex> &chunkOffsets = offsets[chunk];
+          for (idVertex v = first; v < last; ++v) {
+             sortedVertices_[chunkOffsets[partition[v]]++] = v;
+          }
+       });
+
+   // }
+   // ------------------
+   // Local sort & overlap
+   // ------------------
+   // {
+
+   vector<vector<vector<idVertex>>> lowers(nbThreadSort);
+   vector<vector<vector<idVertex>>> uppers(nbThreadSort);
+
+   for (unsigned t = 0; t < nbThreadSort; t++) {
+      lowers[t].resize(nbInterfaces_);
+      uppers[t].resize(nbInterfaces_);
+   }
+
+   // each bucket is sorted on its own: there is no global merge, and
+   // the bucket offsets give the mirror
+   executor->parallelFor(0, nbPartitions_, [&](const idPartition &p) {
+      sort(sortedVertices_.begin() + bucketStart[p], sortedVertices_.begin() + bucketStart[p + 1],
+           isLowerComp);
+      for (idVertex pos = bucketStart[p]; pos < bucketStart[p + 1]; ++pos) {
+         mirrorOffsets_[sortedVertices_[pos]] = pos;
+      }
+   }, nbThreadSort, 1);
+
+   // an edge crosses all the interfaces between the partitions of its extremities
+   executor->parallelChunks(
+       nbThreadSort, 0, nbEdges, [&](const unsigned &chunk, const idEdge &first, const idEdge &last) {
+          for (idEdge e = first; e < last; e++) {
+             idVertex v0, v1;
+             mesh_->getEdgeVertex(e, 0, v0);
+             mesh_->getEdgeVertex(e, 1, v1);
+
+             if (partition[v0] == partition[v1]) {
+                continue;
+             }
+             if (partition[v0] > partition[v1]) {
+                swap(v0, v1);
+             }
+
+             for (idInterface i = partition[v0]; i < partition[v1]; i++) {
+                uppers[chunk][i].emplace_back(v1);
+                lowers[chunk][i].emplace_back(v0);
+             }
+          }
+       });
+
+   // }
+
+   destroyVectorSortedVertices_ = true;
+   // not used by this sort
+   vector<idVertex>().swap(sortHint_);
+
+   fillOverlap(lowers, uppers);
+}
+
 // }
 
 // Process
@@ -49,16 +239,22 @@ template <typename scalarType>
 int ParallelContourTree::build(const bool ct, const bool segment, const double threshold)
 {
 #ifdef withOpenMP
-    if(lessPartition_)
-        omp_set_num_threads(nbPartitions_*2);
-    else
-        omp_set_num_threads(nbPartitions_);
+   // the size of the teams is given to the executor otherwise
+   if (!executor_) {
+      omp_set_num_threads(getNbThreadReal());
+   }
+#endif
 
-// Get number of proc <- find number of socket for NUMA ??
-// omp_get_num_procs();
+   // pinned threads until the end of the build
+   ExecutorAffinity affinity(getExecutor(), Executor::getAffinityCores(threadAffinity_));
 
-// std::thread::hardware_concurrency();
-#endif
+   // copies made by the partitions, see initNumaReplica
+   numaScalars_.clear();
+   numaOffsets_.clear();
+   if (numaReplication_ && OsCall::getNumberOfNumaNodes() > 1) {
+      numaScalars_.resize(OsCall::getNumberOfNumaNodes());
+      numaOffsets_.resize(OsCall::getNumberOfNumaNodes());
+   }
 
    if (debugLevel_ > 3) {
        cout << " nb partition : " << static_cast<unsigned>(nbPartitions_);
@@ -74,6 +270,16 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
    setSegmentation(segment);
    setComputeContourTree(ct);
 
+   // a partition has at least one vertex, otherwise seeds would be shared
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+   if (nbVert && (idVertex)nbPartitions_ > nbVert) {
+      stringstream msg;
+      msg << "[ParallelContourTree] " << static_cast<unsigned>(nbPartitions_)
+          << " partitions for " << nbVert << " vertices, use " << nbVert << endl;
+      dMsg(cout, msg.str(), infoMsg);
+      setNbPartitions(nbVert);
+   }
+
    // reserve interface partition et cts
    flush();
    vector<idVertex> seeds;
@@ -82,11 +288,22 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
 
    DebugTimer timerTOTAL;
 
+   // the partitions sort their own vertices, unless the order is known or
+   // cheap to recompute. The sort cache, which stores global orders, is not
+   // looked up.
+   const bool localSort = partitionSort_ && nbPartitions_ > 1 && sortedVertices_.empty() &&
+                          sortHint_.empty();
+
    DebugTimer timerSort;
-   sortInput<scalarType>();
-   printDebug(timerSort, "Sort                             ");
+   if (localSort) {
+      partitionSort<scalarType>();
+      printDebug(timerSort, "Partition sort & overlap         ");
+   } else {
+      sortInput<scalarType>();
+      printDebug(timerSort, "Sort                             ");
 
-   initInterfaces();
+      initInterfaces();
+   }
 
    // {
    // cross edges to initialize overlap bounds
@@ -106,7 +323,9 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
    // }
 
    DebugTimer timerInitOverlap;
-   initOverlap();
+   if (!localSort) {
+      initOverlap();
+   }
    if(debugLevel_ > 2){
         for (unsigned i = 0; i < nbInterfaces_; i++) {
             cout << "interface : " << i;
@@ -116,40 +335,30 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
    }
    printDebug(timerInitOverlap, "Initialize Overlap               ");
 
-   DebugTimer                          timerAllocPara;
-   vector<vector<ExtendedUnionFind *>> vect_baseUF_JT(nbPartitions_), vect_baseUF_ST(nbPartitions_);
-   const auto nbVert = mesh_->getNumberOfVertices();
-
-#pragma omp parallel for num_threads(nbPartitions_) schedule(static)
-   for (decltype(nbPartitions_) tree = 0; tree < nbPartitions_; ++tree) {
-      // CT
-      initLocalCT<scalarType>(tree);
-      vect_ct_[tree].initDataMT<scalarType>();
-
-      // JT
-      vect_ct_[tree].jt_->vect_nodes_.reserve((nbVert / nbPartitions_) / 10);
-      vect_ct_[tree].jt_->vect_superArcs_.reserve((nbVert / nbPartitions_) / 10);
-
-      // ST
-      vect_ct_[tree].st_->vect_nodes_.reserve((nbVert / nbPartitions_) / 10);
-      vect_ct_[tree].st_->vect_superArcs_.reserve((nbVert / nbPartitions_) / 10);
-
-      // Big reserve
-      vect_baseUF_JT[tree].resize(nbVert);
-      vect_baseUF_ST[tree].resize(nbVert);
-   }
-   printDebug(timerAllocPara, "Alloc parallel                   ");
+   // the partitions are allocated by the threads building them
+   vector<idPartition> partitions(nbPartitions_);
+   iota(partitions.begin(), partitions.end(), 0);
+   sortBySize(partitions);
 
    DebugTimer timerbuild;
-   parallelBuild<scalarType>(vect_baseUF_JT, vect_baseUF_ST, threshold);
+   parallelBuild<scalarType>(partitions, threshold);
    printDebug(timerbuild, "ParallelBuild                    ");
 
+   // keep the local trees for update()
+   vect_partitions_.clear();
+   if (incrementalUpdate_ && computeContourTree_ && nbPartitions_ > 1 && partitionNum_ == -1) {
+      vect_partitions_.resize(nbPartitions_);
+      getExecutor()->parallelFor(0, nbPartitions_, [&](const idPartition &tree) {
+         savePartition(tree);
+      }, nbThread_, 1);
+   }
+
    DebugTimer timerZip;
    if (computeContourTree_ && nbPartitions_ > 1 && partitionNum_ == -1) {
       stitch();
-      for (unsigned p = 0; p < nbPartitions_; ++p) {
-         vect_ct_[p].parallelInitNodeValence(nbPartitions_);
-      }
+      getExecutor()->parallelFor(0, nbPartitions_, [&](const idPartition &p) {
+         vect_ct_[p].parallelInitNodeValence(1);
+      }, nbThread_, 1);
    }
    printDebug(timerZip, "Stitch                           ");
 
@@ -158,7 +367,7 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
    }
 
 
-   const unsigned nbThreadReal = (lessPartition_)?nbPartitions_*2:nbPartitions_;
+   const unsigned nbThreadReal = getNbThreadReal();
 
    // Unify to create a normal tree for wrapper / test
    DebugTimer timerUnify;
@@ -178,23 +387,27 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
        }
 
    } else {
+       idPartition shown = 0;
        if(partitionNum_ != -1){
            if(partitionNum_ > nbInterfaces_){
-              jt_ = vect_ct_[nbInterfaces_].jt_->clone();
-              st_ = vect_ct_[nbInterfaces_].st_->clone();
+              shown = nbInterfaces_;
            } else {
-              jt_ = vect_ct_[partitionNum_].jt_->clone();
-              st_ = vect_ct_[partitionNum_].st_->clone();
+              shown = partitionNum_;
            }
        } else {
           if (nbThread_ > 1) {
              cout << "Only partition 1 shown !" << endl;
           }
-          jt_ = vect_ct_[0].jt_->clone();
-          st_ = vect_ct_[0].st_->clone();
        }
-       jt_->parallelInitNodeValence(nbThreadReal);
-       st_->parallelInitNodeValence(nbThreadReal);
+       // only clone the merge trees that have been built
+       if (needJoinTree()) {
+          jt_ = vect_ct_[shown].jt_->clone();
+          jt_->parallelInitNodeValence(nbThreadReal);
+       }
+       if (needSplitTree()) {
+          st_ = vect_ct_[shown].st_->clone();
+          st_->parallelInitNodeValence(nbThreadReal);
+       }
    }
 
    printDebug(timerUnify, "Create Contour tree              ");
@@ -216,10 +429,14 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
         if(ct)
            printTree2();
         else {
-           cout << "JT :" << endl;
-           jt_->printTree2();
-           cout << "ST :" << endl;
-           st_->printTree2();
+           if (needJoinTree()) {
+              cout << "JT :" << endl;
+              jt_->printTree2();
+           }
+           if (needSplitTree()) {
+              cout << "ST :" << endl;
+              st_->printTree2();
+           }
         }
     }
 
@@ -236,8 +453,10 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
    if(ct){
       updateSegmentation(true);
    } else {
-      jt_->updateSegmentation();
-      st_->updateSegmentation();
+      if (needJoinTree())
+         jt_->updateSegmentation();
+      if (needSplitTree())
+         st_->updateSegmentation();
    }
 
    cout << "Contour Tree computed " << endl;
@@ -246,245 +465,505 @@ int ParallelContourTree::build(const bool ct, const bool segment, const double t
 }
 
 template <typename scalarType>
-int ParallelContourTree::parallelBuild(vector<vector<ExtendedUnionFind *>> &vect_baseUF_JT,
-                                       vector<vector<ExtendedUnionFind *>> &vect_baseUF_ST,
-                                       const double                         threshold)
+int ParallelContourTree::update(const vector<idVertex> &changedVertices, const double threshold)
 {
-   const auto &nbVert = mesh_->getNumberOfVertices();
-   vector<float> timeSimplify(nbPartitions_, 0);
-   vector<float> speedProcess(nbPartitions_*2, 0);
-   idEdge nbPairMerged = 0;
+   const idVertex nbVert = mesh_->getNumberOfVertices();
+
+   // the local trees of the last build are needed
+   bool fullBuild = !incrementalUpdate_ || !computeContourTree_ || nbPartitions_ == 1 ||
+                    partitionNum_ != -1 || vect_partitions_.size() != nbPartitions_ ||
+                    sortedVertices_.size() != (size_t)nbVert;
+
+   auto isLowerComp = [&](const idVertex &a, const idVertex &b) { return isLower(a, b); };
+
+   // changed vertices, by previous position
+   vector<idVertex> changed(changedVertices);
+   if (!fullBuild) {
+      sort(changed.begin(), changed.end(), isLowerComp);
+      changed.erase(unique(changed.begin(), changed.end()), changed.end());
+
+      // interfaces keep their seed
+      for (const Interface &interface : vect_interfaces_) {
+         if (binary_search(changed.cbegin(), changed.cend(), interface.getSeed(), isLowerComp)) {
+            fullBuild = true;
+            break;
+         }
+      }
+   }
+
+   if (fullBuild) {
+      // at least, the previous order is a good start for the sort
+      vector<idVertex> previousOrder;
+      previousOrder.swap(sortedVertices_);
+      warmStart(previousOrder);
+      return build<scalarType>(computeContourTree_, segmentation_, threshold);
+   }
+
+   if (changed.empty()) {
+      return 0;
+   }
+
+   // pinned threads until the end of the update
+   ExecutorAffinity affinity(getExecutor(), Executor::getAffinityCores(threadAffinity_));
 
 #ifdef withOpenMP
-   omp_set_nested(1);
+   if (!executor_) {
+      omp_set_num_threads(getNbThreadReal());
+   }
 #endif
 
-//cout << "NO PARALLEL DEBUG MODE" << endl;
-#pragma omp parallel for num_threads(nbPartitions_) schedule(static)
-   for (int i = 0; i < nbPartitions_; ++i) {
-      DebugTimer timerMergeTree;
+   DebugTimer timerTOTAL;
 
-       //if(i<nbInterfaces_)
-       //cout << vect_interfaces_[i].getSeed()
-      //<< " , pos : " << mirrorOffsets_[vect_interfaces_[i].getSeed()] << endl;
+   // -----------------------
+   // Order & overlap
+   // -----------------------
+   // {
 
-      const idVertex &startJT =
-          (i == 0) ? 0 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
-      const idVertex &startST =
-          (i == nbInterfaces_) ? nbVert - 1 : mirrorOffsets_[vect_interfaces_[i].getSeed()]-1;
+   DebugTimer timerSort;
 
-      const idVertex &endJT =
-          (i == nbInterfaces_) ? nbVert : mirrorOffsets_[vect_interfaces_[i].getSeed()];
-      const idVertex &endST =
-          (i == 0) ? -1 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()] - 1;
+   // changed vertices and their neighbors may enter or leave an overlap
+   vector<idVertex> border;
+   for (const idVertex &v : changed) {
+      border.emplace_back(v);
+      const idVertex nbNeigh = mesh_->getVertexNeighborNumber(v);
+      for (idVertex n = 0; n < nbNeigh; ++n) {
+         idVertex neigh;
+         mesh_->getVertexNeighbor(v, n, neigh);
+         border.emplace_back(neigh);
+      }
+   }
+   sort(border.begin(), border.end());
+   border.erase(unique(border.begin(), border.end()), border.end());
 
-      const idVertex &posSeed0 = (i == 0) ? -1 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
-      const idVertex &posSeed1 =
-          (i == nbInterfaces_) ? nullVertex : mirrorOffsets_[vect_interfaces_[i].getSeed()];
+   vector<char> changedBorder(border.size(), 0);
+   for (const idVertex &v : changed) {
+      changedBorder[lower_bound(border.cbegin(), border.cend(), v) - border.cbegin()] = 1;
+   }
 
-      const vector<idVertex> &lowerOverlap =
-          (i == 0) ? vector<idVertex>() : vect_interfaces_[i - 1].getLower();
+   vector<char> before;
+   getOverlapMembership(border, before);
 
-      const vector<idVertex> &upperOverlap =
-          (i == nbInterfaces_) ? vector<idVertex>() : vect_interfaces_[i].getUpper();
+   // positions before the change
+   vector<idVertex> oldPos(changed.size()), oldSeedPos(nbInterfaces_);
+   for (size_t c = 0; c < changed.size(); ++c) {
+      oldPos[c] = mirrorOffsets_[changed[c]];
+   }
+   for (idInterface i = 0; i < nbInterfaces_; ++i) {
+      oldSeedPos[i] = mirrorOffsets_[vect_interfaces_[i].getSeed()];
+   }
 
-      const idVertex partitionSize =
-          abs(endJT - startJT) + lowerOverlap.size() + upperOverlap.size();
+   updateOrder<scalarType>(changed);
 
-      if (lessPartition_) {
-#pragma omp parallel sections num_threads(2)
-         {
-#pragma omp section
-            {
-                DebugTimer timerSimplify;
-                DebugTimer timerBuild;
-               vect_ct_[i].getJoinTree()->build(vect_baseUF_JT[i], lowerOverlap, upperOverlap,
-                                                startJT, endJT, posSeed0, posSeed1);
-               speedProcess[i] = partitionSize / timerBuild.getElapsedTime();
-
-               timerSimplify.reStart();
-               const idEdge tmpMerge =
-                   vect_ct_[i].getJoinTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
-#pragma omp atomic update
-               timeSimplify[i] += timerSimplify.getElapsedTime();
-#pragma omp atomic update
-               nbPairMerged += tmpMerge;
+   vector<idVertex> newSeedPos(nbInterfaces_);
+   for (idInterface i = 0; i < nbInterfaces_; ++i) {
+      newSeedPos[i] = mirrorOffsets_[vect_interfaces_[i].getSeed()];
+   }
 
-            }
+   printDebug(timerSort, "Update order                     ");
 
-#pragma omp section
-            {
-               DebugTimer timerSimplify;
-               DebugTimer timerBuild;
-               vect_ct_[i].getSplitTree()->build(vect_baseUF_ST[i], upperOverlap, lowerOverlap,
-                                                 startST, endST, posSeed0, posSeed1);
-               speedProcess[nbPartitions_ + i] = partitionSize / timerBuild.getElapsedTime();
-
-               timerSimplify.reStart();
-               const idEdge tmpMerge =
-                   vect_ct_[i].getSplitTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
-#pragma omp atomic update
-               timeSimplify[i] += timerSimplify.getElapsedTime();
-#pragma omp atomic update
-               nbPairMerged += tmpMerge;
-            }
-         }
-      }
+   // partitions containing a changed vertex, before or after
+   vector<char> toBuild(nbPartitions_, 0);
+   for (size_t c = 0; c < changed.size(); ++c) {
+      const idVertex &newPos = mirrorOffsets_[changed[c]];
+      toBuild[upper_bound(oldSeedPos.cbegin(), oldSeedPos.cend(), oldPos[c]) - oldSeedPos.cbegin()] = 1;
+      toBuild[upper_bound(newSeedPos.cbegin(), newSeedPos.cend(), newPos) - newSeedPos.cbegin()] = 1;
+   }
+
+   DebugTimer timerOverlap;
+   updateOverlap(border, changedBorder, before, toBuild);
+   printDebug(timerOverlap, "Update overlap                   ");
+
+   // }
+   // -----------------------
+   // Local trees
+   // -----------------------
+   // {
 
-      else {
-         DebugTimer timerSimplify;
-         DebugTimer timerBuild;
-         vect_ct_[i].getJoinTree()->build(vect_baseUF_JT[i], lowerOverlap, upperOverlap, startJT,
-                                          endJT, posSeed0, posSeed1);
-         speedProcess[i] = partitionSize / timerBuild.getElapsedTime();
-
-         //if(nbPartitions_ > 1){
-             timerSimplify.reStart();
-             nbPairMerged +=
-                 vect_ct_[i].getJoinTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
-             timeSimplify[i] += timerSimplify.getElapsedTime();
-         //}
-
-         vect_ct_[i].getSplitTree()->build(vect_baseUF_ST[i], upperOverlap, lowerOverlap, startST,
-                                           endST, posSeed0, posSeed1);
-         speedProcess[nbPartitions_ + i] = partitionSize / timerBuild.getElapsedTime();
-
-         //if(nbPartitions_ > 1){
-             timerSimplify.reStart();
-             nbPairMerged +=
-                 vect_ct_[i].getSplitTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
-             timeSimplify[i] += timerSimplify.getElapsedTime();
-         //}
+   DebugTimer timerbuild;
+
+   // new values in the NUMA copies
+   for (size_t node = 0; node < numaScalars_.size(); ++node) {
+      if (numaScalars_[node].empty()) {
+         continue;
+      }
+      scalarType *replica = (scalarType *)numaScalars_[node].data();
+      for (const idVertex &v : changed) {
+         replica[v] = ((scalarType *)scalars_)[v];
       }
+   }
 
-      {
-         stringstream mt;
-         mt << "[ParallelBuild] Merge Tree " << static_cast<unsigned>(i)
-            << " constructed in : " << timerMergeTree.getElapsedTime() << endl;
-         dMsg(cout, mt.str(), infoMsg);
+   vector<idPartition> partitions;
+   for (idPartition p = 0; p < nbPartitions_; ++p) {
+      if (toBuild[p]) {
+         partitions.emplace_back(p);
+      } else {
+         restorePartition(p);
       }
+   }
 
-      if (segmentation_ && (threshold || !computeContourTree_)) {
-         DebugTimer timerUpdateSegm;
-         vect_ct_[i].getJoinTree()->updateSegmentation();
-         vect_ct_[i].getSplitTree()->updateSegmentation();
+   sortBySize(partitions);
 
-         if (debugLevel_ >= 3) {
-            cout << "Local MT : updated in " << timerUpdateSegm.getElapsedTime() << endl;
-         }
+   const int nbBuild = partitions.size();
+
+   parallelBuild<scalarType>(partitions, threshold);
+
+   getExecutor()->parallelFor(0, nbBuild, [&](const int &b) {
+      savePartition(partitions[b]);
+   }, nbThread_, 1);
+
+   if (debugLevel_ >= 1) {
+      cout << "Update : " << changed.size() << " vertices changed, ";
+      cout << nbBuild << " / " << static_cast<unsigned>(nbPartitions_) << " partitions rebuilt";
+      cout << endl;
+   }
+   printDebug(timerbuild, "ParallelBuild                    ");
+
+   // }
+   // -----------------------
+   // Stitch & unify
+   // -----------------------
+   // {
+
+   DebugTimer timerZip;
+   stitch();
+   getExecutor()->parallelFor(0, nbPartitions_, [&](const idPartition &p) {
+      vect_ct_[p].parallelInitNodeValence(1);
+   }, nbThread_, 1);
+   printDebug(timerZip, "Stitch                           ");
+
+   const unsigned nbThreadReal = getNbThreadReal();
+
+   DebugTimer timerUnify;
+   unifyCT();
+   parallelInitNodeValence(nbThreadReal);
+   printDebug(timerUnify, "Create Contour tree              ");
+
+   if (threshold) {
+      DebugTimer timerGlobalSimplify;
+      idEdge simplifed = globalSimplify<scalarType>(-1, nullVertex, threshold);
+      if (debugLevel_ >= 1) {
+         cout << "Global Simplification                                       "
+              << timerGlobalSimplify.getElapsedTime();
+         cout << " ( " << simplifed << " pairs merged )" << endl;
       }
+   }
 
-      if (0 || computeContourTree_) {
-         DebugTimer timerCombine;
+   updateSegmentation(true);
 
-         auto jt = vect_ct_[i].getJoinTree();
-         auto st = vect_ct_[i].getSplitTree();
+   // }
 
-         // Copy missing nodes of a tree to the other one
-         // Maintain this traversal order for good insertion
-         for (int t = 0; t < st->getNumberOfNodes(); ++t) {
-            if (!st->getNode(t)->isHidden()) {
-               // cout << "insert in jt : " << st->getNode(t)->getVertexId() << endl;
-               jt->insertNode(st->getNode(t), segmentation_);
-            }
-         }
-         // and vice versa
-         for (int t = 0; t < jt->getNumberOfNodes(); ++t) {
-            if (!jt->getNode(t)->isHidden()) {
-               // cout << "insert in st : " << jt->getNode(t)->getVertexId() << endl;
-               st->insertNode(jt->getNode(t), segmentation_);
-            }
-         }
+   printDebug(timerTOTAL, "TOTAL                            ");
 
-         if (debugLevel_ >= 6) {
-            cout << "Local JT :" << endl;
-            vect_ct_[i].getJoinTree()->printTree2();
-            cout << "Local ST :" << endl;
-            vect_ct_[i].getSplitTree()->printTree2();
-            cout << "combine" << endl;
-         }
+   return 0;
+}
 
-         if (0 || computeContourTree_) {
-            // DebugTimer timerNoise;
+template <typename scalarType>
+void ParallelContourTree::updateOrder(const vector<idVertex> &changed)
+{
+   const idVertex nbVert    = sortedVertices_.size();
+   const idVertex nbChanged = changed.size();
 
-            // here Arcs & Nodes of the merge tree are destroyed
-            vect_ct_[i].combine(posSeed0, posSeed1);
+   // previous positions of the changed vertices, increasing
+   vector<idVertex> oldPos(nbChanged);
+   for (idVertex c = 0; c < nbChanged; ++c) {
+      oldPos[c] = mirrorOffsets_[changed[c]];
+   }
 
-            vect_ct_[i].updateSegmentation(true);
+   // changed vertices in their new order
+   vector<idVertex> moved(changed);
+   sort(moved.begin(), moved.end(),
+        [&](const idVertex &a, const idVertex &b) { return isLower<scalarType>(a, b); });
+
+   // first position at or after pos holding an unchanged vertex
+   auto nextUnchanged = [&](idVertex pos) {
+      auto it = lower_bound(oldPos.cbegin(), oldPos.cend(), pos);
+      while (it != oldPos.cend() && *it == pos) {
+         ++it;
+         ++pos;
+      }
+      return pos;
+   };
+
+   // where v goes among the unchanged vertices, which are still sorted
+   auto insertPos = [&](const idVertex &v) {
+      idVertex lo = 0, hi = nbVert;
+      while (lo < hi) {
+         const idVertex mid   = lo + (hi - lo) / 2;
+         const idVertex probe = nextUnchanged(mid);
+         if (probe < hi && isLower<scalarType>(sortedVertices_[probe], v)) {
+            lo = probe + 1;
+         } else {
+            hi = mid;
+         }
+      }
+      return lo;
+   };
+
+   // only the window between the first and the last moved position is rewritten
+   const idVertex first = min(oldPos.front(), insertPos(moved.front()));
+   const idVertex last  = max(oldPos.back() + 1, insertPos(moved.back()));
+
+   vector<idVertex> window;
+   window.reserve(last - first);
+
+   auto itOld   = oldPos.cbegin();
+   auto itMoved = moved.cbegin();
+   for (idVertex pos = first; pos < last; ++pos) {
+      if (itOld != oldPos.cend() && *itOld == pos) {
+         ++itOld;
+         continue;
+      }
+      const idVertex &v = sortedVertices_[pos];
+      while (itMoved != moved.cend() && isLower<scalarType>(*itMoved, v)) {
+         window.emplace_back(*itMoved++);
+      }
+      window.emplace_back(v);
+   }
+   window.insert(window.end(), itMoved, moved.cend());
 
-            //vect_ct_[i].initNodeValence();
+   copy(window.cbegin(), window.cend(), sortedVertices_.begin() + first);
+   for (idVertex pos = first; pos < last; ++pos) {
+      mirrorOffsets_[sortedVertices_[pos]] = pos;
+   }
+}
 
-            if(debugLevel_ >2){
-                printDebug(timerCombine, "Trees combined   in    ");
+template <typename scalarType>
+int ParallelContourTree::parallelBuild(const vector<idPartition> &partitions,
+                                       const double               threshold)
+{
+   const auto &nbVert = mesh_->getNumberOfVertices();
+   vector<vector<ExtendedUnionFind *>> vect_baseUF_JT(nbPartitions_), vect_baseUF_ST(nbPartitions_);
+   vector<float> timeSimplify(nbPartitions_*2, 0);
+   vector<float> speedProcess(nbPartitions_*2, 0);
+   vector<float> partitionSpeed(nbPartitions_, 0);
+   atomic<idEdge> nbPairMerged(0);
+
+   const int nbBuild = partitions.size();
+
+   Executor *executor = getExecutor();
+
+   // Each partition is a task, whose merge trees (build and local simplification)
+   // are two independent child tasks: idle threads take the pending trees of any
+   // partition. The combination of a partition waits for its two trees only.
+   executor->run([&]() {
+      for (int b = 0; b < nbBuild; ++b) {
+         executor->spawn([&, b]() {
+            const int i = partitions[b];
+            DebugTimer timerMergeTree;
+
+            // first touch of the partition buffers by this thread
+            initPartition<scalarType>(i, threshold);
+
+             //if(i<nbInterfaces_)
+             //cout << vect_interfaces_[i].getSeed()
+            //<< " , pos : " << mirrorOffsets_[vect_interfaces_[i].getSeed()] << endl;
+
+            const idVertex startJT =
+                (i == 0) ? 0 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
+            const idVertex startST =
+                (i == nbInterfaces_) ? nbVert - 1 : mirrorOffsets_[vect_interfaces_[i].getSeed()]-1;
+
+            const idVertex endJT =
+                (i == nbInterfaces_) ? nbVert : mirrorOffsets_[vect_interfaces_[i].getSeed()];
+            const idVertex endST =
+                (i == 0) ? -1 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()] - 1;
+
+            const idVertex posSeed0 = (i == 0) ? -1 : mirrorOffsets_[vect_interfaces_[i - 1].getSeed()];
+            const idVertex posSeed1 =
+                (i == nbInterfaces_) ? nullVertex : mirrorOffsets_[vect_interfaces_[i].getSeed()];
+
+            const vector<idVertex> noOverlap;
+            const vector<idVertex> &lowerOverlap =
+                (i == 0) ? noOverlap : vect_interfaces_[i - 1].getLower();
+
+            const vector<idVertex> &upperOverlap =
+                (i == nbInterfaces_) ? noOverlap : vect_interfaces_[i].getUpper();
+
+            const idVertex partitionSize =
+                abs(endJT - startJT) + lowerOverlap.size() + upperOverlap.size();
+
+            if (needJoinTree()) {
+               executor->spawn([&]() {
+                  vect_baseUF_JT[i].resize(nbVert);
+
+                  DebugTimer timerBuild;
+                  vect_ct_[i].getJoinTree()->build(vect_baseUF_JT[i], lowerOverlap, upperOverlap,
+                                                   startJT, endJT, posSeed0, posSeed1);
+                  speedProcess[i] = partitionSize / timerBuild.getElapsedTime();
+                  // the sweep is over: release the N-sized table early
+                  clearUnionFind(vect_baseUF_JT[i]);
+
+                  DebugTimer   timerSimplify;
+                  const idEdge tmpMerge =
+                      vect_ct_[i].getJoinTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
+                  timeSimplify[i] = timerSimplify.getElapsedTime();
+                  nbPairMerged += tmpMerge;
+
+                  if (segmentation_ && (threshold || !computeContourTree_)) {
+                     vect_ct_[i].getJoinTree()->updateSegmentation();
+                  }
+               });
             }
 
-            if (debugLevel_ >= 4) {
-               vect_ct_[i].printTree2();
+            if (needSplitTree()) {
+               executor->spawn([&]() {
+                  vect_baseUF_ST[i].resize(nbVert);
+
+                  DebugTimer timerBuild;
+                  vect_ct_[i].getSplitTree()->build(vect_baseUF_ST[i], upperOverlap, lowerOverlap,
+                                                    startST, endST, posSeed0, posSeed1);
+                  speedProcess[nbPartitions_ + i] = partitionSize / timerBuild.getElapsedTime();
+                  // the sweep is over: release the N-sized table early
+                  clearUnionFind(vect_baseUF_ST[i]);
+
+                  DebugTimer   timerSimplify;
+                  const idEdge tmpMerge =
+                      vect_ct_[i].getSplitTree()->localSimplify<scalarType>(posSeed0, posSeed1, threshold);
+                  timeSimplify[nbPartitions_ + i] = timerSimplify.getElapsedTime();
+                  nbPairMerged += tmpMerge;
+
+                  if (segmentation_ && (threshold || !computeContourTree_)) {
+                     vect_ct_[i].getSplitTree()->updateSegmentation();
+                  }
+               });
             }
 
-            //if (nbPartitions_ > 1) {
-               //DebugTimer   timerSimplify;
-               //const idEdge tmpMerge =
-                   //vect_ct_[i].globalSimplify<scalarType>(posSeed0, posSeed1, threshold);
-//#pragma omp atomic update
-               //timeSimplify[i] += timerSimplify.getElapsedTime();
-//#pragma omp atomic update
-               //nbPairMerged += tmpMerge;
+            // this thread can run other tasks meanwhile
+            executor->wait();
 
-               //vect_ct_[i].updateSegmentation(true);
+            {
+               stringstream mt;
+               mt << "[ParallelBuild] Merge Tree " << static_cast<unsigned>(i)
+                  << " constructed in : " << timerMergeTree.getElapsedTime() << endl;
+               dMsg(cout, mt.str(), infoMsg);
+            }
 
-               //vect_ct_[i].initNodeValence();
-            //}
-         }
-      } else {
-         // cout << "JT crossing below : " << endl;
-         // for(auto & arc : vect_ct_[i].getJoinTree()->vect_arcsCrossingBelow_){
-         // SuperArc * a = vect_ct_[i].getJoinTree()->getSuperArc(arc);
-         // cout << vect_ct_[i].getJoinTree()->getNode(a->getDownNodeId())->getVertexId();
-         // cout << " - ";
-         // cout << vect_ct_[i].getJoinTree()->getNode(a->getUpNodeId())->getVertexId();
-         // cout << " :: " << a->getOverlapBelow();
-         // cout << endl;
-         //}
-
-         // cout << "JT crossing above : " << endl;
-         // for(auto & arc : vect_ct_[i].getJoinTree()->vect_arcsCrossingAbove_){
-         // SuperArc * a = vect_ct_[i].getJoinTree()->getSuperArc(arc);
-         // cout << vect_ct_[i].getJoinTree()->getNode(a->getDownNodeId())->getVertexId();
-         // cout << " - ";
-         // cout << vect_ct_[i].getJoinTree()->getNode(a->getUpNodeId())->getVertexId();
-         // cout << " :: " << a->getOverlapAbove();
-         // cout << endl;
-         //}
-
-         // cout << "ST crossing below: " << endl;
-         // for(auto & arc : vect_ct_[i].getSplitTree()->vect_arcsCrossingBelow_){
-         // SuperArc * a = vect_ct_[i].getSplitTree()->getSuperArc(arc);
-         // cout << vect_ct_[i].getSplitTree()->getNode(a->getDownNodeId())->getVertexId();
-         // cout << " - ";
-         // cout << vect_ct_[i].getSplitTree()->getNode(a->getUpNodeId())->getVertexId();
-         // cout << " :: " << a->getOverlapBelow();
-         // cout << endl;
-         //}
-
-         // cout << "ST crossing above: " << endl;
-         // for(auto & arc : vect_ct_[i].getSplitTree()->vect_arcsCrossingAbove_){
-         // SuperArc * a = vect_ct_[i].getSplitTree()->getSuperArc(arc);
-         // cout << vect_ct_[i].getSplitTree()->getNode(a->getDownNodeId())->getVertexId();
-         // cout << " - ";
-         // cout << vect_ct_[i].getSplitTree()->getNode(a->getUpNodeId())->getVertexId();
-         // cout << " :: " << a->getOverlapAbove();
-         // cout << endl;
-         //}
-
-         if (debugLevel_ >= 5) {
-            cout << "Local JT :" << endl;
-            vect_ct_[i].getJoinTree()->printTree2();
-            cout << "Local ST :" << endl;
-            vect_ct_[i].getSplitTree()->printTree2();
-            cout << "combine" << endl;
-         }
+            if (0 || computeContourTree_) {
+               DebugTimer timerCombine;
+
+               auto jt = vect_ct_[i].getJoinTree();
+               auto st = vect_ct_[i].getSplitTree();
+
+               // Copy missing nodes of a tree to the other one
+               // Maintain this traversal order for good insertion
+               for (int t = 0; t < st->getNumberOfNodes(); ++t) {
+                  if (!st->getNode(t)->isHidden()) {
+                     // cout << "insert in jt : " << st->getNode(t)->getVertexId() << endl;
+                     jt->insertNode(st->getNode(t), segmentation_);
+                  }
+               }
+               // and vice versa
+               for (int t = 0; t < jt->getNumberOfNodes(); ++t) {
+                  if (!jt->getNode(t)->isHidden()) {
+                     // cout << "insert in st : " << jt->getNode(t)->getVertexId() << endl;
+                     st->insertNode(jt->getNode(t), segmentation_);
+                  }
+               }
+
+               if (debugLevel_ >= 6) {
+                  cout << "Local JT :" << endl;
+                  vect_ct_[i].getJoinTree()->printTree2();
+                  cout << "Local ST :" << endl;
+                  vect_ct_[i].getSplitTree()->printTree2();
+                  cout << "combine" << endl;
+               }
+
+               if (0 || computeContourTree_) {
+                  // DebugTimer timerNoise;
+
+                  // here Arcs & Nodes of the merge tree are destroyed
+                  vect_ct_[i].combine(posSeed0, posSeed1);
+
+                  vect_ct_[i].updateSegmentation(true);
+
+                  //vect_ct_[i].initNodeValence();
+
+                  if(debugLevel_ >2){
+                      printDebug(timerCombine, "Trees combined   in    ");
+                  }
+
+                  if (debugLevel_ >= 4) {
+                     vect_ct_[i].printTree2();
+                  }
+
+                  //if (nbPartitions_ > 1) {
+                     //DebugTimer   timerSimplify;
+                     //const idEdge tmpMerge =
+                         //vect_ct_[i].globalSimplify<scalarType>(posSeed0, posSeed1, threshold);
+   //#pragma omp atomic update
+                     //timeSimplify[i] += timerSimplify.getElapsedTime();
+   //#pragma omp atomic update
+                     //nbPairMerged += tmpMerge;
+
+                     //vect_ct_[i].updateSegmentation(true);
+
+                     //vect_ct_[i].initNodeValence();
+                  //}
+               }
+            } else {
+               // cout << "JT crossing below : " << endl;
+               // for(auto & arc : vect_ct_[i].getJoinTree()->vect_arcsCrossingBelow_){
+               // SuperArc * a = vect_ct_[i].getJoinTree()->getSuperArc(arc);
+               // cout << vect_ct_[i].getJoinTree()->getNode(a->getDownNodeId())->getVertexId();
+               // cout << " - ";
+               // cout << vect_ct_[i].getJoinTree()->getNode(a->getUpNodeId())->getVertexId();
+               // cout << " :: " << a->getOverlapBelow();
+               // cout << endl;
+               //}
+
+               // cout << "JT crossing above : " << endl;
+               // for(auto & arc : vect_ct_[i].getJoinTree()->vect_arcsCrossingAbove_){
+               // SuperArc * a = vect_ct_[i].getJoinTree()->getSuperArc(arc);
+               // cout << vect_ct_[i].getJoinTree()->getNode(a->getDownNodeId())->getVertexId();
+               // cout << " - ";
+               // cout << vect_ct_[i].getJoinTree()->getNode(a->getUpNodeId())->getVertexId();
+               // cout << " :: " << a->getOverlapAbove();
+               // cout << endl;
+               //}
+
+               // cout << "ST crossing below: " << endl;
+               // for(auto & arc : vect_ct_[i].getSplitTree()->vect_arcsCrossingBelow_){
+               // SuperArc * a = vect_ct_[i].getSplitTree()->getSuperArc(arc);
+               // cout << vect_ct_[i].getSplitTree()->getNode(a->getDownNodeId())->getVertexId();
+               // cout << " - ";
+               // cout << vect_ct_[i].getSplitTree()->getNode(a->getUpNodeId())->getVertexId();
+               // cout << " :: " << a->getOverlapBelow();
+               // cout << endl;
+               //}
+
+               // cout << "ST crossing above: " << endl;
+               // for(auto & arc : vect_ct_[i].getSplitTree()->vect_arcsCrossingAbove_){
+               // SuperArc * a = vect_ct_[i].getSplitTree()->getSuperArc(arc);
+               // cout << vect_ct_[i].getSplitTree()->getNode(a->getDownNodeId())->getVertexId();
+               // cout << " - ";
+               // cout << vect_ct_[i].getSplitTree()->getNode(a->getUpNodeId())->getVertexId();
+               // cout << " :: " << a->getOverlapAbove();
+               // cout << endl;
+               //}
+
+               if (debugLevel_ >= 5) {
+                  cout << "Local JT :" << endl;
+                  vect_ct_[i].getJoinTree()->printTree2();
+                  cout << "Local ST :" << endl;
+                  vect_ct_[i].getSplitTree()->printTree2();
+                  cout << "combine" << endl;
+               }
+            }
+
+            partitionSpeed[i] = partitionSize / timerMergeTree.getElapsedTime();
+         });
+      }
+   }, getNbThreadReal());
+
+   // the seeds of the next build take these speeds into account
+   if (speedFeedback_ && nbBuild == nbPartitions_) {
+      feedbackSpeed_ = partitionSpeed;
+      feedbackBounds_.resize(nbPartitions_ + 1);
+      feedbackBounds_[0] = 0;
+      for (idInterface i = 0; i < nbInterfaces_; ++i) {
+         feedbackBounds_[i + 1] = mirrorOffsets_[vect_interfaces_[i].getSeed()];
       }
+      feedbackBounds_[nbPartitions_] = nbVert;
    }
 
    if (debugLevel_ >= 1 && threshold && nbPartitions_ > 1) {
@@ -495,8 +974,11 @@ int ParallelContourTree::parallelBuild(vector<vector<ExtendedUnionFind *>> &vect
    }
 
    if(debugLevel_ > 1) {
-      auto maxProcSpeed = max_element(speedProcess.cbegin(), speedProcess.cend());
-      auto minProcSpeed = min_element(speedProcess.cbegin(), speedProcess.cend());
+      // ignore the merge tree not built
+      auto beginSpeed   = speedProcess.cbegin() + ((needJoinTree()) ? 0 : nbPartitions_);
+      auto endSpeed     = speedProcess.cend() - ((needSplitTree()) ? 0 : nbPartitions_);
+      auto maxProcSpeed = max_element(beginSpeed, endSpeed);
+      auto minProcSpeed = min_element(beginSpeed, endSpeed);
       cout << "process speed : ";
       cout << " min is " << *minProcSpeed << " vert/sec";
       cout << " max is " << *maxProcSpeed << " vert/sec";
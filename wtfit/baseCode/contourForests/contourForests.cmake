@@ -3,4 +3,5 @@ wtfit_add_basecode_package(contourForestsTree)
 
 wtfit_wrapup_library(libContourForests
   "ParallelContourTree.cpp"
+  "DistributedContourTree.cpp"
 )
@@ -6,35 +6,58 @@
  */
 
 #include <ContourTree.h>
+#include <Hash.h>
 #include <string>
 #include<iterator>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // ------------------ Merge Tree
 
 // Constructors & destructors
-MergeTree::MergeTree(const unsigned char part) : MergeTree(false, part)
+MergeTree::MergeTree(const idPartition part) : MergeTree(false, part)
 {
 }
 
-MergeTree::MergeTree(const bool t, const unsigned char part)
+MergeTree::MergeTree(const bool t, const idPartition part)
     : partition_{part},
       scalars_{nullptr},
       soSOffsets_{nullptr},
       sortedVertices_{},
       mirrorOffsets_{},
+      sortHint_{},
       isJT{t},
       vect_superArcs_{},
       vect_nodes_{},
       vect_leaves_{},
       vect_roots_{},
       vect_vert2tree_{nullptr},
+      segmentation_{true},
+      computeContourTree_{true},
       debugLevel_{3},
-      simplifyMethod_{SimplifMethod::Persist}
+      simplifyMethod_{SimplifMethod::Persist},
+      pruneThreshold_{0},
+      pruneMeasure_{nullptr},
+      sortCacheDirectory_{},
+      mappedFile_{nullptr},
+      mappedSize_{0}
 {
 }
 
 MergeTree::~MergeTree()
 {
+   if (mappedFile_) {
+      munmap(mappedFile_, mappedSize_);
+      mappedFile_ = nullptr;
+   }
+
    // The parallel contour Tree is in charge of the destruction of shared data !
    // if (destroyVectorSortedVertices_ && sortedVertices_) {
    // delete[] sortedVertices_;
@@ -63,6 +86,9 @@ void MergeTree::flush(void)
    vect_superArcs_.clear();
    vect_nodes_.clear();
    vect_leaves_.clear();
+   vect_roots_.clear();
+   vect_arcsCrossingBelow_.clear();
+   vect_arcsCrossingAbove_.clear();
 }
 
 void MergeTree::initSoS(void)
@@ -80,7 +106,9 @@ void MergeTree::initVert2Tree(void)
    if (!vect_vert2tree_) {
       vect_vert2tree_ = new vector<idCorresp>(mesh_->getNumberOfVertices(), nullCorresp);
    } else {
-      cout << "flush vert2tree : recompute" << endl;
+      if (debugLevel_ >= advancedInfoMsg) {
+         cout << "flush vert2tree : recompute" << endl;
+      }
       vect_vert2tree_->resize(mesh_->getNumberOfVertices());
       fill(vect_vert2tree_->begin(), vect_vert2tree_->end(), nullCorresp);
    }
@@ -88,6 +116,111 @@ void MergeTree::initVert2Tree(void)
 
 //}
 
+// Sort cache
+// {
+
+// Files are named sort_<key>.bin in sortCacheDirectory_ and contain the
+// header below followed by sortedVertices_ (int32, little-endian).
+
+static const char     sortCacheMagic[8] = {'W', 'T', 'F', 'I', 'T', 'S', 'O', '\0'};
+static const uint32_t sortCacheVersion  = 1;
+
+struct SortCacheHeader {
+   char     magic[8];
+   uint32_t version;
+   uint8_t  scalarKind;
+   uint8_t  padding[3];
+   uint64_t nbVertices;
+   uint64_t key;
+};
+
+static_assert(sizeof(SortCacheHeader) == 32, "SortCacheHeader is not packed");
+
+static string sortCacheFile(const string &dir, const uint64_t &key)
+{
+   stringstream name;
+   name << dir << "/sort_" << hex << key << ".bin";
+   return name.str();
+}
+
+uint64_t MergeTree::getSortCacheKey(const size_t &scalarSize, const char &scalarKind) const
+{
+   const idVertex nbVertices = mesh_->getNumberOfVertices();
+
+   uint64_t key = Hash::mix(nbVertices, scalarKind);
+   key = Hash::buffer(scalars_, nbVertices * scalarSize, key);
+   key = Hash::buffer(soSOffsets_, nbVertices * sizeof(idVertex), key);
+   return key;
+}
+
+int MergeTree::loadSortCache(const uint64_t &key, const char &scalarKind)
+{
+   const idVertex nbVertices = mesh_->getNumberOfVertices();
+
+   const string fileName = sortCacheFile(sortCacheDirectory_, key);
+   ifstream     file(fileName.data(), ios::in | ios::binary);
+   if (!file) {
+      return -1;
+   }
+
+   SortCacheHeader header;
+   file.read((char *)&header, sizeof(header));
+   if (!file || memcmp(header.magic, sortCacheMagic, sizeof(header.magic)) ||
+       header.version != sortCacheVersion || header.scalarKind != (uint8_t)scalarKind ||
+       header.nbVertices != (uint64_t)nbVertices || header.key != key) {
+      return -1;
+   }
+
+   sortedVertices_.resize(nbVertices);
+   file.read((char *)sortedVertices_.data(), nbVertices * sizeof(idVertex));
+   if (!file) {
+      sortedVertices_.clear();
+      return -2;
+   }
+
+   // least recently used files are trimmed first (see OsCall::trimDirectory)
+   OsCall::touchFile(fileName);
+
+   return 0;
+}
+
+int MergeTree::writeSortCache(const uint64_t &key, const char &scalarKind) const
+{
+   const string fileName = sortCacheFile(sortCacheDirectory_, key);
+   // written aside then renamed : concurrent runs never read a partial file
+   stringstream tmpName;
+   tmpName << fileName << "." << getpid();
+
+   SortCacheHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, sortCacheMagic, sizeof(header.magic));
+   header.version    = sortCacheVersion;
+   header.scalarKind = scalarKind;
+   header.nbVertices = sortedVertices_.size();
+   header.key        = key;
+
+   {
+      ofstream file(tmpName.str().data(), ios::out | ios::binary);
+      file.write((const char *)&header, sizeof(header));
+      file.write((const char *)sortedVertices_.data(), sortedVertices_.size() * sizeof(idVertex));
+      if (!file) {
+         unlink(tmpName.str().data());
+         err("[MergeTree] cannot write the sort cache in " + sortCacheDirectory_ + "\n",
+             advancedInfoMsg);
+         return -1;
+      }
+   }
+
+   if (rename(tmpName.str().data(), fileName.data())) {
+      unlink(tmpName.str().data());
+      return -2;
+   }
+
+   return 0;
+}
+
+// }
+
 // Process
 // {
 
@@ -155,7 +288,7 @@ int MergeTree::build(vector<ExtendedUnionFind *> &vect_baseUF,
       const idVertex currentVertex = overlapBefore[sortedNode];
       const bool overlapB = isJT;
       const bool overlapA = !isJT;
-      processVertex(currentVertex, vect_baseUF, overlapB, overlapA, begin);
+      processVertex(currentVertex, vect_baseUF, overlapB, overlapA, begin, posSeed0, posSeed1);
    }  // foreach node
 
    // }
@@ -167,7 +300,7 @@ int MergeTree::build(vector<ExtendedUnionFind *> &vect_baseUF,
    // for each vertex of our triangulation
    for (sortedNode = mainStart; sortedNode != mainEnd; sortedNode += step) {
       const idVertex currentVertex = sortedVertices_[sortedNode];
-      processVertex(currentVertex, vect_baseUF, false, false, begin);
+      processVertex(currentVertex, vect_baseUF, false, false, begin, posSeed0, posSeed1);
    }  // foreach node
 
    // }
@@ -181,9 +314,25 @@ int MergeTree::build(vector<ExtendedUnionFind *> &vect_baseUF,
       const idVertex currentVertex = overlapAfter[sortedNode];
       const bool overlapB = !isJT;
       const bool overlapA = isJT;
-      processVertex(currentVertex, vect_baseUF, overlapB, overlapA, begin);
+      processVertex(currentVertex, vect_baseUF, overlapB, overlapA, begin, posSeed0, posSeed1);
    }  // foreach node
 
+   // }
+   // ---------------
+   // Pruned leaves
+   // ---------------
+   // {
+
+   // leaves folded during the sweep are no longer part of the tree
+   idVertex nbPrunedLeaves = 0;
+   if (pruneThreshold_ > 0) {
+      const auto nbLeaves = vect_leaves_.size();
+      vect_leaves_.erase(remove_if(vect_leaves_.begin(), vect_leaves_.end(),
+                                   [&](const idNode &l) { return getNode(l)->isHidden(); }),
+                         vect_leaves_.end());
+      nbPrunedLeaves = nbLeaves - vect_leaves_.size();
+   }
+
    // }
    // ---------------
    // Close root arcs
@@ -264,7 +413,11 @@ int MergeTree::build(vector<ExtendedUnionFind *> &vect_baseUF,
 
       msg << static_cast<unsigned>(partition_) << " ";
       msg << "computed   in        " << begin.getElapsedTime();
-      msg << "              \t( nb arcs : " << vect_superArcs_.size() << " )" << endl;
+      msg << "              \t( nb arcs : " << vect_superArcs_.size();
+      if (pruneThreshold_ > 0) {
+         msg << ", pruned : " << nbPrunedLeaves;
+      }
+      msg << " )" << endl;
       dMsg(cout, msg.str(), infoMsg);
    }
 
@@ -275,7 +428,8 @@ int MergeTree::build(vector<ExtendedUnionFind *> &vect_baseUF,
 
 void MergeTree::processVertex(const idVertex &             currentVertex,
                               vector<ExtendedUnionFind *> &vect_baseUF, const bool overlapB,
-                              const bool overlapA, DebugTimer &begin)
+                              const bool overlapA, DebugTimer &begin, const idVertex &posSeed0,
+                              const idVertex &posSeed1)
 {
    vector<ExtendedUnionFind *> vect_neighUF;
    ExtendedUnionFind *         seed = nullptr, *tmpseed;
@@ -308,6 +462,15 @@ void MergeTree::processVertex(const idVertex &             currentVertex,
 
    (neighSize = vect_neighUF.size());
 
+   // On the fly pruning : noisy leaf branches arriving here are folded in the continuing one
+   // If only one branch remains, this vertex is regular
+   vector<ExtendedUnionFind *> vect_foldedUF;
+   if (neighSize > 1 && pruneThreshold_ > 0 && !overlapB && !overlapA) {
+      foldNoisyBranches(currentVertex, vect_neighUF, vect_foldedUF, posSeed0, posSeed1);
+      neighSize = vect_neighUF.size();
+      seed      = vect_neighUF[0];
+   }
+
    // idVertex test = 1;
    // if (currentVertex == test)
    // cout << test << " : " << vect_neighUF.size() << " " << vect_interfaceUF.size() << endl;
@@ -393,12 +556,76 @@ void MergeTree::processVertex(const idVertex &             currentVertex,
       currentArc = (idSuperArc)seed->find()->getData();
       updateCorrespondingArc(currentVertex, currentArc);
    }
+   // folded branches join the continuing one, keeping its origin
+   if (vect_foldedUF.size()) {
+      const idVertex origin = seed->find()->getOrigin();
+      for (auto *folded : vect_foldedUF) {
+         seed = ExtendedUnionFind::makeUnion(seed, folded);
+      }
+      seed->setOrigin(origin);
+   }
+
    // common
    seed->setData((ufDataType)currentArc);
    getSuperArc(currentArc)->setLastVisited(currentVertex, segmentation_);
    vect_baseUF[currentVertex] = seed;
 }
 
+void MergeTree::foldNoisyBranches(const idVertex &saddle, vector<ExtendedUnionFind *> &vect_neighUF,
+                                  vector<ExtendedUnionFind *> &vect_foldedUF,
+                                  const idVertex &posSeed0, const idVertex &posSeed1)
+{
+   // As in simplifyTree, do not touch what is near the interfaces
+   if (mirrorOffsets_[saddle] <= posSeed0 || mirrorOffsets_[saddle] >= posSeed1) {
+      return;
+   }
+
+   // the continuing branch is the most persistent one, see processVertex
+   ExtendedUnionFind *farUF = vect_neighUF[0]->find();
+   for (auto *neigh : vect_neighUF) {
+      if ((isJT && isLower(neigh->find()->getOrigin(), farUF->getOrigin())) ||
+          (!isJT && isHigher(neigh->find()->getOrigin(), farUF->getOrigin()))) {
+         farUF = neigh->find();
+      }
+   }
+   const idSuperArc farArc = (idSuperArc)farUF->getData();
+
+   size_t nbKept = 0;
+   for (auto *neigh : vect_neighUF) {
+      ExtendedUnionFind *branch = neigh->find();
+      const idSuperArc   arc    = (idSuperArc)branch->getData();
+      const idVertex     origin = branch->getOrigin();
+      const idNode       leaf   = getCorrespondingNode(origin);
+      SuperArc *         noisy  = getSuperArc(arc);
+
+      // only a leaf arc, entirely in this partition, can be folded directly
+      const bool toFold = branch != farUF && noisy->getDownNodeId() == leaf &&
+                          !noisy->isCrossing() && mirrorOffsets_[origin] > posSeed0 &&
+                          mirrorOffsets_[origin] < posSeed1 &&
+                          (this->*pruneMeasure_)(origin, saddle) < pruneThreshold_;
+
+      if (!toFold) {
+         vect_neighUF[nbKept++] = neigh;
+         continue;
+      }
+
+      // segmentation goes to the continuing arc (sorted later by updateSegmentation)
+      getSuperArc(farArc)->appendSegmentation(noisy->getSegmentation());
+      vector<pair<idVertex, bool>>().swap(noisy->getSegmentation());
+
+      // the leaf and its arc are removed from the tree
+      noisy->setUpNodeId(leaf);
+      noisy->prune(farArc);
+      getNode(leaf)->removeUpSuperArc(arc);
+      hideNode(leaf);
+      updateCorrespondingArc(origin, farArc);
+
+      vect_foldedUF.emplace_back(neigh);
+   }
+
+   vect_neighUF.resize(nbKept);
+}
+
 // update lately
 
 void MergeTree::updateSegmentation(const bool ct)
@@ -662,40 +889,47 @@ void MergeTree::closeSuperArc(const idSuperArc &superArcId, const idNode &upNode
    }
 }
 
-const idVertex MergeTree::cutArcAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed)
+const idVertex MergeTree::getPosAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed)
 {
    auto isLowerComp = [&](const pair<idVertex, bool> &a, const pair<idVertex, bool> &b) {
       return isLower(a.first, b.first);
    };
 
-   SuperArc *crossing = getSuperArc(arc);
-   idVertex  stitchVert;
-   // get stitching node
-   const auto &vertList = crossing->getVertList();
+   SuperArc *  crossing = getSuperArc(arc);
    const auto &vertSize = crossing->getVertSize();
+   const auto &vertList = crossing->getVertList();
 
-   if (vertSize) {
-      auto posVert = lower_bound(vertList, vertList + vertSize, seed, isLowerComp);
-      if (posVert == vertList + vertSize) {
-         stitchVert = getNode(crossing->getUpNodeId())->getVertexId();
-      } else {
-         while (posVert < vertList + vertSize && posVert->second) {
-            ++posVert;
-         }
+   auto posVert = lower_bound(vertList, vertList + vertSize, seed, isLowerComp);
+   while (posVert < vertList + vertSize && posVert->second) {
+      ++posVert;
+   }
 
-         if (posVert == vertList + vertSize) {
-            stitchVert = getNode(crossing->getUpNodeId())->getVertexId();
-         } else {
-             // update segmentation
-            crossing->setVertSize(posVert - vertList);
-            stitchVert = posVert->first;
-            // cout << "new size is " << crossing->getVertSize() << endl;
-         }
-      }
-   } else {
-      stitchVert = getNode(crossing->getUpNodeId())->getVertexId();
+   return posVert - vertList;
+}
+
+const idVertex MergeTree::getVertAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed)
+{
+   SuperArc *     crossing = getSuperArc(arc);
+   const idVertex pos      = getPosAboveSeed(arc, seed);
+
+   if (pos == crossing->getVertSize()) {
+      return getNode(crossing->getUpNodeId())->getVertexId();
    }
+   return crossing->getVertList()[pos].first;
+}
+
+const idVertex MergeTree::cutArcAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed)
+{
+   SuperArc *     crossing = getSuperArc(arc);
+   const idVertex pos      = getPosAboveSeed(arc, seed);
 
+   if (pos == crossing->getVertSize()) {
+      return getNode(crossing->getUpNodeId())->getVertexId();
+   }
+
+   // update segmentation
+   const idVertex stitchVert = crossing->getVertList()[pos].first;
+   crossing->setVertSize(pos);
    return stitchVert;
 }
 
@@ -722,7 +956,8 @@ const idVertex MergeTree::cutArcBelowSeed(const idSuperArc &arc, const pair<idVe
             --posVert;
           }
 
-          if (posVert == 0) {
+          // the first vertex of the list may be hidden too
+          if (posVert->second || (*vert2treeOther)[posVert->first] == nullCorresp) {
              stitchVert = getNode(crossing->getDownNodeId())->getVertexId();
          } else {
              // we only find, do not touch the segmentation
@@ -938,11 +1173,12 @@ void MergeTree::delNode(const idNode &node, const pair<idVertex, bool> *markVert
                for (idVertex i = nbMark - 1; i >= 0; --i) {
                   if (!vect_superArcs_[downArc].getVertSize())
                      break;
-                  while (vect_superArcs_[downArc].getRegularNodeId(++acc) !=
-                         markVertices[i].first) {
-                     if (acc == vect_superArcs_[downArc].getVertSize())
-                        break;
-                  }
+                  // bound checked before the read
+                  do {
+                     ++acc;
+                  } while (acc < vect_superArcs_[downArc].getVertSize() &&
+                           vect_superArcs_[downArc].getRegularNodeId(acc) !=
+                               markVertices[i].first);
                   if (acc == vect_superArcs_[downArc].getVertSize())
                      break;
 
@@ -1279,6 +1515,53 @@ const idSuperArc MergeTree::hideAndClearLeadingTo(const idNode &baseNode, const
     return nullSuperArc;
 }
 
+const bool MergeTree::isLeadingTo(const idVertex &v, const idVertex &to)
+{
+   auto reaches = [&](const idSuperArc &a) {
+      return getSuperArc(a)->isVisible() &&
+             (getNode(getSuperArc(a)->getUpNodeId())->getVertexId() == to ||
+              (isCorrespondingArc(to) && getCorrespondingSuperArcId(to) == a));
+   };
+
+   if (isCorrespondingNode(v)) {
+      const Node *node = getNode(getCorrespondingNode(v));
+      const auto  nbUp = node->getNumberOfUpSuperArcs();
+      for (unsigned aid = 0; aid < nbUp; aid++) {
+         const idSuperArc a = node->getUpSuperArcId(aid);
+         if (getSuperArc(a)->getUpCT() == partition_ && reaches(a)) {
+            return true;
+         }
+      }
+   } else if (isCorrespondingArc(v)) {
+      return reaches(getCorrespondingSuperArcId(v));
+   }
+
+   return false;
+}
+
+const idSuperArc MergeTree::getArcCrossingFrom(const idVertex &v, const idVertex &seed)
+{
+   if (isCorrespondingNode(v)) {
+      const Node *node = getNode(getCorrespondingNode(v));
+      const auto  nbUp = node->getNumberOfUpSuperArcs();
+      for (unsigned aid = 0; aid < nbUp; aid++) {
+         const idSuperArc a = node->getUpSuperArcId(aid);
+         if (getSuperArc(a)->getUpCT() == partition_ && getSuperArc(a)->isVisible() &&
+             !isLower(getNode(getSuperArc(a)->getUpNodeId())->getVertexId(), seed)) {
+            return a;
+         }
+      }
+   } else if (isCorrespondingArc(v)) {
+      const idSuperArc a = getCorrespondingSuperArcId(v);
+      if (getSuperArc(a)->isVisible() &&
+          !isLower(getNode(getSuperArc(a)->getUpNodeId())->getVertexId(), seed)) {
+         return a;
+      }
+   }
+
+   return nullSuperArc;
+}
+
 // }
 
 // Operators : find, print & clone
@@ -1422,6 +1705,380 @@ void MergeTree::shallowCopy(const MergeTree *mt)
    vect_arcsCrossingAbove_ = mt->vect_arcsCrossingAbove_;
 }
 
+// }
+// Binary file
+// {
+
+// Records of the binary file, see ContourTree.h for the layout.
+// Widths are fixed so the file does not depend on idNode / idSuperArc.
+
+static const char     binaryTreeMagic[8] = {'W', 'T', 'F', 'I', 'T', 'C', 'T', '\0'};
+static const uint32_t binaryTreeVersion  = 3;
+
+struct BinaryTreeHeader {
+   char     magic[8];
+   uint32_t version;
+   uint32_t isJT;
+   uint64_t nbVertices;
+   uint64_t nbNodes;
+   uint64_t nbArcs;
+   uint64_t nbAdjacency;
+   uint64_t nbLeaves;
+   uint64_t nbRoots;
+   uint64_t nbSegmentation;
+   uint64_t nbPairs;
+};
+
+struct BinaryTreeNode {
+   int32_t  vertexId;
+   int32_t  linkedNode;
+   int16_t  downValence;
+   int16_t  upValence;
+   uint32_t nbDownArcs;
+   uint32_t nbUpArcs;
+   uint8_t  hidden;
+   uint8_t  padding[3];
+};
+
+struct BinaryTreeArc {
+   uint32_t downNodeId;
+   uint32_t upNodeId;
+   uint64_t replacantId;
+   uint64_t segmentationOffset;
+   int32_t  lastVisited;
+   int32_t  segmentationSize;
+   uint16_t downCT;
+   uint16_t upCT;
+   uint16_t replacantCT;
+   uint8_t  state;
+   uint8_t  overlapBelow;
+   uint8_t  overlapAbove;
+   uint8_t  padding[7];
+};
+
+struct BinaryTreeRegular {
+   int32_t vertexId;
+   uint8_t masqued;
+   uint8_t padding[3];
+};
+
+struct BinaryTreePair {
+   int32_t vertex0;
+   int32_t vertex1;
+   double  persistence;
+};
+
+static_assert(sizeof(BinaryTreeHeader) == 80, "BinaryTreeHeader is not packed");
+static_assert(sizeof(BinaryTreeNode) == 24, "BinaryTreeNode is not packed");
+static_assert(sizeof(BinaryTreeArc) == 48, "BinaryTreeArc is not packed");
+static_assert(sizeof(BinaryTreePair) == 16, "BinaryTreePair is not packed");
+// the segmentation block is used in place by the loaded arcs
+static_assert(sizeof(BinaryTreeRegular) == sizeof(pair<idVertex, bool>) &&
+                  sizeof(idVertex) == sizeof(int32_t),
+              "segmentation records do not match pair<idVertex, bool>");
+
+static inline size_t binaryTreeAlign(const size_t &s)
+{
+   return (s + 7) & ~static_cast<size_t>(7);
+}
+
+static inline bool binaryTreeLittleEndian(void)
+{
+   const uint16_t one = 1;
+   return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+int MergeTree::writeBinary(const string &fileName,
+                           const vector<pair<pair<int, int>, double>> *pairs)
+{
+   if (!binaryTreeLittleEndian()) {
+      err("[MergeTree] binary trees are only written on little-endian hosts\n", fatalMsg);
+      return -1;
+   }
+
+   DebugTimer timer;
+
+   const idNode     nbNodes = getNumberOfNodes();
+   const idSuperArc nbArcs  = getNumberOfSuperArcs();
+
+   BinaryTreeHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, binaryTreeMagic, sizeof(header.magic));
+   header.version    = binaryTreeVersion;
+   header.isJT       = isJT;
+   header.nbVertices = (vect_vert2tree_) ? vect_vert2tree_->size() : 0;
+   header.nbNodes    = nbNodes;
+   header.nbArcs     = nbArcs;
+   header.nbLeaves   = vect_leaves_.size();
+   header.nbRoots    = vect_roots_.size();
+   header.nbPairs    = (pairs) ? pairs->size() : 0;
+
+   vector<BinaryTreeNode> nodes(nbNodes);
+   vector<uint64_t>       adjacency;
+   for (idNode n = 0; n < nbNodes; ++n) {
+      const Node &node = vect_nodes_[n];
+      BinaryTreeNode &rec = nodes[n];
+      memset(&rec, 0, sizeof(rec));
+      rec.vertexId    = node.vertexId_;
+      rec.linkedNode  = node.linkedNode_;
+      rec.downValence = get<0>(node.valence_);
+      rec.upValence   = get<1>(node.valence_);
+      rec.nbDownArcs  = node.vect_downSuperArcList_.size();
+      rec.nbUpArcs    = node.vect_upSuperArcList_.size();
+      rec.hidden      = node.hidden_;
+      adjacency.insert(adjacency.end(), node.vect_downSuperArcList_.cbegin(),
+                       node.vect_downSuperArcList_.cend());
+      adjacency.insert(adjacency.end(), node.vect_upSuperArcList_.cbegin(),
+                       node.vect_upSuperArcList_.cend());
+   }
+   header.nbAdjacency = adjacency.size();
+
+   vector<BinaryTreeArc> arcs(nbArcs);
+   for (idSuperArc a = 0; a < nbArcs; ++a) {
+      SuperArc &arc = vect_superArcs_[a];
+      BinaryTreeArc &rec = arcs[a];
+      memset(&rec, 0, sizeof(rec));
+      rec.downNodeId         = arc.downNodeId_;
+      rec.upNodeId           = arc.upNodeId_;
+      rec.replacantId        = arc.replacantId_;
+      rec.segmentationOffset = header.nbSegmentation;
+      rec.lastVisited        = arc.lastVisited_;
+      rec.segmentationSize   = arc.getVertSize();
+      rec.downCT             = arc.downCT_;
+      rec.upCT               = arc.upCT_;
+      rec.replacantCT        = arc.replacantCT_;
+      rec.state              = arc.state_;
+      rec.overlapBelow       = arc.overlapBelow_;
+      rec.overlapAbove       = arc.overlapAbove_;
+      header.nbSegmentation += rec.segmentationSize;
+   }
+
+   ofstream file(fileName.data(), ios::out | ios::binary);
+   if (!file) {
+      err("[MergeTree] cannot open " + fileName + " for writing\n", fatalMsg);
+      return -1;
+   }
+
+   const char padding[8] = {0};
+   auto writeBlock = [&file, &padding](const void *data, const size_t &size) {
+      file.write(static_cast<const char *>(data), size);
+      file.write(padding, binaryTreeAlign(size) - size);
+   };
+
+   writeBlock(&header, sizeof(header));
+   writeBlock(nodes.data(), nodes.size() * sizeof(BinaryTreeNode));
+   writeBlock(arcs.data(), arcs.size() * sizeof(BinaryTreeArc));
+   writeBlock(adjacency.data(), adjacency.size() * sizeof(uint64_t));
+
+   vector<uint32_t> leaves(vect_leaves_.cbegin(), vect_leaves_.cend());
+   vector<uint32_t> roots(vect_roots_.cbegin(), vect_roots_.cend());
+   writeBlock(leaves.data(), leaves.size() * sizeof(uint32_t));
+   writeBlock(roots.data(), roots.size() * sizeof(uint32_t));
+
+   // pair<idVertex, bool> has the layout of BinaryTreeRegular but its
+   // padding is not initialized: write clean records
+   for (idSuperArc a = 0; a < nbArcs; ++a) {
+      SuperArc &arc = vect_superArcs_[a];
+      const pair<idVertex, bool> *vertList = arc.getVertList();
+      vector<BinaryTreeRegular> regulars(arcs[a].segmentationSize);
+      for (size_t v = 0; v < regulars.size(); ++v) {
+         regulars[v].vertexId   = vertList[v].first;
+         regulars[v].masqued    = vertList[v].second;
+         regulars[v].padding[0] = regulars[v].padding[1] = regulars[v].padding[2] = 0;
+      }
+      file.write(reinterpret_cast<const char *>(regulars.data()),
+                 regulars.size() * sizeof(BinaryTreeRegular));
+   }
+
+   if (vect_vert2tree_) {
+      writeBlock(vect_vert2tree_->data(), vect_vert2tree_->size() * sizeof(idCorresp));
+   }
+
+   if (pairs) {
+      vector<BinaryTreePair> pairRecords(pairs->size());
+      for (size_t p = 0; p < pairs->size(); ++p) {
+         pairRecords[p].vertex0     = (*pairs)[p].first.first;
+         pairRecords[p].vertex1     = (*pairs)[p].first.second;
+         pairRecords[p].persistence = (*pairs)[p].second;
+      }
+      writeBlock(pairRecords.data(), pairRecords.size() * sizeof(BinaryTreePair));
+   }
+
+   if (!file) {
+      err("[MergeTree] error while writing " + fileName + "\n", fatalMsg);
+      return -1;
+   }
+
+   {
+      stringstream msg;
+      msg << "[MergeTree] Tree written in " << fileName << " (" << nbNodes << " nodes, " << nbArcs
+          << " arcs) in " << timer.getElapsedTime() << endl;
+      dMsg(cout, msg.str(), timeMsg);
+   }
+
+   return 0;
+}
+
+int MergeTree::loadBinary(const string &fileName, vector<pair<pair<int, int>, double>> *pairs)
+{
+   if (!binaryTreeLittleEndian()) {
+      err("[MergeTree] binary trees are only loaded on little-endian hosts\n", fatalMsg);
+      return -1;
+   }
+
+   DebugTimer timer;
+
+   int fd = open(fileName.data(), O_RDONLY);
+   if (fd == -1) {
+      err("[MergeTree] cannot open " + fileName + "\n", fatalMsg);
+      return -1;
+   }
+
+   struct stat fileStat;
+   if (fstat(fd, &fileStat) == -1 || (size_t)fileStat.st_size < sizeof(BinaryTreeHeader)) {
+      close(fd);
+      err("[MergeTree] " + fileName + " is not a binary tree\n", fatalMsg);
+      return -1;
+   }
+
+   const size_t size = fileStat.st_size;
+   // private & writable : masqued flags can be updated by the simplification
+   void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (data == MAP_FAILED) {
+      err("[MergeTree] cannot map " + fileName + "\n", fatalMsg);
+      return -1;
+   }
+
+   const char *              buffer = static_cast<const char *>(data);
+   const BinaryTreeHeader &header = *reinterpret_cast<const BinaryTreeHeader *>(buffer);
+
+   // blocks position
+   const size_t nodesOffset = binaryTreeAlign(sizeof(BinaryTreeHeader));
+   const size_t arcsOffset  = nodesOffset + binaryTreeAlign(header.nbNodes * sizeof(BinaryTreeNode));
+   const size_t adjOffset   = arcsOffset + binaryTreeAlign(header.nbArcs * sizeof(BinaryTreeArc));
+   const size_t leavesOffset = adjOffset + binaryTreeAlign(header.nbAdjacency * sizeof(uint64_t));
+   const size_t rootsOffset = leavesOffset + binaryTreeAlign(header.nbLeaves * sizeof(uint32_t));
+   const size_t segmOffset  = rootsOffset + binaryTreeAlign(header.nbRoots * sizeof(uint32_t));
+   const size_t v2tOffset =
+       segmOffset + binaryTreeAlign(header.nbSegmentation * sizeof(BinaryTreeRegular));
+   const size_t pairsOffset =
+       v2tOffset + binaryTreeAlign(header.nbVertices * sizeof(idCorresp));
+   const size_t endOffset = pairsOffset + header.nbPairs * sizeof(BinaryTreePair);
+
+   string error;
+   if (memcmp(header.magic, binaryTreeMagic, sizeof(header.magic))) {
+      error = " is not a binary tree";
+   } else if (header.version != binaryTreeVersion) {
+      error = " has an unsupported version";
+   } else if ((bool)header.isJT != isJT) {
+      error = (isJT) ? " does not store a join tree" : " stores a join tree";
+   } else if (endOffset != size) {
+      error = " is truncated";
+   }
+
+   if (error.length()) {
+      munmap(data, size);
+      err("[MergeTree] " + fileName + error + "\n", fatalMsg);
+      return -1;
+   }
+
+   const BinaryTreeNode *nodes =
+       reinterpret_cast<const BinaryTreeNode *>(buffer + nodesOffset);
+   const BinaryTreeArc *arcs = reinterpret_cast<const BinaryTreeArc *>(buffer + arcsOffset);
+   const uint64_t *adjacency = reinterpret_cast<const uint64_t *>(buffer + adjOffset);
+   const uint32_t *leaves    = reinterpret_cast<const uint32_t *>(buffer + leavesOffset);
+   const uint32_t *roots     = reinterpret_cast<const uint32_t *>(buffer + rootsOffset);
+   pair<idVertex, bool> *segmentation =
+       reinterpret_cast<pair<idVertex, bool> *>(static_cast<char *>(data) + segmOffset);
+   const idCorresp *vert2tree = reinterpret_cast<const idCorresp *>(buffer + v2tOffset);
+   const BinaryTreePair *pairRecords =
+       reinterpret_cast<const BinaryTreePair *>(buffer + pairsOffset);
+
+   // the nodes and arcs index the adjacency and segmentation blocks
+   uint64_t nbAdjacency = 0;
+   for (uint64_t n = 0; n < header.nbNodes; ++n) {
+      nbAdjacency += (uint64_t)nodes[n].nbDownArcs + nodes[n].nbUpArcs;
+   }
+   if (nbAdjacency != header.nbAdjacency) {
+      error = " has inconsistent nodes adjacency";
+   }
+   for (uint64_t a = 0; a < header.nbArcs && error.empty(); ++a) {
+      if (arcs[a].segmentationSize < 0 || arcs[a].segmentationOffset > header.nbSegmentation ||
+          (uint64_t)arcs[a].segmentationSize >
+              header.nbSegmentation - arcs[a].segmentationOffset) {
+         error = " has an arc segmentation out of range";
+      }
+   }
+
+   if (error.length()) {
+      munmap(data, size);
+      err("[MergeTree] " + fileName + error + "\n", fatalMsg);
+      return -1;
+   }
+
+   // previous mapping, if any, is no longer referenced
+   if (mappedFile_) {
+      munmap(mappedFile_, mappedSize_);
+   }
+   mappedFile_ = data;
+   mappedSize_ = size;
+
+   vect_nodes_.clear();
+   vect_nodes_.reserve(header.nbNodes);
+   for (uint64_t n = 0; n < header.nbNodes; ++n) {
+      const BinaryTreeNode &rec = nodes[n];
+      vect_nodes_.emplace_back(rec.vertexId, rec.linkedNode);
+      Node &node = vect_nodes_.back();
+      node.vect_downSuperArcList_.assign(adjacency, adjacency + rec.nbDownArcs);
+      adjacency += rec.nbDownArcs;
+      node.vect_upSuperArcList_.assign(adjacency, adjacency + rec.nbUpArcs);
+      adjacency += rec.nbUpArcs;
+      node.hidden_  = rec.hidden;
+      node.valence_ = make_tuple(rec.downValence, rec.upValence);
+   }
+
+   vect_superArcs_.clear();
+   vect_superArcs_.reserve(header.nbArcs);
+   for (uint64_t a = 0; a < header.nbArcs; ++a) {
+      const BinaryTreeArc &rec = arcs[a];
+      vect_superArcs_.emplace_back(rec.downNodeId, rec.upNodeId, rec.overlapBelow,
+                                   rec.overlapAbove, rec.downCT, rec.upCT, 0ul,
+                                   static_cast<ComponentState>(rec.state));
+      SuperArc &arc    = vect_superArcs_.back();
+      arc.replacantCT_ = rec.replacantCT;
+      arc.replacantId_ = rec.replacantId;
+      arc.lastVisited_ = rec.lastVisited;
+      arc.setVertList(segmentation + rec.segmentationOffset);
+      arc.setVertSize(rec.segmentationSize);
+   }
+
+   vect_leaves_.assign(leaves, leaves + header.nbLeaves);
+   vect_roots_.assign(roots, roots + header.nbRoots);
+   vect_arcsCrossingBelow_.clear();
+   vect_arcsCrossingAbove_.clear();
+
+   // same ownership as clone()
+   vect_vert2tree_ = new vector<idCorresp>(vert2tree, vert2tree + header.nbVertices);
+
+   if (pairs) {
+      pairs->resize(header.nbPairs);
+      for (uint64_t p = 0; p < header.nbPairs; ++p) {
+         (*pairs)[p] = make_pair(make_pair(pairRecords[p].vertex0, pairRecords[p].vertex1),
+                                 pairRecords[p].persistence);
+      }
+   }
+
+   {
+      stringstream msg;
+      msg << "[MergeTree] Tree loaded from " << fileName << " (" << header.nbNodes << " nodes, "
+          << header.nbArcs << " arcs) in " << timer.getElapsedTime() << endl;
+      dMsg(cout, msg.str(), timeMsg);
+   }
+
+   return 0;
+}
+
 // }
 // Simplification
 // {
@@ -1908,6 +2565,10 @@ int ContourTree::combine(const idVertex &seed0, const idVertex &seed1)
    const idVertex &s1 =
        (seed1 > mesh_->getNumberOfVertices()) ? nullVertex : sortedVertices_[seed1];
 
+   // nodes re-enqueued in a row: when the whole queue is waiting, the trees
+   // differ (in the overlap of the partition) and nothing can be added anymore
+   size_t nbWaiting = 0;
+
    while (!queue_growingNodes.empty()) {
       // i <- Get(Q)
       head = queue_growingNodes.front();
@@ -1961,6 +2622,13 @@ int ContourTree::combine(const idVertex &seed0, const idVertex &seed1)
             }
 
             queue_growingNodes.emplace_back(head.first, head.second);
+
+            if (++nbWaiting > queue_growingNodes.size()) {
+               if (DEBUG) {
+                  cout << "no more arc can be added" << endl;
+               }
+               break;
+            }
          }
 
          if (DEBUG) {
@@ -1998,6 +2666,8 @@ int ContourTree::combine(const idVertex &seed0, const idVertex &seed1)
             vect_leaves_.emplace_back(node2);
       }
 
+      nbWaiting = 0;
+
       // AddArc(CT, ij)
       pair<idVertex, bool> *arcVertList = nullptr;
       idVertex arcVertSize = 0;
@@ -25,6 +25,7 @@
 #include <Triangulation.h>
 #include <Wrapper.h>
 
+#include <cstdint>
 #include <queue>
 #include <set>
 #include <tuple>
@@ -42,6 +43,8 @@ namespace wtfit
 
    class SuperArc
    {
+      friend class MergeTree;
+
      private:
       // Extrema
       idNode downNodeId_, upNodeId_;
@@ -95,7 +98,7 @@ namespace wtfit
       // -----------------
       // {
       SuperArc(const idNode &d, const idNode &u, const bool overB, const bool overA,
-               const unsigned char &ctd = 0, const unsigned char &ctu = 0, const size_t &resv = 0ul,
+               const idPartition &ctd = 0, const idPartition &ctu = 0, const size_t &resv = 0ul,
                const ComponentState &state = ComponentState::VISIBLE)
           : downNodeId_(d),
             upNodeId_(u),
@@ -145,7 +148,7 @@ namespace wtfit
       // tree
       // .................................{
       //
-      // idPartition u_char so lighter than a ref
+      // idPartition u_short so lighter than a ref
       inline const idPartition getDownCT(void) const
       {
          return downCT_;
@@ -217,7 +220,7 @@ namespace wtfit
 
       inline bool isPruned(void) const
       {
-         return state_ == ComponentState::MERGED;
+         return state_ == ComponentState::PRUNED || state_ == ComponentState::MERGED;
       }
 
       inline bool isMerged(void) const
@@ -235,13 +238,21 @@ namespace wtfit
          state_ = ComponentState::HIDDEN;
       }
 
-      inline void merge(const idSuperArc &arc, const idPartition ct = 255)
+      inline void merge(const idSuperArc &arc, const idPartition ct = nullPartition)
       {
-         replacantCT_ = (ct == 255) ? upCT_ : ct;
+         replacantCT_ = (ct == nullPartition) ? upCT_ : ct;
          replacantId_ = arc;
          state_       = ComponentState::MERGED;
       }
 
+      // folded during the build, before being part of the tree
+      inline void prune(const idSuperArc &arc)
+      {
+         replacantCT_ = upCT_;
+         replacantId_ = arc;
+         state_       = ComponentState::PRUNED;
+      }
+
       // }
       // replacant arc/tree (merge)
       // .................................{
@@ -737,12 +748,14 @@ namespace wtfit
       // MESH DATA ---------------------------------------- if change : update clone()
 
       Triangulation *mesh_;
-      unsigned char  partition_;
+      idPartition    partition_;
 
       void *    scalars_;
       idVertex *soSOffsets_;
 
       vector<idVertex> sortedVertices_, mirrorOffsets_;
+      // order the next sortInput starts from (warm start), empty if none
+      vector<idVertex> sortHint_;
 
       // TREE DATA -----------------------------------------
 
@@ -763,6 +776,17 @@ namespace wtfit
       int  debugLevel_;
       SimplifMethod simplifyMethod_;
 
+      // on the fly pruning during build (0 : disabled)
+      double pruneThreshold_;
+      double (MergeTree::*pruneMeasure_)(const idVertex &, const idVertex &) const;
+
+      // directory of the sorted vertices cache (empty : disabled)
+      string sortCacheDirectory_;
+
+      // file mapped by loadBinary, the arcs segmentation points into it
+      void * mappedFile_;
+      size_t mappedSize_;
+
      public:
 
       // CONSTRUCT
@@ -771,7 +795,7 @@ namespace wtfit
 
       MergeTree(decltype(partition_) part = 0);
 
-      MergeTree(const bool t, const unsigned char part = 0);
+      MergeTree(const bool t, const idPartition part = 0);
 
       virtual ~MergeTree();
 
@@ -793,7 +817,7 @@ namespace wtfit
       // partition
       // .....................{
 
-      inline const unsigned char getPartition(void) const
+      inline const idPartition getPartition(void) const
       {
          return partition_;
       }
@@ -845,6 +869,23 @@ namespace wtfit
          mirrorOffsets_ = mir;
       }
 
+      inline const vector<idVertex> &getSortedVertices(void) const
+      {
+         return sortedVertices_;
+      }
+
+      // sortInput starts from this order instead of the identity
+      inline void setSortHint(const vector<idVertex> &order)
+      {
+         sortHint_ = order;
+      }
+
+      // sortInput reuses the order stored here for the same scalars / offsets
+      inline void setSortCacheDirectory(const string &dir)
+      {
+         sortCacheDirectory_ = dir;
+      }
+
       // }
       // arcs
       // .....................{
@@ -1012,6 +1053,23 @@ namespace wtfit
          }
       }
 
+      // }
+      // On the fly pruning
+      // .....................{
+
+      // Need the simplification method to be set before.
+      // Only persistence and span have a per-branch measure.
+      template <typename scalarType>
+      inline void setPruneThreshold(const double threshold)
+      {
+         if (simplifyMethod_ == SimplifMethod::Persist || simplifyMethod_ == SimplifMethod::Span) {
+            pruneThreshold_ = threshold;
+         } else {
+            pruneThreshold_ = 0;
+         }
+         pruneMeasure_ = &MergeTree::branchMeasure<scalarType>;
+      }
+
       // }
 
       // }
@@ -1142,6 +1200,19 @@ namespace wtfit
       template <typename scalarType>
       void sortInput(void);
 
+      /// \brief sort sortHint_ into sortedVertices_, at a cost depending on how far
+      /// the hint is from the order. -1 if a full sort is needed
+      template <typename scalarType>
+      int adaptiveSort(void);
+
+      /// \brief hash of the scalars, SoS offsets and number of vertices
+      uint64_t getSortCacheKey(const size_t &scalarSize, const char &scalarKind) const;
+
+      /// \brief fill sortedVertices_ from the cache, -1 on miss
+      int loadSortCache(const uint64_t &key, const char &scalarKind);
+
+      int writeSortCache(const uint64_t &key, const char &scalarKind) const;
+
       //}
       // -------------------
       // Process
@@ -1153,7 +1224,14 @@ namespace wtfit
 
       // Merge tree processing of a vertex during build
       void processVertex(const idVertex &vertex, vector<ExtendedUnionFind *> &vect_baseUF,
-                         const bool overlapB, const bool overlapA, DebugTimer &begin);
+                         const bool overlapB, const bool overlapA, DebugTimer &begin,
+                         const idVertex &posSeed0, const idVertex &posSeed1);
+
+      // On the fly pruning : leaf branches arriving at this saddle with a measure below
+      // pruneThreshold_ are folded in the continuing branch and moved in vect_foldedUF
+      void foldNoisyBranches(const idVertex &saddle, vector<ExtendedUnionFind *> &vect_neighUF,
+                             vector<ExtendedUnionFind *> &vect_foldedUF,
+                             const idVertex &posSeed0, const idVertex &posSeed1);
 
       /// \brief Compute the merge tree using Carr's algorithm
       int build(vector<ExtendedUnionFind *> &vect_baseUF, const vector<idVertex> &overlapBefore,
@@ -1233,6 +1311,13 @@ namespace wtfit
 
       void mergeArc(const idSuperArc &sa, const idSuperArc &recept, const bool changeConnectivity = true );
 
+      // position in the vertex list of the arc of its first visible vertex not
+      // below the seed, the size of the list if there is none
+      const idVertex getPosAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed);
+
+      // first visible vertex of the arc not below the seed, or its up node
+      const idVertex getVertAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed);
+
       const idVertex cutArcAboveSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed);
 
       const idVertex cutArcBelowSeed(const idSuperArc &arc, const pair<idVertex, bool> &seed,const vector<idCorresp>* vert2treeOther);
@@ -1288,6 +1373,14 @@ namespace wtfit
 
       const idSuperArc hideAndClearLeadingTo(const idNode &baseNode, const idVertex &v);
 
+      // is there a visible arc of this tree going up from v (node or regular)
+      // and reaching to (its up node or one of its regular vertices)
+      const bool isLeadingTo(const idVertex &v, const idVertex &to);
+
+      // visible arc of this tree going up from v (node or regular) and
+      // reaching the seed, nullSuperArc if none
+      const idSuperArc getArcCrossingFrom(const idVertex &v, const idVertex &seed);
+
       // }
       // Update informations
       // ...........................{
@@ -1344,6 +1437,30 @@ namespace wtfit
       void shallowCopy(const MergeTree *mt);
 
       //}
+      // ---------------------------
+      // Binary file
+      // ---------------------------
+      // {
+
+      // Little-endian, 8 bytes aligned blocks after a fixed header:
+      // nodes | arcs | nodes adjacency | leaves | roots | segmentation | vert2tree
+      // | persistence pairs (two int32 vertices, double persistence)
+      // The segmentation block has the layout of pair<idVertex, bool> so the
+      // loaded arcs use it in place. Partition crossing data are not stored.
+
+      /// \brief write the tree, its segmentation, vert2tree and its
+      /// persistence pairs, if any, in fileName
+      int writeBinary(const string &fileName,
+                      const vector<pair<pair<int, int>, double>> *pairs = nullptr);
+
+      /// \brief replace this tree by the one stored in fileName (mapped, not read).
+      /// The mapping is released with this tree: clones must not outlive it.
+      /// A loaded tree has no scalars: its persistence pairs are the stored
+      /// ones, copied in pairs.
+      int loadBinary(const string &fileName,
+                     vector<pair<pair<int, int>, double>> *pairs = nullptr);
+
+      // }
 
      protected:
       // ------------------
@@ -1471,6 +1588,10 @@ namespace wtfit
       void addPair(vector<pair<pair<int, int>, double>> &pairs, const idVertex &orig,
                    const idVertex &term);
 
+      // persistence or span of the branch orig - term, used by the on the fly pruning
+      template <typename scalarType>
+      double branchMeasure(const idVertex &orig, const idVertex &term) const;
+
       // }
 
       // Know what to destroy
@@ -22,20 +22,39 @@ void MergeTree::sortInput(void)
    auto nbVertices = mesh_->getNumberOfVertices();
 
    if (!sortedVertices_.size()) {
-      auto indirect_sort = [&](const size_t &a, const size_t &b) {
-         return isLower<scalarType>(a, b);
-      };
+      // same bytes but another type would not give the same order
+      const char scalarKind = sizeof(scalarType) | (is_floating_point<scalarType>::value << 5) |
+                              (is_signed<scalarType>::value << 6);
+      const bool useCache = sortCacheDirectory_.length();
+      uint64_t   cacheKey = 0;
+
+      if (useCache) {
+         cacheKey = getSortCacheKey(sizeof(scalarType), scalarKind);
+      }
+
+      if (!useCache || loadSortCache(cacheKey, scalarKind)) {
+         if (sortHint_.size() != (size_t)nbVertices || adaptiveSort<scalarType>()) {
+            auto indirect_sort = [&](const size_t &a, const size_t &b) {
+               return isLower<scalarType>(a, b);
+            };
 
-      sortedVertices_.resize(nbVertices, 0);
+            sortedVertices_.resize(nbVertices, 0);
 
-      iota(sortedVertices_.begin(), sortedVertices_.end(), 0);
+            iota(sortedVertices_.begin(), sortedVertices_.end(), 0);
 
 #ifdef withOpenMP
-      __gnu_parallel::sort(sortedVertices_.begin(), sortedVertices_.end(), indirect_sort);
+            __gnu_parallel::sort(sortedVertices_.begin(), sortedVertices_.end(), indirect_sort);
 #else
-      sort(sortedVertices_.begin(), sortedVertices_.end(), indirect_sort);
+            sort(sortedVertices_.begin(), sortedVertices_.end(), indirect_sort);
 #endif
+         }
+         if (useCache) {
+            writeSortCache(cacheKey, scalarKind);
+         }
+      }
       destroyVectorSortedVertices_ = true;
+      // consumed
+      vector<idVertex>().swap(sortHint_);
    }
 
    if (!mirrorOffsets_.size()) {
@@ -53,6 +72,180 @@ void MergeTree::sortInput(void)
       // dMsg(cout, msgMir.str(), timeMsg);
    }
 }
+
+template <typename scalarType>
+int MergeTree::adaptiveSort(void)
+{
+   const idVertex nbVertices = mesh_->getNumberOfVertices();
+
+   auto indirect_less = [&](const idVertex &a, const idVertex &b) {
+      return isLower<scalarType>(a, b);
+   };
+
+#ifdef withOpenMP
+   const int nbChunks = min(omp_get_max_threads(), max(nbVertices, 1));
+#else
+   const int nbChunks = 1;
+#endif
+
+   // 1 - Few vertices moved far away (a region changed):
+   // each chunk of the hint is scanned once, keeping an increasing sequence
+   // in place. A vertex lower than the top of this sequence is displaced
+   // with the top, so each descent moves at most two vertices
+   // (1 2 9 3 4 -> 1 2 4 | 3 9). The sorted displaced vertices are then
+   // merged with the kept sequences. Used up to 1/16 of displaced vertices.
+   vector<idVertex>         kept(nbVertices);
+   vector<idVertex>         keptEnd(nbChunks);
+   vector<vector<idVertex>> displaced(nbChunks);
+
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(nbChunks)
+#endif
+   for (int c = 0; c < nbChunks; ++c) {
+      const idVertex begin = (long long)c * nbVertices / nbChunks;
+      const idVertex end   = (long long)(c + 1) * nbVertices / nbChunks;
+      const size_t   maxMoved = (end - begin) / 16;
+      idVertex       top      = begin;
+      for (idVertex i = begin; i < end && displaced[c].size() <= maxMoved; ++i) {
+         const idVertex &v = sortHint_[i];
+         if (top == begin || !isLower<scalarType>(v, kept[top - 1])) {
+            kept[top++] = v;
+         } else {
+            displaced[c].emplace_back(v);
+            displaced[c].emplace_back(kept[--top]);
+         }
+      }
+      keptEnd[c] = top;
+   }
+
+   bool   fewMoved = true;
+   size_t nbMoved  = 0;
+   for (int c = 0; c < nbChunks; ++c) {
+      const idVertex chunkSize = (long long)(c + 1) * nbVertices / nbChunks -
+                                 (long long)c * nbVertices / nbChunks;
+      fewMoved &= displaced[c].size() <= (size_t)chunkSize / 16;
+      nbMoved += displaced[c].size();
+   }
+
+   sortedVertices_.resize(nbVertices);
+
+   if (fewMoved) {
+      vector<idVertex> moved;
+      moved.reserve(nbMoved);
+      for (const vector<idVertex> &d : displaced) {
+         moved.insert(moved.end(), d.cbegin(), d.cend());
+      }
+
+#ifdef withOpenMP
+      __gnu_parallel::sort(moved.begin(), moved.end(), indirect_less);
+
+      // one multiway merge of the kept sequences and the displaced vertices
+      using seqIt = vector<idVertex>::iterator;
+      vector<pair<seqIt, seqIt>> sequences;
+      sequences.reserve(nbChunks + 1);
+      for (int c = 0; c < nbChunks; ++c) {
+         const idVertex begin = (long long)c * nbVertices / nbChunks;
+         sequences.emplace_back(kept.begin() + begin, kept.begin() + keptEnd[c]);
+      }
+      sequences.emplace_back(moved.begin(), moved.end());
+
+      __gnu_parallel::multiway_merge(sequences.begin(), sequences.end(),
+                                     sortedVertices_.begin(), nbVertices, indirect_less);
+#else
+      sort(moved.begin(), moved.end(), indirect_less);
+      merge(kept.begin(), kept.begin() + keptEnd[0], moved.begin(), moved.end(),
+            sortedVertices_.begin(), indirect_less);
+#endif
+
+      if (debugLevel_ > 2) {
+         stringstream msg;
+         msg << "[MergeTree] Warm start sort : " << nbMoved << " vertices displaced" << endl;
+         dMsg(cout, msg.str(), advancedInfoMsg);
+      }
+
+      return 0;
+   }
+
+   // 2 - Most vertices moved a little (the whole field drifted):
+   // sort blocks of the hint then merge-split neighbor blocks (odd / even
+   // passes) until all the block boundaries are ordered. A pass moves a
+   // vertex by at most one block: after a few ones, merge all the blocks.
+   const idVertex blockSize  = 1 << 13;
+   const idVertex nbBlocks   = (nbVertices + blockSize - 1) / blockSize;
+   const int      maxPasses  = 2;
+   idVertex *     sorted     = sortedVertices_.data();
+
+   // vertices moved by more than a block make the passes useless:
+   // look for them in the hint sampled every half block
+   const idVertex stride = blockSize / 2;
+   idVertex       nbFar = 0, nbSamples = 0;
+   for (idVertex i = stride; i < nbVertices; i += stride, ++nbSamples) {
+      nbFar += isLower<scalarType>(sortHint_[i], sortHint_[i - stride]);
+   }
+   if (nbFar * 64 > nbSamples) {
+      return -1;
+   }
+
+   copy(sortHint_.cbegin(), sortHint_.cend(), sortedVertices_.begin());
+
+#ifdef withOpenMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (idVertex b = 0; b < nbBlocks; ++b) {
+      sort(sorted + b * blockSize, sorted + min(nbVertices, (b + 1) * blockSize),
+           indirect_less);
+   }
+
+   for (int pass = 0; pass < maxPasses; ++pass) {
+      bool changed = false;
+      for (int parity = 0; parity < 2; ++parity) {
+#ifdef withOpenMP
+#pragma omp parallel for schedule(dynamic) reduction(|| : changed)
+#endif
+         for (idVertex b = parity; b < nbBlocks - 1; b += 2) {
+            idVertex *mid = sorted + (b + 1) * blockSize;
+            if (isLower<scalarType>(*mid, *(mid - 1))) {
+               inplace_merge(sorted + b * blockSize, mid,
+                             sorted + min(nbVertices, (b + 2) * blockSize), indirect_less);
+               changed = true;
+            }
+         }
+      }
+
+      if (!changed) {
+         if (debugLevel_ > 2) {
+            stringstream msg;
+            msg << "[MergeTree] Warm start sort : blocks merged in " << pass << " passes" << endl;
+            dMsg(cout, msg.str(), advancedInfoMsg);
+         }
+         return 0;
+      }
+   }
+
+#ifdef withOpenMP
+   // the field changed too much: finish as a merge sort of the sorted blocks
+   vector<pair<idVertex *, idVertex *>> blocks(nbBlocks);
+   for (idVertex b = 0; b < nbBlocks; ++b) {
+      blocks[b] = make_pair(sorted + b * blockSize, sorted + min(nbVertices, (b + 1) * blockSize));
+   }
+   vector<idVertex> merged(nbVertices);
+   __gnu_parallel::multiway_merge(blocks.begin(), blocks.end(), merged.begin(), nbVertices,
+                                  indirect_less);
+   sortedVertices_.swap(merged);
+
+   if (debugLevel_ > 2) {
+      stringstream msg;
+      msg << "[MergeTree] Warm start sort : blocks not ordered after " << maxPasses
+          << " passes, merged" << endl;
+      dMsg(cout, msg.str(), advancedInfoMsg);
+   }
+
+   return 0;
+#else
+   return -1;
+#endif
+}
+
 // }
 
 // Process
@@ -798,6 +991,20 @@ void MergeTree::addPair(vector<pair<pair<int, int>, double>> &pairs,
 
 }
 
+template <typename scalarType>
+double MergeTree::branchMeasure(const idVertex &orig, const idVertex &term) const
+{
+   if (simplifyMethod_ == SimplifMethod::Span) {
+      float coordOrig[3], coordTerm[3];
+      mesh_->getVertexPoint(orig, coordOrig[0], coordOrig[1], coordOrig[2]);
+      mesh_->getVertexPoint(term, coordTerm[0], coordTerm[1], coordTerm[2]);
+      return Geometry::distance(coordOrig, coordTerm);
+   }
+
+   // cast before the difference for unsigned types
+   return fabs((double)((scalarType *)scalars_)[orig] - (double)((scalarType *)scalars_)[term]);
+}
+
 // }
 /// ---------------------------- CT
 
@@ -31,8 +31,9 @@ namespace wtfit
    // too large data
    using idCorresp = long long int;
 
-   /// \brief type use to store threads related numbers
-   using numThread = unsigned char;
+   /// \brief type use to store threads related numbers (also partitions, so
+   /// more than 255 of them for the two-level forests)
+   using numThread = unsigned short;
    /// \brief index of the interface/partition in vect_interfaces_
    using idInterface = numThread;
    using idPartition = numThread;
@@ -61,6 +62,8 @@ namespace wtfit
    enum ComponentState : char { VISIBLE, HIDDEN, PRUNED, MERGED };
 
    enum SimplifMethod : char { Persist=0, Span,  NbVert, NbArc };
+
+   enum TreeSelection : char { Join=0, Split, Contour, JoinAndSplit };
 }
 
 #endif /* end of include guard: DATATYPES_H */
@@ -1,4 +1,30 @@
 #include                  <ExplicitTriangulation.h>
+#include                  <Hash.h>
+
+#include                  <fcntl.h>
+#include                  <sys/mman.h>
+
+// Cache files: <cacheDirectory_>/mesh_<key>.<kind>, in the host byte order.
+//   edges:     CacheHeader | entryNumber pairs of int32
+//   neighbors: CacheHeader | (vertexNumber_ + 1) uint64 offsets 
+//              | entryNumber int32
+struct CacheHeader{
+  char                    magic[8];
+  uint32_t                version;
+  uint32_t                padding;
+  uint64_t                vertexNumber;
+  uint64_t                cellNumber;
+  uint64_t                key;
+  uint64_t                entryNumber;
+};
+
+static const char         cacheMagic[8] = 
+  {'W', 'T', 'F', 'I', 'T', 'T', 'R', '\0'};
+static const uint32_t     cacheVersion = 1;
+
+static_assert(sizeof(CacheHeader) == 48, "CacheHeader is not packed");
+static_assert(sizeof(pair<int, int>) == 2*sizeof(int32_t), 
+  "edges are not stored as pairs of int32");
 
 ExplicitTriangulation::ExplicitTriangulation(){
 
@@ -7,8 +33,218 @@ ExplicitTriangulation::ExplicitTriangulation(){
   
   cellNumber_ = 0;
   cellArray_ = NULL;
+  
+  hasCacheKey_ = false;
+  cacheKey_ = 0;
 }
 
 ExplicitTriangulation::~ExplicitTriangulation(){
 
 }
+
+string ExplicitTriangulation::getCacheFileName(const string &kind){
+  
+  if(!hasCacheKey_){
+    // cells are stored as [n, v0, ..., vn-1] with a constant n
+    const size_t cellArraySize = 
+      (cellNumber_) ? cellNumber_*(cellArray_[0] + 1) : 0;
+    
+    cacheKey_ = Hash::mix(vertexNumber_, cellNumber_);
+    cacheKey_ = Hash::buffer(cellArray_, 
+      cellArraySize*sizeof(long long int), cacheKey_);
+    hasCacheKey_ = true;
+  }
+  
+  stringstream fileName;
+  fileName << cacheDirectory_ << "/mesh_" << hex << cacheKey_ << "." << kind;
+  return fileName.str();
+}
+
+int ExplicitTriangulation::mapCache(const string &kind, 
+  char *&mapping, size_t &size, size_t &entryNumber){
+
+#ifndef withKamikaze
+  if(!cellArray_)
+    return -1;
+#endif
+  
+  int fd = open(getCacheFileName(kind).data(), O_RDONLY);
+  if(fd == -1)
+    return -2;
+  
+  struct stat fileStat;
+  if((fstat(fd, &fileStat) == -1)
+    ||((size_t) fileStat.st_size < sizeof(CacheHeader))){
+    close(fd);
+    return -3;
+  }
+  
+  size = fileStat.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED)
+    return -4;
+  
+  const CacheHeader *header = (const CacheHeader *) data;
+  if((memcmp(header->magic, cacheMagic, sizeof(cacheMagic)))
+    ||(header->version != cacheVersion)
+    ||(header->vertexNumber != (uint64_t) vertexNumber_)
+    ||(header->cellNumber != (uint64_t) cellNumber_)
+    ||(header->key != cacheKey_)){
+    munmap(data, size);
+    return -5;
+  }
+  
+  mapping = (char *) data;
+  entryNumber = header->entryNumber;
+  
+  // least recently used files are trimmed first (see OsCall::trimDirectory)
+  OsCall::touchFile(getCacheFileName(kind));
+  
+  return 0;
+}
+
+int ExplicitTriangulation::writeCache(const string &kind, 
+  const size_t &entryNumber, 
+  const vector<pair<const void *, size_t> > &blocks){
+  
+  const string fileName = getCacheFileName(kind);
+  // written aside then renamed: concurrent runs never map a partial file
+  stringstream tmpFileName;
+  tmpFileName << fileName << "." << getpid();
+  
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.version = cacheVersion;
+  header.vertexNumber = vertexNumber_;
+  header.cellNumber = cellNumber_;
+  header.key = cacheKey_;
+  header.entryNumber = entryNumber;
+  
+  {
+    ofstream file(tmpFileName.str().data(), ios::out | ios::binary);
+    file.write((const char *) &header, sizeof(header));
+    for(int i = 0; i < (int) blocks.size(); i++)
+      file.write((const char *) blocks[i].first, blocks[i].second);
+    
+    if(!file){
+      unlink(tmpFileName.str().data());
+      stringstream msg;
+      msg << "[ExplicitTriangulation] Could not write cache file `"
+        << fileName << "'." << endl;
+      dMsg(cerr, msg.str(), infoMsg);
+      return -1;
+    }
+  }
+  
+  if(rename(tmpFileName.str().data(), fileName.data())){
+    unlink(tmpFileName.str().data());
+    return -2;
+  }
+  
+  return 0;
+}
+
+int ExplicitTriangulation::readEdgeCache(){
+  
+  Timer t;
+  
+  char *mapping = NULL;
+  size_t size = 0, edgeNumber = 0;
+  
+  if(mapCache("edges", mapping, size, edgeNumber))
+    return -1;
+  
+  if(size != sizeof(CacheHeader) + edgeNumber*sizeof(pair<int, int>)){
+    munmap(mapping, size);
+    return -2;
+  }
+  
+  const pair<int, int> *edges = 
+    (const pair<int, int> *) (mapping + sizeof(CacheHeader));
+  edgeList_.assign(edges, edges + edgeNumber);
+  munmap(mapping, size);
+  
+  {
+    stringstream msg;
+    msg << "[ExplicitTriangulation] Edge-list read from cache in "
+      << t.getElapsedTime() << " s." << endl;
+    dMsg(cout, msg.str(), timeMsg);
+  }
+  
+  return 0;
+}
+
+int ExplicitTriangulation::readVertexNeighborCache(){
+  
+  Timer t;
+  
+  char *mapping = NULL;
+  size_t size = 0, neighborNumber = 0;
+  
+  if(mapCache("neighbors", mapping, size, neighborNumber))
+    return -1;
+  
+  const uint64_t *offsets = (const uint64_t *) (mapping + sizeof(CacheHeader));
+  const int *neighbors = (const int *) (offsets + vertexNumber_ + 1);
+  
+  if((size != sizeof(CacheHeader) + (vertexNumber_ + 1)*sizeof(uint64_t)
+    + neighborNumber*sizeof(int))
+    ||(offsets[vertexNumber_] != neighborNumber)){
+    munmap(mapping, size);
+    return -2;
+  }
+  
+  vertexNeighborList_.resize(vertexNumber_);
+  
+  getExecutor()->parallelFor(0, vertexNumber_,
+    [&](const int &i){
+    vertexNeighborList_[i].assign(
+      neighbors + offsets[i], neighbors + offsets[i + 1]);
+  }, threadNumber_);
+  munmap(mapping, size);
+  
+  {
+    stringstream msg;
+    msg << "[ExplicitTriangulation] One-skeleton read from cache in "
+      << t.getElapsedTime() << " s. (" << threadNumber_
+      << " thread(s))." << endl;
+    dMsg(cout, msg.str(), timeMsg);
+  }
+  
+  return 0;
+}
+
+int ExplicitTriangulation::writeEdgeCache(){
+  
+  vector<pair<const void *, size_t> > blocks;
+  blocks.push_back(pair<const void *, size_t>(
+    edgeList_.data(), edgeList_.size()*sizeof(pair<int, int>)));
+  
+  return writeCache("edges", edgeList_.size(), blocks);
+}
+
+int ExplicitTriangulation::writeVertexNeighborCache(){
+  
+  // flat (CSR) copy of the neighbors
+  vector<uint64_t> offsets(vertexNumber_ + 1, 0);
+  for(int i = 0; i < vertexNumber_; i++)
+    offsets[i + 1] = offsets[i] + vertexNeighborList_[i].size();
+  
+  vector<int> neighbors(offsets[vertexNumber_]);
+  
+  getExecutor()->parallelFor(0, vertexNumber_,
+    [&](const int &i){
+    copy(vertexNeighborList_[i].begin(), vertexNeighborList_[i].end(),
+      neighbors.begin() + offsets[i]);
+  }, threadNumber_);
+  
+  vector<pair<const void *, size_t> > blocks;
+  blocks.push_back(pair<const void *, size_t>(
+    offsets.data(), offsets.size()*sizeof(uint64_t)));
+  blocks.push_back(pair<const void *, size_t>(
+    neighbors.data(), neighbors.size()*sizeof(int)));
+  
+  return writeCache("neighbors", neighbors.size(), blocks);
+}
@@ -622,10 +622,17 @@ namespace wtfit{
       inline int preprocessEdges(){
         
         if(!edgeList_.size()){
+          if((cacheDirectory_.length())&&(!readEdgeCache()))
+            return 0;
+          
           OneSkeleton oneSkeleton;
           oneSkeleton.setWrapper(this);
-          return oneSkeleton.buildEdgeList(vertexNumber_, cellNumber_,
+          int ret = oneSkeleton.buildEdgeList(vertexNumber_, cellNumber_,
             cellArray_, edgeList_);
+          
+          if((!ret)&&(cacheDirectory_.length()))
+            writeEdgeCache();
+          return ret;
         }
         
         return 0;
@@ -748,10 +755,17 @@ namespace wtfit{
       inline int preprocessVertexNeighbors(){
         
         if((int) vertexNeighborList_.size() != vertexNumber_){
+          if((cacheDirectory_.length())&&(!readVertexNeighborCache()))
+            return 0;
+          
           ZeroSkeleton zeroSkeleton;
           zeroSkeleton.setWrapper(this);
-          return zeroSkeleton.buildVertexNeighbors(vertexNumber_, cellNumber_,
-            cellArray_, vertexNeighborList_, &edgeList_);
+          int ret = zeroSkeleton.buildVertexNeighbors(vertexNumber_, 
+            cellNumber_, cellArray_, vertexNeighborList_, &edgeList_);
+          
+          if((!ret)&&(cacheDirectory_.length()))
+            writeVertexNeighborCache();
+          return ret;
         }
         return 0;
       }
@@ -768,10 +782,19 @@ namespace wtfit{
         return 0;
       }
       
+      /// Store the edge list and the vertex neighbors in directory once they
+      /// are computed, and read them back (instead of computing them) on 
+      /// later runs over the same cells. Empty string: disabled (default).
+      inline int setCacheDirectory(const string &directory){
+        cacheDirectory_ = directory;
+        return 0;
+      }
+      
       inline int setInputCells(const int &cellNumber, 
         const long long int *cellArray){
         cellNumber_ = cellNumber;
         cellArray_ = cellArray;
+        hasCacheKey_ = false;
         
         return 0;
       }
@@ -779,6 +802,7 @@ namespace wtfit{
       inline int setInputPoints(const int &pointNumber, const float *pointSet){
         vertexNumber_ = pointNumber;
         pointSet_ = pointSet;
+        hasCacheKey_ = false;
         return 0;
       }
 
@@ -790,6 +814,28 @@ namespace wtfit{
       const float         *pointSet_;
       const long long int *cellArray_;
       
+      // preprocessing cache, keyed by a hash of the cell array
+      string              cacheDirectory_;
+      bool                hasCacheKey_;
+      uint64_t            cacheKey_;
+      
+      string getCacheFileName(const string &kind);
+      
+      // maps the file, the data follow a CacheHeader (see the .cpp)
+      int mapCache(const string &kind, char *&mapping, size_t &size, 
+        size_t &entryNumber);
+      
+      int writeCache(const string &kind, const size_t &entryNumber,
+        const vector<pair<const void *, size_t> > &blocks);
+      
+      int readEdgeCache();
+      
+      int readVertexNeighborCache();
+      
+      int writeEdgeCache();
+      
+      int writeVertexNeighborCache();
+      
   };
 }
 
@@ -37,54 +37,50 @@ int OneSkeleton::buildEdgeList(const int &vertexNumber, const int &cellNumber,
   // assuming triangulations here
   int verticesPerCell = cellArray[0];
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < cellNumber; i++){
-    
-    int threadId = 0, tmpVertexId = 0;
-    pair<int, int> edgeIds;
-#ifdef withOpenMP
-    threadId = omp_get_thread_num();
-#endif
+  getExecutor()->parallelChunks(threadNumber_, 0, cellNumber,
+    [&](const int &threadId, const int &first, const int &last){
+    for(int i = first; i < last; i++){
+      int tmpVertexId = 0;
+      pair<int, int> edgeIds;
    
-    // tet case
-    // 0 - 1
-    // 0 - 2
-    // 0 - 3
-    // 1 - 2
-    // 1 - 3
-    // 2 - 3
-    for(int j = 0; j <= verticesPerCell - 2; j++){
-      for(int k = j + 1; k <= verticesPerCell - 1; k++){
-        // edge processing
-        edgeIds.first = cellArray[(verticesPerCell + 1)*i + 1 + j];
-        edgeIds.second = cellArray[(verticesPerCell + 1)*i + 1 + k];
+      // tet case
+      // 0 - 1
+      // 0 - 2
+      // 0 - 3
+      // 1 - 2
+      // 1 - 3
+      // 2 - 3
+      for(int j = 0; j <= verticesPerCell - 2; j++){
+        for(int k = j + 1; k <= verticesPerCell - 1; k++){
+          // edge processing
+          edgeIds.first = cellArray[(verticesPerCell + 1)*i + 1 + j];
+          edgeIds.second = cellArray[(verticesPerCell + 1)*i + 1 + k];
         
-        if(edgeIds.first > edgeIds.second){
-          tmpVertexId = edgeIds.first;
-          edgeIds.first = edgeIds.second;
-          edgeIds.second = tmpVertexId;
-        }
+          if(edgeIds.first > edgeIds.second){
+            tmpVertexId = edgeIds.first;
+            edgeIds.first = edgeIds.second;
+            edgeIds.second = tmpVertexId;
+          }
         
         
              
-        bool hasFound = false;
-        for(int l = 0; 
-          l < (int) threadedEdgeTable[threadId][edgeIds.first].size(); l++){
-          if(edgeIds.second == threadedEdgeTable[threadId][edgeIds.first][l]){
-            hasFound = true;
-            break;
+          bool hasFound = false;
+          for(int l = 0; 
+            l < (int) threadedEdgeTable[threadId][edgeIds.first].size(); l++){
+            if(edgeIds.second == threadedEdgeTable[threadId][edgeIds.first][l]){
+              hasFound = true;
+              break;
+            }
           }
+          if(!hasFound){
+            threadedEdgeTable[threadId][edgeIds.first].push_back(
+              edgeIds.second);
+          }
+          // end of edge processing
         }
-        if(!hasFound){
-          threadedEdgeTable[threadId][edgeIds.first].push_back(
-            edgeIds.second);
-        }
-        // end of edge processing
       }
     }
-  }
+  });
   
   // now merge the thing
   int edgeCount = 0;
@@ -164,13 +160,11 @@ int OneSkeleton::buildEdgeLists(
   
   edgeLists.resize(cellArrays.size());
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < (int) cellArrays.size(); i++){
+  getExecutor()->parallelFor(0, (int) cellArrays.size(),
+    [&](const int &i){
     buildEdgeSubList(cellArrays[i].size()/(cellArrays[i][0] + 1), 
       cellArrays[i].data(), edgeLists[i]);
-  }
+  }, threadNumber_);
   
   {
     stringstream msg;
@@ -238,15 +232,14 @@ int OneSkeleton::buildEdgeStars(const int &vertexNumber, const int &cellNumber,
   if((int) localVertexStars->size() != vertexNumber){
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.buildVertexStars(vertexNumber, cellNumber,
       cellArray, *localVertexStars);
   }
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < (int) localEdgeList->size(); i++){
+  getExecutor()->parallelFor(0, (int) localEdgeList->size(),
+    [&](const int &i){
     
     int vertex0 = (*localEdgeList)[i].first;
     int vertex1 = (*localEdgeList)[i].second;
@@ -266,7 +259,7 @@ int OneSkeleton::buildEdgeStars(const int &vertexNumber, const int &cellNumber,
         starList[i].push_back((*localVertexStars)[vertex0][j]);
       }
     }
-  }
+  }, threadNumber_);
   
   if(localEdgeListAlloc)
     delete localEdgeList;
@@ -40,6 +40,7 @@ int ThreeSkeleton::buildCellEdges(const int &vertexNumber,
     OneSkeleton oneSkeleton;
     oneSkeleton.setDebugLevel(debugLevel_);
     oneSkeleton.setThreadNumber(threadNumber_);
+    oneSkeleton.setExecutor(executor_);
     oneSkeleton.buildEdgeList(
       vertexNumber, cellNumber, cellArray, *localEdgeList);
   }
@@ -54,6 +55,7 @@ int ThreeSkeleton::buildCellEdges(const int &vertexNumber,
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     zeroSkeleton.buildVertexEdges(vertexNumber,
       *localEdgeList, *localVertexEdges);
   }
@@ -68,8 +70,8 @@ int ThreeSkeleton::buildCellEdges(const int &vertexNumber,
   
   // for each cell, for each pair of vertices, find the edge
   // TODO: check for parallel efficiency here
-#pragma omp parallel for num_threads(threadNumber_)
-  for(int i = 0; i < cellNumber; i++){
+  getExecutor()->parallelFor(0, cellNumber,
+    [&](const int &i){
     
     int cellId = (vertexPerCell+1)*i;
     
@@ -96,7 +98,7 @@ int ThreeSkeleton::buildCellEdges(const int &vertexNumber,
       }
       
     }
-  }
+  }, threadNumber_);
   
   if(localEdgeListAlloc)
     delete localEdgeList;
@@ -134,6 +136,7 @@ int ThreeSkeleton::buildCellNeighborsFromTriangles(const int &vertexNumber,
   
     TwoSkeleton twoSkeleton;
     twoSkeleton.setThreadNumber(threadNumber_);
+    twoSkeleton.setExecutor(executor_);
     twoSkeleton.setDebugLevel(debugLevel_);
     twoSkeleton.buildTriangleList(vertexNumber, cellNumber, cellArray, NULL, 
       localTriangleStars);
@@ -175,29 +178,23 @@ int ThreeSkeleton::buildCellNeighborsFromTriangles(const int &vertexNumber,
         threadedCellNeighbors[i][j].reserve(4);
     }
     
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-    for(int i = 0; i < (int) (*localTriangleStars).size(); i++){
-      
-      int threadId = 0;
-#ifdef withOpenMP
-      threadId = omp_get_thread_num();
-#endif
-      
-      if((*localTriangleStars)[i].size() == 2){
+    getExecutor()->parallelChunks(threadNumber_, 0, (int) (*localTriangleStars).size(),
+      [&](const int &threadId, const int &first, const int &last){
+      for(int i = first; i < last; i++){
+        if((*localTriangleStars)[i].size() == 2){
         
-        // interior triangles
+          // interior triangles
         
-        threadedCellNeighbors[threadId][
-          (*localTriangleStars)[i][0]].push_back( 
-            (*localTriangleStars)[i][1]);
+          threadedCellNeighbors[threadId][
+            (*localTriangleStars)[i][0]].push_back( 
+              (*localTriangleStars)[i][1]);
           
-        threadedCellNeighbors[threadId][
-          (*localTriangleStars)[i][1]].push_back(
-            (*localTriangleStars)[i][0]);
+          threadedCellNeighbors[threadId][
+            (*localTriangleStars)[i][1]].push_back(
+              (*localTriangleStars)[i][0]);
+        }
       }
-    }
+    });
     
     // now merge things
     for(int i = 0; i < threadNumber_; i++){
@@ -255,6 +252,7 @@ int ThreeSkeleton::buildCellNeighborsFromVertices(
     TwoSkeleton twoSkeleton;
     twoSkeleton.setDebugLevel(debugLevel_);
     twoSkeleton.setThreadNumber(threadNumber_);
+    twoSkeleton.setExecutor(executor_);
     return twoSkeleton.buildCellNeighborsFromVertices(vertexNumber, cellNumber,
       cellArray, cellNeighbors, vertexStars);
   }
@@ -282,6 +280,7 @@ int ThreeSkeleton::buildCellNeighborsFromVertices(
     
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.buildVertexStars(vertexNumber, cellNumber, cellArray, 
       *localVertexStars);
@@ -294,16 +293,12 @@ int ThreeSkeleton::buildCellNeighborsFromVertices(
     cellNeighbors[i].reserve(vertexPerCell);
  
   // pre-sort vertex stars
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < vertexNumber; i++)
+  getExecutor()->parallelFor(0, vertexNumber, [&](const int &i){
     sort((*localVertexStars)[i].begin(), (*localVertexStars)[i].end());
+  }, threadNumber_);
 
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif  
-  for(int i = 0; i < cellNumber; i++){
+  getExecutor()->parallelFor(0, cellNumber,
+    [&](const int &i){
     
     // go triangle by triangle
     for(int j = 0; j < vertexPerCell; j++){
@@ -373,7 +368,7 @@ int ThreeSkeleton::buildCellNeighborsFromVertices(
         cellNeighbors[i].push_back(intersection);
       }
     }
-  }
+  }, threadNumber_);
   
   if(localVertexStarsAlloc)
     delete localVertexStars;
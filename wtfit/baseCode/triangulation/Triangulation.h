@@ -3361,6 +3361,15 @@ namespace wtfit{
         return explicitTriangulation_.setInputCells(cellNumber, cellArray);
       }
       
+      /// Set the directory where the pre-processed edge list and vertex 
+      /// neighbors of an explicit triangulation are stored and read back on 
+      /// later runs over the same cells.
+      /// \param directory Cache directory (empty string: disabled).
+      /// \return Returns 0 upon success, negative values otherwise.
+      inline int setCacheDirectory(const string &directory){
+        return explicitTriangulation_.setCacheDirectory(directory);
+      }
+      
       /// Set the specifications of the input grid to implicitly represent as a
       /// triangulation.
       /// \param xOrigin Input x coordinate of the grid origin.
@@ -3411,6 +3420,17 @@ namespace wtfit{
         return 0;
       }
 
+      /// Tune the executor running the parallel loops of the preprocessing.
+      /// \param executor Executor (NULL: OpenMP).
+      /// \return Returns 0 upon success, negative values otherwise.
+      /// \sa Executor
+      inline int setExecutor(Executor *executor){
+        explicitTriangulation_.setExecutor(executor);
+        implicitTriangulation_.setExecutor(executor);
+        executor_ = executor;
+        return 0;
+      }
+
 
       /// Internal usage. Pass the execution context (debug level, number of 
       /// threads, etc.) to the implementing classes.
@@ -27,6 +27,7 @@ int TwoSkeleton::buildCellNeighborsFromVertices(const int &vertexNumber,
     
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.buildVertexStars(vertexNumber, cellNumber, cellArray, 
       *localVertexStars);
@@ -39,16 +40,12 @@ int TwoSkeleton::buildCellNeighborsFromVertices(const int &vertexNumber,
     cellNeighbors[i].reserve(vertexPerCell);
   
   // pre-sort vertex stars
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < vertexNumber; i++)
+  getExecutor()->parallelFor(0, vertexNumber, [&](const int &i){
     sort((*localVertexStars)[i].begin(), (*localVertexStars)[i].end());
+  }, threadNumber_);
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < cellNumber; i++){
+  getExecutor()->parallelFor(0, cellNumber,
+    [&](const int &i){
     
     for(int j = 0; j < vertexPerCell; j++){
       
@@ -101,7 +98,7 @@ int TwoSkeleton::buildCellNeighborsFromVertices(const int &vertexNumber,
         cellNeighbors[i].push_back(intersection);
       }
     }
-  }
+  }, threadNumber_);
   
   if(localVertexStarsAlloc)
     delete localVertexStars;
@@ -184,6 +181,7 @@ int TwoSkeleton::buildEdgeTriangles(const int &vertexNumber,
   OneSkeleton oneSkeleton;
   oneSkeleton.setDebugLevel(debugLevel_);
   oneSkeleton.setThreadNumber(threadNumber_);
+  oneSkeleton.setExecutor(executor_);
   
   // now do the pre-computation
   if(localEdgeList->empty()){
@@ -206,10 +204,8 @@ int TwoSkeleton::buildEdgeTriangles(const int &vertexNumber,
   edgeTriangleList.resize(localEdgeList->size());
   
   // alright, let's get things done now.
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < (int) localEdgeList->size(); i++){
+  getExecutor()->parallelFor(0, (int) localEdgeList->size(),
+    [&](const int &i){
     
     int vertexId0, vertexId1, vertexId2;
     
@@ -261,7 +257,7 @@ int TwoSkeleton::buildEdgeTriangles(const int &vertexNumber,
         }
       }
     }
-  }
+  }, threadNumber_);
   
   int edgeNumber = localEdgeList->size();
   int triangleNumber = localTriangleList->size();
@@ -668,6 +664,7 @@ int TwoSkeleton::buildTriangleEdgeList(const int &vertexNumber,
     OneSkeleton oneSkeleton;
     oneSkeleton.setDebugLevel(debugLevel_);
     oneSkeleton.setThreadNumber(threadNumber_);
+    oneSkeleton.setExecutor(executor_);
     
     oneSkeleton.buildEdgeList(vertexNumber, cellNumber, cellArray,
       (*localEdgeList));
@@ -685,6 +682,7 @@ int TwoSkeleton::buildTriangleEdgeList(const int &vertexNumber,
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     
     zeroSkeleton.buildVertexEdges(vertexNumber, (*localEdgeList), 
       (*localVertexEdgeList));
@@ -713,10 +711,8 @@ int TwoSkeleton::buildTriangleEdgeList(const int &vertexNumber,
   // now for each triangle, grab its vertices, add the edges in the triangle
   // with no duplicate
   // let's do the real stuff
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < (int) localTriangleList->size(); i++){
+  getExecutor()->parallelFor(0, (int) localTriangleList->size(),
+    [&](const int &i){
     int vertexId = -1;
     for(int j = 0; j < (int) (*localTriangleList)[i].size(); j++){
       vertexId = (*localTriangleList)[i][j];
@@ -752,7 +748,7 @@ int TwoSkeleton::buildTriangleEdgeList(const int &vertexNumber,
         }
       }
     }
-  }
+  }, threadNumber_);
   
   int triangleNumber = localTriangleList->size();
   int edgeNumber = localEdgeList->size();
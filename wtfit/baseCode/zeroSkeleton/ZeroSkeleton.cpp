@@ -38,20 +38,13 @@ int ZeroSkeleton::buildVertexEdges(const int &vertexNumber,
       threadedVertexEdges[i].resize(vertexNumber);
     }
       
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-    for(int i = 0; i < (int) edgeList.size(); i++){
-      
-      int threadId = 0;
-      
-#ifdef withOpenMP
-      threadId = omp_get_thread_num();
-#endif
-      
-      threadedVertexEdges[threadId][edgeList[i].first].push_back(i);
-      threadedVertexEdges[threadId][edgeList[i].second].push_back(i);
-    }
+    getExecutor()->parallelChunks(threadNumber_, 0, (int) edgeList.size(),
+      [&](const int &threadId, const int &first, const int &last){
+      for(int i = first; i < last; i++){
+        threadedVertexEdges[threadId][edgeList[i].first].push_back(i);
+        threadedVertexEdges[threadId][edgeList[i].second].push_back(i);
+      }
+    });
     
     // now merge the thing
     for(int i = 0; i < threadNumber_; i++){
@@ -207,6 +200,7 @@ int ZeroSkeleton::buildVertexLinks(const int &vertexNumber,
     ZeroSkeleton zeroSkeleton;
     zeroSkeleton.setDebugLevel(debugLevel_);
     zeroSkeleton.setThreadNumber(threadNumber_);
+    zeroSkeleton.setExecutor(executor_);
     zeroSkeleton.buildVertexStars(vertexNumber, cellNumber, cellArray,
       *localVertexStars);
   }
@@ -238,103 +232,97 @@ int ZeroSkeleton::buildVertexLinks(const int &vertexNumber,
   // 8-thread (4 cores): 0.38 s. [< 18%] total 2.53
   // processing: 
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < vertexNumber; i++){
-    
-    int threadId = 0;
-#ifdef withOpenMP
-    threadId = omp_get_thread_num();
-#endif
-
-    for(int j = 0; j < (int) (*localVertexStars)[i].size(); j++){
+  getExecutor()->parallelChunks(threadNumber_, 0, vertexNumber,
+    [&](const int &threadId, const int &first, const int &last){
+    for(int i = first; i < last; i++){
+      for(int j = 0; j < (int) (*localVertexStars)[i].size(); j++){
 
 
-      int cellId = (*localVertexStars)[i][j];
+        int cellId = (*localVertexStars)[i][j];
       
-      // tet case (4)
-      // 0 - 1 - 2
-      // 0 - 1 - 3
-      // 0 - 2 - 3
-      // 1 - 2 - 3
-      // triangle case (3)
-      // 0 - 1 
-      // 0 - 2
-      // 1 - 2
-      // edge case (2)
-      // 0 
-      // 1
-      bool hasPivotVertex = false;
+        // tet case (4)
+        // 0 - 1 - 2
+        // 0 - 1 - 3
+        // 0 - 2 - 3
+        // 1 - 2 - 3
+        // triangle case (3)
+        // 0 - 1 
+        // 0 - 2
+        // 1 - 2
+        // edge case (2)
+        // 0 
+        // 1
+        bool hasPivotVertex = false;
       
-      // iterate on the cell's faces
-      for(int k = 0; k < 2; k++){
+        // iterate on the cell's faces
+        for(int k = 0; k < 2; k++){
         
-        faceIds[threadId][1] = 
-          cellArray[(verticesPerCell + 1)*cellId + 1 + k];
+          faceIds[threadId][1] = 
+            cellArray[(verticesPerCell + 1)*cellId + 1 + k];
           
-        if(faceIds[threadId][1] != i){
+          if(faceIds[threadId][1] != i){
           
-          if(verticesPerCell > 2){
+            if(verticesPerCell > 2){
             
-            for(int l = k + 1; l <= verticesPerCell - 1; l++){
-              faceIds[threadId][2] = 
-                cellArray[(verticesPerCell + 1)*cellId + 1 + l];
+              for(int l = k + 1; l <= verticesPerCell - 1; l++){
+                faceIds[threadId][2] = 
+                  cellArray[(verticesPerCell + 1)*cellId + 1 + l];
                 
-              if(faceIds[threadId][2] != i){
+                if(faceIds[threadId][2] != i){
                 
-                if(verticesPerCell == 4){
-                  // tet case, faceIds[threadId] has 4 entries to fill
-                  for(int m = l + 1; m < verticesPerCell; m++){
-                    faceIds[threadId][3] = 
-                      cellArray[(verticesPerCell + 1)*cellId + 1 + m];
+                  if(verticesPerCell == 4){
+                    // tet case, faceIds[threadId] has 4 entries to fill
+                    for(int m = l + 1; m < verticesPerCell; m++){
+                      faceIds[threadId][3] = 
+                        cellArray[(verticesPerCell + 1)*cellId + 1 + m];
                     
-                    // now test if this face contains our vertex or not
-                    // there's should be only one face
-                    if(faceIds[threadId][3] != i){
-                      // all the vertices of the face are different from our 
-                      // pivot vertex.
-                      // let's add that face to the link
-                      for(int n = 0; n < (int) faceIds[threadId].size(); n++){
-                        vertexLinks[i][j*(verticesPerCell) + n]
-                          = faceIds[threadId][n];
+                      // now test if this face contains our vertex or not
+                      // there's should be only one face
+                      if(faceIds[threadId][3] != i){
+                        // all the vertices of the face are different from our 
+                        // pivot vertex.
+                        // let's add that face to the link
+                        for(int n = 0; n < (int) faceIds[threadId].size(); n++){
+                          vertexLinks[i][j*(verticesPerCell) + n]
+                            = faceIds[threadId][n];
+                        }
+                        hasPivotVertex = true;
+                        break;
                       }
-                      hasPivotVertex = true;
-                      break;
                     }
                   }
-                }
-                else if(verticesPerCell == 3){
-                  // triangle case
-                  // we're holding to an edge that does not contain our vertex
-                  for(int n = 0; n < (int) faceIds[threadId].size(); n++){
-                    vertexLinks[i][j*(verticesPerCell) + n] = 
-                      faceIds[threadId][n];
+                  else if(verticesPerCell == 3){
+                    // triangle case
+                    // we're holding to an edge that does not contain our vertex
+                    for(int n = 0; n < (int) faceIds[threadId].size(); n++){
+                      vertexLinks[i][j*(verticesPerCell) + n] = 
+                        faceIds[threadId][n];
+                    }
+                    hasPivotVertex = true;
+                    break;
                   }
-                  hasPivotVertex = true;
-                  break;
+                  if(hasPivotVertex)
+                    break;
                 }
-                if(hasPivotVertex)
-                  break;
               }
             }
-          }
-          else if(verticesPerCell == 2){
-            // edge-mesh case
-            // we holding a neighbor different from us
-            for(int n = 0; n < (int) faceIds[threadId].size(); n++){
-              vertexLinks[i][j*(verticesPerCell) + n] = 
-                faceIds[threadId][n];
+            else if(verticesPerCell == 2){
+              // edge-mesh case
+              // we holding a neighbor different from us
+              for(int n = 0; n < (int) faceIds[threadId].size(); n++){
+                vertexLinks[i][j*(verticesPerCell) + n] = 
+                  faceIds[threadId][n];
+              }
+              hasPivotVertex = true;
+              break;
             }
-            hasPivotVertex = true;
-            break;
           }
+          if(hasPivotVertex)
+            break;
         }
-        if(hasPivotVertex)
-          break;
       }
     }
-  }
+  });
   
   if(debugLevel_ >= Debug::advancedInfoMsg){
     stringstream msg;
@@ -402,6 +390,7 @@ int ZeroSkeleton::buildVertexNeighbors(const int &vertexNumber,
     OneSkeleton oneSkeleton;
     oneSkeleton.setDebugLevel(debugLevel_);
     oneSkeleton.setThreadNumber(threadNumber_);
+    oneSkeleton.setExecutor(executor_);
     oneSkeleton.buildEdgeList(vertexNumber, cellNumber, cellArray, 
       *localEdgeList);
   }
@@ -469,21 +458,15 @@ int ZeroSkeleton::buildVertexStars(const int &vertexNumber,
 
   int vertexNumberPerCell = cellArray[0];
   
-#ifdef withOpenMP
-#pragma omp parallel for num_threads(threadNumber_)
-#endif
-  for(int i = 0; i < cellNumber; i++){
-    
-    int threadId = 0;
-#ifdef withOpenMP
-    threadId = omp_get_thread_num();
-#endif
-    
-    for(int j = 0; j < vertexNumberPerCell; j++){
-      (*threadedZeroSkeleton[threadId])[
-        cellArray[(vertexNumberPerCell + 1)*i + 1 + j]].push_back(i);
+  getExecutor()->parallelChunks(threadNumber_, 0, cellNumber,
+    [&](const int &threadId, const int &first, const int &last){
+    for(int i = first; i < last; i++){
+      for(int j = 0; j < vertexNumberPerCell; j++){
+        (*threadedZeroSkeleton[threadId])[
+          cellArray[(vertexNumberPerCell + 1)*i + 1 + j]].push_back(i);
+      }
     }
-  }
+  });
  
   if(threadNumber_ > 1){
     // now merge the thing
@@ -9,6 +9,16 @@ vtkContourForests::vtkContourForests()
       isLoaded_{},
       calculSegmentation_{true},
       lessPartition_{false},
+      partitionsPerThread_{1},
+      partitionGroups_{1},
+      pruneOnTheFly_{false},
+      partitionSort_{false},
+      workBalance_{false},
+      overlapWeight_{},
+      threadPool_{false},
+      threadPoolExecutor_{},
+      numaReplication_{false},
+      threadAffinity_{},
       tree_{},
       // Here the given number of core only serve for preprocess,
       // a clean tree append before the true process and re-set
@@ -41,6 +51,9 @@ vtkContourForests::vtkContourForests()
       showSaddle1_{},
       showSaddle2_{},
       showArc_{},
+      showRegionType_{true},
+      showRegionSize_{true},
+      showRegionSpan_{true},
       arcResolution_{1},
       partitionNum_{-1},
       skeletonSmoothing_{},
@@ -48,6 +61,8 @@ vtkContourForests::vtkContourForests()
       simplificationThreshold_{},
       simplificationThresholdBuffer_{},
       simplifyPersistenceDiagram_{},
+      sortCacheDirectory_{},
+      meshCacheDirectory_{},
 
       /// Computation handles ///
       toUpdateVertexSoSoffsets_{true},
@@ -64,17 +79,23 @@ vtkContourForests::vtkContourForests()
       originalNumberOfCriticalPoints_{},
       numberOfVertices_{},
       triangulation_{new vtkTriangulation},
-      vertexPositions_{new vector<vector<double>>},
+      pointInput_{nullptr},
       vertexSoSoffsets_{new vector<int>},
       criticalPoints_{new vector<int>},
+      nodeTypes_{new vector<NodeType>},
       vertexScalars_{nullptr},
-      inputScalars_{new vector<vector<double>>},
+      inputScalars_{new vector<vtkDataArray*>},
       inputScalarsName_{new vector<string>},
       mergePairs_{new vector<pair<pair<int, int>, double>>},
       splitPairs_{new vector<pair<pair<int, int>, double>>},
       pairs_{new vector<pair<pair<int, int>, double>>},
-      samples_{new vector<vector<vector<vector<int>>>>},
-      barycenters_{new vector<vector<vector<vector<double>>>>}
+      arcSampleOffsets_{new vector<int>},
+      sampleOffsets_{new vector<int>},
+      sampleVertices_{new vector<int>},
+      barycenters_{new vector<double>},
+      previousScalars_{new vector<char>},
+      previousScalarsType_{-1},
+      previousThreshold_{}
 {
    contourTree_->setWrapper(this);
    contourTree_->setDebugLevel(debugLevel_);
@@ -90,6 +111,7 @@ vtkContourForests::~vtkContourForests()
 {
    /// Base ///
    delete contourTree_;
+   delete threadPoolExecutor_;
    skeletonNodes_->Delete();
    skeletonArcs_->Delete();
    // segmentation_->Delete();
@@ -108,21 +130,26 @@ vtkContourForests::~vtkContourForests()
 
    /// Convenient storage ///
    delete triangulation_;
-   delete vertexPositions_;
    delete vertexSoSoffsets_;
    delete criticalPoints_;
+   delete nodeTypes_;
    delete inputScalars_;
    delete inputScalarsName_;
    delete mergePairs_;
    delete splitPairs_;
    delete pairs_;
-   delete samples_;
+   delete arcSampleOffsets_;
+   delete sampleOffsets_;
+   delete sampleVertices_;
    delete barycenters_;
+   delete previousScalars_;
 }
 
 void vtkContourForests::clearSkeleton()
 {
-   samples_->clear();
+   arcSampleOffsets_->clear();
+   sampleOffsets_->clear();
+   sampleVertices_->clear();
    barycenters_->clear();
 
    skeletonNodes_->Delete();
@@ -152,12 +179,28 @@ void vtkContourForests::clearTree()
 
    }
 
+   // time-varying data: the previous order is a good start for the next sort
+   vector<int> previousOrder;
+   if (varyingDataValues_ && contourTree_)
+      previousOrder = contourTree_->getSortedVertices();
+
    delete contourTree_;
    contourTree_ = new ParallelContourTree(nbThread);
    contourTree_->setWrapper(this);
    contourTree_->setDebugLevel(debugLevel_);
    contourTree_->setLessPartition(lessPartition_);
+   contourTree_->setNbPartitions(nbThread * partitionsPerThread_);
+   contourTree_->setNbGroups(partitionGroups_);
+   contourTree_->setPruneOnTheFly(pruneOnTheFly_);
+   contourTree_->setPartitionSort(partitionSort_);
+   contourTree_->setWorkBalance(workBalance_);
+   contourTree_->setOverlapWeight(overlapWeight_);
+   contourTree_->setNumaReplication(numaReplication_);
+   contourTree_->setThreadAffinity(threadAffinity_);
+   contourTree_->setSortCacheDirectory(sortCacheDirectory_);
    contourTree_->setThreadNumber(nbThread);
+   if (previousOrder.size())
+      contourTree_->warmStart(previousOrder);
 
    mergePairs_->clear();
    splitPairs_->clear();
@@ -223,6 +266,19 @@ void vtkContourForests::SetThreads()
    else
       threadNumber_ = OsCall::getNumberOfCores();
 
+   // persistent threads, kept between the updates
+   if (threadPool_) {
+      delete threadPoolExecutor_;
+      threadPoolExecutor_ = new ThreadPoolExecutor(threadNumber_);
+      setExecutor(threadPoolExecutor_);
+   } else if (threadPoolExecutor_) {
+      setExecutor(nullptr);
+      delete threadPoolExecutor_;
+      threadPoolExecutor_ = nullptr;
+   }
+
+   // other partitions: the last tree can not be updated
+   previousScalars_->clear();
    Modified();
 }
 
@@ -244,6 +300,27 @@ void vtkContourForests::SetUseAllCores(bool onOff)
    SetThreads();
 }
 
+void vtkContourForests::SetThreadPool(bool p)
+{
+   threadPool_ = p;
+   SetThreads();
+}
+
+void vtkContourForests::SetNumaReplication(bool r)
+{
+   numaReplication_ = r;
+   Modified();
+}
+
+void vtkContourForests::SetThreadAffinity(string affinity)
+{
+   // built again with the new placement, to compare the timings
+   toComputeContourTree_ = true;
+
+   threadAffinity_ = affinity;
+   Modified();
+}
+
 void vtkContourForests::SetUseInputOffsetScalarField(bool onOff)
 {
    toUpdateVertexSoSoffsets_ = true;
@@ -294,8 +371,8 @@ void vtkContourForests::SetTreeType(int treeType)
 {
    if (treeType >= 0 && treeType <= 2) {
       toUpdateTree_ = true;
-      if (treeType_ == TreeType::CONTOUR_TREE ||
-          static_cast<TreeType>(treeType) == TreeType::CONTOUR_TREE) {
+      // only the requested tree is built
+      if (treeType_ != static_cast<TreeType>(treeType)) {
          toComputeContourTree_ = true;
       }
 
@@ -357,6 +434,30 @@ void vtkContourForests::ShowSegmentation(bool segm)
    }
 }
 
+void vtkContourForests::ShowRegionType(bool state)
+{
+   toComputeSegmentation_ = true;
+
+   showRegionType_ = state;
+   Modified();
+}
+
+void vtkContourForests::ShowRegionSize(bool state)
+{
+   toComputeSegmentation_ = true;
+
+   showRegionSize_ = state;
+   Modified();
+}
+
+void vtkContourForests::ShowRegionSpan(bool state)
+{
+   toComputeSegmentation_ = true;
+
+   showRegionSpan_ = state;
+   Modified();
+}
+
 void vtkContourForests::SetArcResolution(int arcResolution)
 {
    if (arcResolution >= 0) {
@@ -370,12 +471,54 @@ void vtkContourForests::SetArcResolution(int arcResolution)
 void vtkContourForests::SetPartitionNumber(int partitionNum)
 {
    partitionNum_ = partitionNum;
+   previousScalars_->clear();
    Modified();
 }
 
 void vtkContourForests::SetLessPartition(bool l)
 {
     lessPartition_ = l;
+    previousScalars_->clear();
+    Modified();
+}
+
+void vtkContourForests::SetPartitionsPerThread(int p)
+{
+    partitionsPerThread_ = (p > 0) ? p : 1;
+    previousScalars_->clear();
+    Modified();
+}
+
+void vtkContourForests::SetPartitionGroups(int g)
+{
+    partitionGroups_ = (g > 0) ? g : 1;
+    Modified();
+}
+
+void vtkContourForests::SetPruneOnTheFly(bool p)
+{
+    pruneOnTheFly_ = p;
+    previousScalars_->clear();
+    Modified();
+}
+
+void vtkContourForests::SetPartitionSort(bool p)
+{
+    partitionSort_ = p;
+    Modified();
+}
+
+void vtkContourForests::SetWorkBalance(bool b)
+{
+    workBalance_ = b;
+    previousScalars_->clear();
+    Modified();
+}
+
+void vtkContourForests::SetOverlapWeight(double w)
+{
+    overlapWeight_ = w;
+    previousScalars_->clear();
     Modified();
 }
 
@@ -426,66 +569,110 @@ void vtkContourForests::SetSimplifyPersistenceDiagram(bool state)
    Modified();
 }
 
-int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
+int vtkContourForests::WriteTree(string fileName)
 {
-   // init
-   if (varyingMeshGeometry_ || !numberOfVertices_)
-      numberOfVertices_ = input->GetNumberOfPoints();
+   if (!tree_) {
+      vtkGenericWarningMacro(<< "No tree to write, update the filter first.");
+      return -1;
+   }
 
-   // scalars
-   if (varyingDataValues_ || !inputScalarsName_->size()) {
-      if (input->GetPointData()) {
-         int numberOfArrays = input->GetPointData()->GetNumberOfArrays();
-         int numberOfScalarArrays{};
-
-         for (int i = 0; i < numberOfArrays; ++i) {
-            vtkDataArray* inputArray = input->GetPointData()->GetArray(i);
-            if (inputArray) {
-               if (inputArray->GetNumberOfTuples() == numberOfVertices_ &&
-                   inputArray->GetNumberOfComponents() == 1) {
-                  ++numberOfScalarArrays;
-               }
-            }
+   // the loaded trees have no scalars: store their persistence pairs
+   vector<pair<pair<int, int>, double>>* treePairs = nullptr;
+   switch (vertexScalars_->GetDataType()) {
+      vtkTemplateMacro({
+         switch (treeType_) {
+            case TreeType::MERGE_TREE:
+               treePairs = mergePairs_;
+               if (treePairs->empty())
+                  contourTree_->getJoinTree()->computePersistencePairs<VTK_TT>(*treePairs);
+               break;
+            case TreeType::SPLIT_TREE:
+               treePairs = splitPairs_;
+               if (treePairs->empty())
+                  contourTree_->getSplitTree()->computePersistencePairs<VTK_TT>(*treePairs);
+               break;
+            case TreeType::CONTOUR_TREE:
+            default:
+               treePairs = pairs_;
+               contourTree_->computePersistencePairs<VTK_TT>(pairs_, mergePairs_, splitPairs_);
+               break;
          }
+      });
+   }
 
-         inputScalars_->resize(numberOfScalarArrays);
-         inputScalarsName_->resize(numberOfScalarArrays);
+   return tree_->writeBinary(fileName, treePairs);
+}
 
-         int k{};
-         for (int i = 0; i < numberOfArrays; ++i) {
-            vtkDataArray* inputArray = input->GetPointData()->GetArray(i);
-            if (inputArray) {
-               if (inputArray->GetNumberOfTuples() == numberOfVertices_ &&
-                   inputArray->GetNumberOfComponents() == 1) {
-                  (*inputScalars_)[k].resize(numberOfVertices_);
-                  (*inputScalarsName_)[k] = inputArray->GetName();
+void vtkContourForests::SetSortCacheDirectory(string directory)
+{
+   // the output does not depend on it: no Modified()
+   sortCacheDirectory_ = directory;
+   if (contourTree_)
+      contourTree_->setSortCacheDirectory(directory);
+}
+
+void vtkContourForests::SetMeshCacheDirectory(string directory)
+{
+   // read at the next triangulation construction, no Modified() either
+   meshCacheDirectory_ = directory;
+}
 
-                  for (unsigned int j = 0; j < numberOfVertices_; ++j) {
-                     (*inputScalars_)[k][j] = inputArray->GetTuple1(j);
-                  }
+int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
+{
+   // init
+   if (varyingMeshGeometry_ || !numberOfVertices_)
+      numberOfVertices_ = input->GetNumberOfPoints();
 
-                  ++k;
-               }
+   // scalars
+   // the arrays are referenced, not copied: only the active field is read by the build
+   inputScalars_->clear();
+   inputScalarsName_->clear();
+   if (input->GetPointData()) {
+      int numberOfArrays = input->GetPointData()->GetNumberOfArrays();
+
+      for (int i = 0; i < numberOfArrays; ++i) {
+         vtkDataArray* inputArray = input->GetPointData()->GetArray(i);
+         if (inputArray) {
+            if (inputArray->GetNumberOfTuples() == numberOfVertices_ &&
+                inputArray->GetNumberOfComponents() == 1) {
+               inputScalars_->push_back(inputArray);
+               inputScalarsName_->push_back(inputArray->GetName());
             }
          }
       }
    }
 
+#ifndef withKamikaze
+   if (inputScalars_->empty()) {
+      vtkGenericWarningMacro(<< "Input has no scalar data.");
+      return -1;
+   }
+#endif
+
+   vertexScalars_ = nullptr;
    if (scalarField_.size() == 0) {
-      vertexScalars_ = &((*inputScalars_)[FieldId]);
+      vertexScalars_ = (*inputScalars_)[FieldId];
       scalarField_ = (*inputScalarsName_)[FieldId];
 
    } else {
 
       for (unsigned int i = 0; i < inputScalarsName_->size(); ++i) {
          if ((*inputScalarsName_)[i] == scalarField_)
-            vertexScalars_ = &((*inputScalars_)[i]);
+            vertexScalars_ = (*inputScalars_)[i];
       }
    }
 
-   auto result      = std::minmax_element(vertexScalars_->begin(), vertexScalars_->end());
-   double scalarMin = *result.first;
-   double scalarMax = *result.second;
+#ifndef withKamikaze
+   if (!vertexScalars_) {
+      vtkGenericWarningMacro(<< "Scalar field " << scalarField_ << " not found.");
+      return -2;
+   }
+#endif
+
+   double scalarRange[2];
+   vertexScalars_->GetRange(scalarRange);
+   double scalarMin = scalarRange[0];
+   double scalarMax = scalarRange[1];
    deltaScalar_           = (scalarMax - scalarMin);
 
    // neighbors
@@ -498,6 +685,7 @@ int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
       //triangulation_->setDebugLevel(debugLevel_);
       triangulation_->setDebugLevel(0);
       triangulation_->setThreadNumber(threadNumber_);
+      triangulation_->setCacheDirectory(meshCacheDirectory_);
       triangulation_->setInputData(input);
       //triangulation_->initData();
       triangulation_->preprocessEdges();
@@ -505,17 +693,14 @@ int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
    }
 
    // positions
-   if (varyingMeshGeometry_ || !vertexPositions_->size()) {
-      vertexPositions_->resize(numberOfVertices_);
-
-      double point[3];
-      for (unsigned int i = 0; i < vertexPositions_->size(); ++i) {
-         (*vertexPositions_)[i].resize(3);
-         input->GetPoint(i, point);
-         for (unsigned int j = 0; j < 3; ++j)
-            (*vertexPositions_)[i][j] = point[j];
-      }
+   if (varyingMeshGeometry_) {
+      // only the point buffer (or the grid origin and spacing) may have moved
+      triangulation_->setInputData(input);
    }
+   pointInput_ = nullptr;
+   vtkPointSet* pointSet = vtkPointSet::SafeDownCast(input);
+   if (pointSet && pointSet->GetPoints() && pointSet->GetPoints()->GetDataType() != VTK_FLOAT)
+      pointInput_ = input;
 
    // offsets
    if (varyingMeshConnectivity_ || toUpdateVertexSoSoffsets_ || !vertexSoSoffsets_->size()) {
@@ -540,11 +725,14 @@ int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
       for (unsigned int i = 0; i < inputScalarsName_->size(); ++i)
          msg << "[vtkContourForests]     " << (*inputScalarsName_)[i] << endl;
       msg << "[vtkContourForests]   Active scalar name: " << scalarField_ << endl;
-      msg << "[vtkContourForests]   Number of tuples: " << vertexScalars_->size() << endl;
+      msg << "[vtkContourForests]   Active scalar type: " << vertexScalars_->GetDataTypeAsString()
+          << endl;
+      msg << "[vtkContourForests]   Number of tuples: " << vertexScalars_->GetNumberOfTuples()
+          << endl;
       msg << "[vtkContourForests]   [min max]: [" << scalarMin << " " << scalarMax << "]" << endl;
       msg << "[vtkContourForests]   Number of vertices: " << numberOfVertices_ << endl;
       msg << "[vtkContourForests]   Vertex positions: " << boolalpha
-          << (bool)vertexPositions_->size() << endl;
+          << !triangulation_->isEmpty() << endl;
       msg << "[vtkContourForests]   Vertex offsets: " << boolalpha << (bool)vertexSoSoffsets_->size()
           << endl;
       dMsg(cout, msg.str(), detailedInfoMsg);
@@ -559,7 +747,7 @@ int vtkContourForests::vtkDataSetToStdVector(vtkDataSet* input)
    return 0;
 }
 
-bool vtkContourForests::isCoincident(double p1[], double p2[])
+bool vtkContourForests::isCoincident(const double p1[], const double p2[])
 {
    double sPrev[3];
    double sNext[3];
@@ -573,256 +761,176 @@ bool vtkContourForests::isCoincident(double p1[], double p2[])
 
 void vtkContourForests::getSkeletonArcs()
 {
-   vtkSmartPointer<vtkAppendPolyData> app = vtkSmartPointer<vtkAppendPolyData>::New();
+   const int nbArcs     = tree_->getNumberOfSuperArcs();
+   const int nbFields   = inputScalars_->size();
+   const int type       = static_cast<int>(TreeComponent::ARC);
+
+   // polyline of each visible arc: its first node, its barycenters, its last node
+   vector<int>            arcRegionId(nbArcs, -1);
+   vector<vector<double>> polylines(nbArcs);
+   vector<vtkIdType>      segmentOffsets(nbArcs + 1, 0);
+   int                    currentZone{};
+   for (int i = 0; i < nbArcs; ++i) {
+      if (tree_->getSuperArc(i)->isVisible())
+         arcRegionId[i] = currentZone++;
+   }
 
-   vtkDoubleArray* scalars{};
-   vtkIntArray*    identifierScalars{};
-   vtkIntArray*    typeScalars{};
-   vtkIntArray*    sizeScalars{};
-   vtkDoubleArray* spanScalars{};
-   int type = static_cast<int>(TreeComponent::ARC);
+   // count the non degenerated segments
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      if (arcRegionId[i] == -1)
+         continue;
+
+      const SuperArc* a            = tree_->getSuperArc(i);
+      const double*   barycenters  = barycenters_->data() + 3 * (*arcSampleOffsets_)[i];
+      const int       nbBarycenter = (*arcSampleOffsets_)[i + 1] - (*arcSampleOffsets_)[i];
+      vector<double>& polyline     = polylines[i];
+      int             firstNodeId, lastNodeId;
+      if (nbBarycenter && treeType_ == TreeType::SPLIT_TREE) {
+         firstNodeId = a->getUpNodeId();
+         lastNodeId  = a->getDownNodeId();
+      } else {
+         firstNodeId = a->getDownNodeId();
+         lastNodeId  = a->getUpNodeId();
+      }
 
-   double point1[3];
-   vector<double> point2(3);
-   // get skeleton scalars
-   vector<vector<vector<double>>> skeletonScalars(inputScalars_->size());
-   for (unsigned int f = 0; f < inputScalars_->size(); ++f)
-      getSkeletonScalars((*inputScalars_)[f], skeletonScalars[f]);
-
-   double    inputScalar;
-   SuperArc* a;
-   int       regionSize;
-   double    regionSpan;
-   int       currentZone = 0;
-   int       regionId;
-
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      a = tree_->getSuperArc(i);
-
-      if (a->isVisible()) {
-         int      upNodeId   = tree_->getSuperArc(i)->getUpNodeId();
-         int      upVertex   = tree_->getNode(upNodeId)->getVertexId();
-         float    coordUp[3];
-         triangulation_->getVertexPoint(upVertex, coordUp[0], coordUp[1], coordUp[2]);
-
-         int      downNodeId   = tree_->getSuperArc(i)->getDownNodeId();
-         int      downVertex   = tree_->getNode(downNodeId)->getVertexId();
-         float    coordDown[3];
-         triangulation_->getVertexPoint(downVertex, coordDown[0], coordDown[1], coordDown[2]);
-
-         regionSize = tree_->getNumberOfVisibleRegularNode(i);
-         regionSpan = Geometry::distance(coordUp, coordDown, 3);
-         regionId       = currentZone++;
-
-         /// Line ///
-         if ((*barycenters_)[static_cast<int>(treeType_)][i].size()) {
-            // init: min
-            int downNodeVId;
-            if (treeType_ == TreeType::SPLIT_TREE)
-               downNodeVId = tree_->getNode(a->getUpNodeId())->getVertexId();
-            else
-               downNodeVId = tree_->getNode(a->getDownNodeId())->getVertexId();
-
-            for (unsigned int k = 0; k < 3; ++k) {
-               point1[k] = (*vertexPositions_)[downNodeVId][k];
-            }
-            vtkSmartPointer<vtkLineSource> line = vtkSmartPointer<vtkLineSource>::New();
-            line->SetPoint1(point1);
-
-            const auto nbBarycenter = (*barycenters_)[static_cast<int>(treeType_)][i].size();
-            for (unsigned int j = 0; j < nbBarycenter; ++j) {
-               point2 = (*barycenters_)[static_cast<int>(treeType_)][i][j];
-               line->SetPoint2(point2.data());
-
-               if (!isCoincident(point1, point2.data())) {
-                  line->Update();
-                  vtkPolyData* lineData = line->GetOutput();
-
-                  /// Point data ///
-                  for (unsigned int f = 0; f < inputScalars_->size(); ++f) {
-                     inputScalar = skeletonScalars[f][i][j];
-
-                     scalars = vtkDoubleArray::New();
-                     scalars->SetName((*inputScalarsName_)[f].data());
-                     for (unsigned int k = 0; k < 2; ++k)
-                        scalars->InsertTuple1(k, inputScalar);
-                     lineData->GetPointData()->AddArray(scalars);
-                     scalars->Delete();
-                  }
-
-                  /// Cell data ///
-                  // Identifier
-                  identifierScalars = vtkIntArray::New();
-                  identifierScalars->SetName("SegmentationId");
-                  for (unsigned int k = 0; k < 2; ++k)
-                     identifierScalars->InsertTuple1(k, regionId);
-                  lineData->GetCellData()->AddArray(identifierScalars);
-                  identifierScalars->Delete();
-                  // Type
-                  typeScalars = vtkIntArray::New();
-                  typeScalars->SetName("Type");
-                  for (unsigned int k = 0; k < 2; ++k)
-                     typeScalars->InsertTuple1(k, type);
-                  lineData->GetCellData()->AddArray(typeScalars);
-                  typeScalars->Delete();
-                  // Size
-                  sizeScalars = vtkIntArray::New();
-                  sizeScalars->SetName("RegionSize");
-                  for (unsigned int k = 0; k < 2; ++k)
-                     sizeScalars->InsertTuple1(k, regionSize);
-                  lineData->GetCellData()->AddArray(sizeScalars);
-                  sizeScalars->Delete();
-                  // Span
-                  spanScalars = vtkDoubleArray::New();
-                  spanScalars->SetName("RegionSpan");
-                  for (unsigned int k = 0; k < 2; ++k)
-                     spanScalars->InsertTuple1(k, regionSpan);
-                  lineData->GetCellData()->AddArray(spanScalars);
-                  spanScalars->Delete();
-
-                  app->AddInputData(lineData);
-               }
-
-               line = vtkSmartPointer<vtkLineSource>::New();
-               line->SetPoint1(point2.data());
-            }
+      polyline.resize(3 * (nbBarycenter + 2));
+      getVertexPosition(tree_->getNode(firstNodeId)->getVertexId(), polyline.data());
+      for (int j = 0; j < 3 * nbBarycenter; ++j)
+         polyline[3 + j] = barycenters[j];
+      getVertexPosition(tree_->getNode(lastNodeId)->getVertexId(),
+                        polyline.data() + 3 * (nbBarycenter + 1));
+
+      vtkIdType nbSegments{};
+      for (int j = 0; j <= nbBarycenter; ++j) {
+         if (!isCoincident(polyline.data() + 3 * j, polyline.data() + 3 * (j + 1)))
+            ++nbSegments;
+      }
+      segmentOffsets[i + 1] = nbSegments;
+   }
 
-            // end: max
-            int upNodeVId;
-            if (treeType_ == TreeType::SPLIT_TREE)
-               upNodeVId = tree_->getNode(a->getDownNodeId())->getVertexId();
-            else
-               upNodeVId = tree_->getNode(a->getUpNodeId())->getVertexId();
-            for (unsigned int k = 0; k < 3; ++k)
-               point2[k] = (*vertexPositions_)[upNodeVId][k];
-            line->SetPoint2(point2.data());
-
-            if (!isCoincident(point1, point2.data())) {
-               line->Update();
-               vtkPolyData* lineData = line->GetOutput();
-
-               /// Point data ///
-               for (unsigned int f = 0; f < inputScalars_->size(); ++f) {
-                  inputScalar =
-                      skeletonScalars[f][i][(*barycenters_)[static_cast<int>(treeType_)][i].size()];
-
-                  scalars = vtkDoubleArray::New();
-                  scalars->SetName((*inputScalarsName_)[f].data());
-                  for (unsigned int k = 0; k < 2; ++k)
-                     scalars->InsertTuple1(k, inputScalar);
-                  lineData->GetPointData()->AddArray(scalars);
-                  scalars->Delete();
-               }
-
-               /// Cell data ///
-               // Identifier
-               identifierScalars = vtkIntArray::New();
-               identifierScalars->SetName("SegmentationId");
-               for (unsigned int k = 0; k < 2; ++k)
-                  identifierScalars->InsertTuple1(k, regionId);
-               lineData->GetCellData()->AddArray(identifierScalars);
-               identifierScalars->Delete();
-               // Type
-               typeScalars = vtkIntArray::New();
-               typeScalars->SetName("Type");
-               for (unsigned int k = 0; k < 2; ++k)
-                  typeScalars->InsertTuple1(k, type);
-               lineData->GetCellData()->AddArray(typeScalars);
-               typeScalars->Delete();
-               // Size
-               sizeScalars = vtkIntArray::New();
-               sizeScalars->SetName("RegionSize");
-               for (unsigned int k = 0; k < 2; ++k)
-                  sizeScalars->InsertTuple1(k, regionSize);
-               lineData->GetCellData()->AddArray(sizeScalars);
-               sizeScalars->Delete();
-               // Span
-               spanScalars = vtkDoubleArray::New();
-               spanScalars->SetName("RegionSpan");
-               for (unsigned int k = 0; k < 2; ++k)
-                  spanScalars->InsertTuple1(k, regionSpan);
-               lineData->GetCellData()->AddArray(spanScalars);
-               spanScalars->Delete();
-
-               app->AddInputData(lineData);
-            }
-         } else {
-            vtkSmartPointer<vtkLineSource> line = vtkSmartPointer<vtkLineSource>::New();
+   for (int i = 0; i < nbArcs; ++i)
+      segmentOffsets[i + 1] += segmentOffsets[i];
+   const vtkIdType nbSegments = segmentOffsets[nbArcs];
 
-            int downNodeVId = tree_->getNode(a->getDownNodeId())->getVertexId();
-            for (unsigned int k = 0; k < 3; ++k)
-               point1[k] = (*vertexPositions_)[downNodeVId][k];
-            line->SetPoint1(point1);
+   // allocate: two points per segment to keep piecewise constant point data
+   vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+   points->SetNumberOfPoints(2 * nbSegments);
+   float* pointsBuffer = (float*)points->GetVoidPointer(0);
 
-            int upNodeVId = tree_->getNode(a->getUpNodeId())->getVertexId();
-            for (unsigned int k = 0; k < 3; ++k)
-               point2[k] = (*vertexPositions_)[upNodeVId][k];
-            line->SetPoint2(point2.data());
-
-            if (!isCoincident(point1, point2.data())) {
-               line->Update();
-               vtkPolyData* lineData = line->GetOutput();
-
-               /// Point data ///
-               for (unsigned int f = 0; f < inputScalars_->size(); ++f) {
-                  inputScalar = skeletonScalars[f][i][0];
-
-                  scalars = vtkDoubleArray::New();
-                  scalars->SetName((*inputScalarsName_)[f].data());
-                  for (unsigned int k = 0; k < 2; ++k)
-                     scalars->InsertTuple1(k, inputScalar);
-                  lineData->GetPointData()->AddArray(scalars);
-                  scalars->Delete();
-               }
-
-               /// Cell data ///
-               // Identifier
-               identifierScalars = vtkIntArray::New();
-               identifierScalars->SetName("SegmentationId");
-               for (int k = 0; k < 2; ++k)
-                  identifierScalars->InsertTuple1(k, regionId);
-               lineData->GetCellData()->AddArray(identifierScalars);
-               identifierScalars->Delete();
-               // Type
-               typeScalars = vtkIntArray::New();
-               typeScalars->SetName("Type");
-               for (unsigned int k = 0; k < 2; ++k)
-                  typeScalars->InsertTuple1(k, type);
-               lineData->GetCellData()->AddArray(typeScalars);
-               typeScalars->Delete();
-               // Size
-               sizeScalars = vtkIntArray::New();
-               sizeScalars->SetName("RegionSize");
-               for (unsigned int k = 0; k < 2; ++k)
-                  sizeScalars->InsertTuple1(k, regionSize);
-               lineData->GetCellData()->AddArray(sizeScalars);
-               sizeScalars->Delete();
-               // Span
-               spanScalars = vtkDoubleArray::New();
-               spanScalars->SetName("RegionSpan");
-               for (unsigned int k = 0; k < 2; ++k)
-                  spanScalars->InsertTuple1(k, regionSpan);
-               lineData->GetCellData()->AddArray(spanScalars);
-               spanScalars->Delete();
-
-               app->AddInputData(lineData);
-            }
+   vtkSmartPointer<vtkIdTypeArray> cellsIds = vtkSmartPointer<vtkIdTypeArray>::New();
+   cellsIds->SetNumberOfValues(3 * nbSegments);
+   vtkIdType* cellsBuffer = cellsIds->GetPointer(0);
+
+   vector<vtkSmartPointer<vtkDoubleArray>> scalars(nbFields);
+   vector<double*>                         scalarsBuffer(nbFields);
+   for (int f = 0; f < nbFields; ++f) {
+      scalars[f] = vtkSmartPointer<vtkDoubleArray>::New();
+      scalars[f]->SetName((*inputScalarsName_)[f].data());
+      scalars[f]->SetNumberOfTuples(2 * nbSegments);
+      scalarsBuffer[f] = scalars[f]->GetPointer(0);
+   }
+
+   vtkSmartPointer<vtkIntArray> identifierScalars = vtkSmartPointer<vtkIntArray>::New();
+   identifierScalars->SetName("SegmentationId");
+   identifierScalars->SetNumberOfTuples(nbSegments);
+   int* identifierBuffer = identifierScalars->GetPointer(0);
+
+   vtkSmartPointer<vtkIntArray> typeScalars = vtkSmartPointer<vtkIntArray>::New();
+   typeScalars->SetName("Type");
+   typeScalars->SetNumberOfTuples(nbSegments);
+   int* typeBuffer = typeScalars->GetPointer(0);
+
+   vtkSmartPointer<vtkIntArray> sizeScalars = vtkSmartPointer<vtkIntArray>::New();
+   sizeScalars->SetName("RegionSize");
+   sizeScalars->SetNumberOfTuples(nbSegments);
+   int* sizeBuffer = sizeScalars->GetPointer(0);
+
+   vtkSmartPointer<vtkDoubleArray> spanScalars = vtkSmartPointer<vtkDoubleArray>::New();
+   spanScalars->SetName("RegionSpan");
+   spanScalars->SetNumberOfTuples(nbSegments);
+   double* spanBuffer = spanScalars->GetPointer(0);
+
+   // fill
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      if (segmentOffsets[i] == segmentOffsets[i + 1])
+         continue;
+
+      const SuperArc* a = tree_->getSuperArc(i);
+      double          coordUp[3];
+      double          coordDown[3];
+      getVertexPosition(tree_->getNode(a->getUpNodeId())->getVertexId(), coordUp);
+      getVertexPosition(tree_->getNode(a->getDownNodeId())->getVertexId(), coordDown);
+      const int    regionSize = tree_->getNumberOfVisibleRegularNode(i);
+      const double regionSpan = Geometry::distance(coordUp, coordDown, 3);
+
+      // one value per segment and per field, computed once for the arc
+      vector<vector<double>> arcScalars(nbFields);
+      for (int f = 0; f < nbFields; ++f) {
+         vtkDataArray* field = (*inputScalars_)[f];
+         switch (field->GetDataType()) {
+            vtkTemplateMacro(
+                getSkeletonScalars((VTK_TT*)field->GetVoidPointer(0), i, arcScalars[f]));
          }
-      } else {
-         //cout << " pruned _ :" << tree_->getNode(a->getDownNodeId())->getVertexId() << " -  "
-              //<< tree_->getNode(a->getUpNodeId())->getVertexId() << endl;
+      }
+
+      const vector<double>& polyline = polylines[i];
+      const int             nbPoints = polyline.size() / 3;
+      vtkIdType             segment  = segmentOffsets[i];
+      for (int j = 0; j + 1 < nbPoints; ++j) {
+         const double* p1 = polyline.data() + 3 * j;
+         const double* p2 = polyline.data() + 3 * (j + 1);
+         if (isCoincident(p1, p2))
+            continue;
+
+         for (unsigned int k = 0; k < 3; ++k) {
+            pointsBuffer[6 * segment + k]     = p1[k];
+            pointsBuffer[6 * segment + 3 + k] = p2[k];
+         }
+         cellsBuffer[3 * segment]     = 2;
+         cellsBuffer[3 * segment + 1] = 2 * segment;
+         cellsBuffer[3 * segment + 2] = 2 * segment + 1;
+
+         /// Point data ///
+         for (int f = 0; f < nbFields; ++f)
+            scalarsBuffer[f][2 * segment] = scalarsBuffer[f][2 * segment + 1] = arcScalars[f][j];
+
+         /// Cell data ///
+         identifierBuffer[segment] = arcRegionId[i];
+         typeBuffer[segment]       = type;
+         sizeBuffer[segment]       = regionSize;
+         spanBuffer[segment]       = regionSpan;
+
+         ++segment;
       }
    }
 
-   app->Update();
-   skeletonArcs_->ShallowCopy(app->GetOutput());
+   vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+   cells->SetCells(nbSegments, cellsIds);
+
+   vtkSmartPointer<vtkPolyData> arcs = vtkSmartPointer<vtkPolyData>::New();
+   arcs->SetPoints(points);
+   arcs->SetLines(cells);
+   for (int f = 0; f < nbFields; ++f)
+      arcs->GetPointData()->AddArray(scalars[f]);
+   arcs->GetCellData()->AddArray(identifierScalars);
+   arcs->GetCellData()->AddArray(typeScalars);
+   arcs->GetCellData()->AddArray(sizeScalars);
+   arcs->GetCellData()->AddArray(spanScalars);
+
+   skeletonArcs_->ShallowCopy(arcs);
 }
 
-int vtkContourForests::getSkeletonScalars(const vector<double>& scalars,
-                                         vector<vector<double>>& skeletonScalars) const
+template <typename scalarType>
+int vtkContourForests::getSkeletonScalars(const scalarType* scalars, const int arcId,
+                                         vector<double>& arcScalars) const
 {
-   skeletonScalars.clear();
-   skeletonScalars.resize(tree_->getNumberOfSuperArcs());
+   arcScalars.clear();
 
    int nodeId;
    int vertexId;
@@ -836,54 +944,50 @@ int vtkContourForests::getSkeletonScalars(const vector<double>& scalars,
    int nodeMaxId;
    int nodeMinVId;
    int nodeMaxVId;
-   const SuperArc* a;
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      a = tree_->getSuperArc(i);
-
-      if (!a->isPruned()) {
-         if (treeType_ == TreeType::SPLIT_TREE) {
-            nodeMinId = a->getUpNodeId();
-            nodeMaxId = a->getDownNodeId();
-         } else {
-            nodeMaxId = a->getUpNodeId();
-            nodeMinId = a->getDownNodeId();
-         }
+   const SuperArc* a = tree_->getSuperArc(arcId);
 
-         nodeMaxVId = tree_->getNode(nodeMaxId)->getVertexId();
-         nodeMinVId = tree_->getNode(nodeMinId)->getVertexId();
+   if (!a->isPruned()) {
+      if (treeType_ == TreeType::SPLIT_TREE) {
+         nodeMinId = a->getUpNodeId();
+         nodeMaxId = a->getDownNodeId();
+      } else {
+         nodeMaxId = a->getUpNodeId();
+         nodeMinId = a->getDownNodeId();
+      }
 
-         fmax = scalars[nodeMaxVId];
-         fmin = scalars[nodeMinVId];
+      nodeMaxVId = tree_->getNode(nodeMaxId)->getVertexId();
+      nodeMinVId = tree_->getNode(nodeMinId)->getVertexId();
 
-         // init: min
-         f0 = fmin;
+      fmax = scalars[nodeMaxVId];
+      fmin = scalars[nodeMinVId];
 
-         // iteration
-         for (unsigned int j = 0; j < (*samples_)[static_cast<int>(treeType_)][i].size(); ++j) {
-            const vector<int>& sample = (*samples_)[static_cast<int>(treeType_)][i][j];
+      // init: min
+      f0 = fmin;
 
-            f = 0;
-            for (unsigned int k = 0; k < sample.size(); ++k) {
-               nodeId   = sample[k];
-               vertexId = nodeId;
-               f += scalars[vertexId];
-            }
-            if (sample.size()) {
-               f /= sample.size();
+      // iteration: samples are never empty
+      for (int j = (*arcSampleOffsets_)[arcId]; j < (*arcSampleOffsets_)[arcId + 1]; ++j) {
+         const int sampleBegin = (*sampleOffsets_)[j];
+         const int sampleEnd   = (*sampleOffsets_)[j + 1];
 
-               f1 = f;
-               // update the arc
-               skeletonScalars[i].push_back((f0 + f1) / 2);
-               f0 = f1;
-            }
+         f = 0;
+         for (int k = sampleBegin; k < sampleEnd; ++k) {
+            nodeId   = (*sampleVertices_)[k];
+            vertexId = nodeId;
+            f += scalars[vertexId];
          }
+         f /= (sampleEnd - sampleBegin);
 
-         // end: max
-         f1 = fmax;
-
+         f1 = f;
          // update the arc
-         skeletonScalars[i].push_back((f0 + f1) / 2);
+         arcScalars.push_back((f0 + f1) / 2);
+         f0 = f1;
       }
+
+      // end: max
+      f1 = fmax;
+
+      // update the arc
+      arcScalars.push_back((f0 + f1) / 2);
    }
 
    return 0;
@@ -911,27 +1015,22 @@ void vtkContourForests::getSkeletonNodes()
    vtkIntArray* nodeTypeScalars = vtkIntArray::New();
    nodeTypeScalars->SetName("NodeType");
 
-   vector<double> persistence(numberOfVertices_, -1);
-   if (treeType_ == TreeType::MERGE_TREE) {
-      for (unsigned int i = 0; i < mergePairs_->size(); ++i) {
-         persistence[(*mergePairs_)[i].first.first] =
-             std::max(persistence[(*mergePairs_)[i].first.first], (*mergePairs_)[i].second);
-         persistence[(*mergePairs_)[i].first.second] =
-             std::max(persistence[(*mergePairs_)[i].first.second], (*mergePairs_)[i].second);
-      }
-   } else if (treeType_ == TreeType::SPLIT_TREE) {
-      for (unsigned int i = 0; i < splitPairs_->size(); ++i) {
-         persistence[(*splitPairs_)[i].first.first] =
-             std::max(persistence[(*splitPairs_)[i].first.first], (*splitPairs_)[i].second);
-         persistence[(*splitPairs_)[i].first.second] =
-             std::max(persistence[(*splitPairs_)[i].first.second], (*splitPairs_)[i].second);
-      }
-   } else {
-      for (unsigned int i = 0; i < pairs_->size(); ++i) {
-         persistence[(*pairs_)[i].first.first] =
-             std::max(persistence[(*pairs_)[i].first.first], (*pairs_)[i].second);
-         persistence[(*pairs_)[i].first.second] =
-             std::max(persistence[(*pairs_)[i].first.second], (*pairs_)[i].second);
+   // persistence of each node of the tree
+   const vector<pair<pair<int, int>, double>>* treePairs;
+   if (treeType_ == TreeType::MERGE_TREE)
+      treePairs = mergePairs_;
+   else if (treeType_ == TreeType::SPLIT_TREE)
+      treePairs = splitPairs_;
+   else
+      treePairs = pairs_;
+
+   vector<double> persistence(tree_->getNumberOfNodes(), -1);
+   for (unsigned int i = 0; i < treePairs->size(); ++i) {
+      for (const int vertexId : {(*treePairs)[i].first.first, (*treePairs)[i].first.second}) {
+         if (!tree_->isCorrespondingNode(vertexId))
+            continue;
+         double& nodePersistence = persistence[tree_->getCorrespondingNode(vertexId)];
+         nodePersistence         = std::max(nodePersistence, (*treePairs)[i].second);
       }
    }
    vtkDoubleArray* nodePersistenceScalars = vtkDoubleArray::New();
@@ -942,20 +1041,19 @@ void vtkContourForests::getSkeletonNodes()
       int nodeId        = (*criticalPoints_)[i];
       if(tree_->getNode(nodeId)->isHidden()) continue;
       int vertexId      = tree_->getNode(nodeId)->getVertexId();
-      NodeType nodeType = getNodeType(nodeId);
+      NodeType nodeType = (*nodeTypes_)[nodeId];
 
       if ((nodeType == NodeType::LOCAL_MINIMUM and showMin_) or
           (nodeType == NodeType::LOCAL_MAXIMUM and showMax_) or
           (nodeType == NodeType::SADDLE1 and showSaddle1_) or
           (nodeType == NodeType::SADDLE2 and showSaddle2_)) {
          // Positions
-         for (unsigned k = 0; k < 3; ++k)
-            point[k] = (*vertexPositions_)[vertexId][k];
+         getVertexPosition(vertexId, point);
          points->InsertPoint(identifier, point);
 
          // Scalars
          for (unsigned int f = 0; f < inputScalars_->size(); ++f) {
-            scalar = (*inputScalars_)[f][vertexId];
+            scalar = (*inputScalars_)[f]->GetTuple1(vertexId);
             scalars[f]->InsertTuple1(identifier, scalar);
          }
 
@@ -970,7 +1068,7 @@ void vtkContourForests::getSkeletonNodes()
          nodeTypeScalars->InsertTuple1(identifier, type);
 
          // Persistence
-         nodePersistenceScalars->InsertTuple1(identifier, persistence[vertexId]);
+         nodePersistenceScalars->InsertTuple1(identifier, persistence[nodeId]);
 
          ++identifier;
       }
@@ -1029,34 +1127,43 @@ NodeType vtkContourForests::getNodeType(int id, TreeType type, MergeTree* tree)
 
 void vtkContourForests::getCriticalPoints()
 {
-   vector<bool> isCriticalPoint(numberOfVertices_);
-
-   criticalPoints_->clear();
-   for (unsigned int i = 0; i < numberOfVertices_; ++i)
-      isCriticalPoint[i] = false;
-
-   //const int nbVert = triangulation_->getNumberOfOriginalVertices();
+   const int nbNodes = tree_->getNumberOfNodes();
+   const int nbArcs  = tree_->getNumberOfSuperArcs();
 
-   // looking for critical points
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      auto a = tree_->getSuperArc(i);
+   // a node is critical if it ends a remaining arc (one node per vertex in a tree)
+   vector<char> isCriticalPoint(nbNodes, 0);
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      const SuperArc* a = tree_->getSuperArc(i);
 
       if (!a->isPruned()) {
-         int upId   = a->getUpNodeId();
-         int up_vId = tree_->getNode(upId)->getVertexId();
-         if (!isCriticalPoint[up_vId]) {
-            isCriticalPoint[up_vId] = true;
-            criticalPoints_->push_back(upId);
-         }
-
-         int downId   = a->getDownNodeId();
-         int down_vId = tree_->getNode(downId)->getVertexId();
-         if (!isCriticalPoint[down_vId]) {
-            isCriticalPoint[down_vId] = true;
-            criticalPoints_->push_back(downId);
-         }
+#ifdef withOpenMP
+#pragma omp atomic write
+#endif
+         isCriticalPoint[a->getUpNodeId()] = 1;
+#ifdef withOpenMP
+#pragma omp atomic write
+#endif
+         isCriticalPoint[a->getDownNodeId()] = 1;
       }
    }
+
+   // classification, computed once per tree
+   nodeTypes_->resize(nbNodes);
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_)
+#endif
+   for (int i = 0; i < nbNodes; ++i) {
+      (*nodeTypes_)[i] = (isCriticalPoint[i]) ? getNodeType(i) : NodeType::REGULAR;
+   }
+
+   criticalPoints_->clear();
+   for (int i = 0; i < nbNodes; ++i) {
+      if (isCriticalPoint[i])
+         criticalPoints_->push_back(i);
+   }
    //{
       //stringstream msg;
       //msg << "[vtkContourForests] List of critical points :" << endl;
@@ -1104,18 +1211,24 @@ void vtkContourForests::getPersistenceCurve(TreeType type)
 
    vtkSmartPointer<vtkTable> persistenceCurve = vtkSmartPointer<vtkTable>::New();
 
+   // the scalars of the trees are the native buffer of the field
    vector<pair<double, int>> plot;
-   switch (type) {
-      case TreeType::MERGE_TREE:
-         contourTree_->getJoinTree()->computePersistencePlot<double>(plot, mergePairs_);
-         break;
-      case TreeType::SPLIT_TREE:
-         contourTree_->getSplitTree()->computePersistencePlot<double>(plot, splitPairs_);
-         break;
-      case TreeType::CONTOUR_TREE:
-      default:
-         contourTree_->computePersistencePlot<double>(plot, mergePairs_, splitPairs_, pairs_);
-         break;
+   switch (vertexScalars_->GetDataType()) {
+      vtkTemplateMacro({
+         switch (type) {
+            case TreeType::MERGE_TREE:
+               contourTree_->getJoinTree()->computePersistencePlot<VTK_TT>(plot, mergePairs_);
+               break;
+            case TreeType::SPLIT_TREE:
+               contourTree_->getSplitTree()->computePersistencePlot<VTK_TT>(plot, splitPairs_);
+               break;
+            case TreeType::CONTOUR_TREE:
+            default:
+               contourTree_->computePersistencePlot<VTK_TT>(plot, mergePairs_, splitPairs_,
+                                                            pairs_);
+               break;
+         }
+      });
    }
 
    unsigned int N = plot.size();
@@ -1149,12 +1262,8 @@ void vtkContourForests::getPersistenceCurve(TreeType type)
 
 void vtkContourForests::getCurves()
 {
-   if (treeType_ == TreeType::CONTOUR_TREE) {
-      getPersistenceCurve(TreeType::CONTOUR_TREE);
-   } else {
-      getPersistenceCurve(TreeType::MERGE_TREE);
-      getPersistenceCurve(TreeType::SPLIT_TREE);
-   }
+   // only the selected tree is shown, and only its pairs are computed
+   getPersistenceCurve(treeType_);
 
    {
       stringstream msg;
@@ -1246,17 +1355,24 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
    scalars->SetName(scalarField_.data());
 
    vector<pair<double, double>> diagram;
-   switch (type) {
-      case TreeType::MERGE_TREE:
-         contourTree_->getJoinTree()->computePersistenceDiagram<double>(diagram, mergePairs_);
-         break;
-      case TreeType::SPLIT_TREE:
-         contourTree_->getSplitTree()->computePersistenceDiagram<double>(diagram, splitPairs_);
-         break;
-      case TreeType::CONTOUR_TREE:
-      default:
-         contourTree_->computePersistenceDiagram<double>(diagram, mergePairs_, splitPairs_, pairs_);
-         break;
+   switch (vertexScalars_->GetDataType()) {
+      vtkTemplateMacro({
+         switch (type) {
+            case TreeType::MERGE_TREE:
+               contourTree_->getJoinTree()->computePersistenceDiagram<VTK_TT>(diagram,
+                                                                               mergePairs_);
+               break;
+            case TreeType::SPLIT_TREE:
+               contourTree_->getSplitTree()->computePersistenceDiagram<VTK_TT>(diagram,
+                                                                                splitPairs_);
+               break;
+            case TreeType::CONTOUR_TREE:
+            default:
+               contourTree_->computePersistenceDiagram<VTK_TT>(diagram, mergePairs_,
+                                                               splitPairs_, pairs_);
+               break;
+         }
+      });
    }
 
    unsigned int N = diagram.size();
@@ -1279,7 +1395,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
       vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
       nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
       nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-      scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+      scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
       p[0]   = diagram[0].first;
       p[1]   = diagram[0].first;
       ids[0] = points->InsertNextPoint(p);
@@ -1291,7 +1407,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
       vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
       nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
       nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-      scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+      scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
 
       p[0]   = diagram[0].first;
       p[1]   = diagram[0].second;
@@ -1304,7 +1420,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
       vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
       nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
       nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-      scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+      scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
 
       p[0]   = diagram[0].first;
       p[1]   = diagram[0].first;
@@ -1330,7 +1446,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
             vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
             nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
             nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-            scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+            scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
 
             p[0]   = diagram[i].first;
             p[1]   = diagram[i].first;
@@ -1349,7 +1465,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
             vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
             nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
             nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-            scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+            scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
 
             p[0]   = diagram[i].first;
             p[1]   = diagram[i].second;
@@ -1366,7 +1482,7 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
             vertexIdentifierScalars->InsertTuple1(point_cpt, vertexId);
             nodeIdentifierScalars->InsertTuple1(point_cpt, nodeId);
             nodeTypeScalars->InsertTuple1(point_cpt, nodeType);
-            scalars->InsertTuple1(point_cpt, (*vertexScalars_)[vertexId]);
+            scalars->InsertTuple1(point_cpt, vertexScalars_->GetTuple1(vertexId));
 
             p[0]   = diagram[i].first;
             p[1]   = diagram[i].first;
@@ -1404,12 +1520,8 @@ void vtkContourForests::getPersistenceDiagram(TreeType type)
 
 void vtkContourForests::getDiagrams()
 {
-   if (treeType_ == TreeType::CONTOUR_TREE) {
-      getPersistenceDiagram(TreeType::CONTOUR_TREE);
-   } else {
-      getPersistenceDiagram(TreeType::MERGE_TREE);
-      getPersistenceDiagram(TreeType::SPLIT_TREE);
-   }
+   // only the selected tree is shown, and only its pairs are computed
+   getPersistenceDiagram(treeType_);
 
    {
       stringstream msg;
@@ -1418,63 +1530,125 @@ void vtkContourForests::getDiagrams()
    }
 }
 
+int vtkContourForests::getSampleId(const double f, const double fmin, const double delta,
+                                   const int samplingLevel) const
+{
+   // first sample k such that f <= (k + 1) * delta + fmin
+   int k = (delta > 0) ? static_cast<int>(std::ceil((f - fmin) / delta)) - 1 : 0;
+   if (k < 0)
+      k = 0;
+   else if (k >= samplingLevel)
+      k = samplingLevel - 1;
+   return k;
+}
+
 int vtkContourForests::sample(unsigned int samplingLevel)
 {
-   samples_->resize(3);
-   (*samples_)[static_cast<int>(treeType_)].resize(tree_->getNumberOfSuperArcs());
-   vector<vector<int>> sampleList(samplingLevel);
+   // typed buffer of the field: GetTuple1() is not thread safe
+   switch (vertexScalars_->GetDataType()) {
+      vtkTemplateMacro(
+          return sample((VTK_TT*)vertexScalars_->GetVoidPointer(0), samplingLevel));
+   }
+   return -1;
+}
 
-   SuperArc* a;
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      a = tree_->getSuperArc(i);
+template <typename scalarType>
+int vtkContourForests::sample(const scalarType* scalars, unsigned int samplingLevel)
+{
+   const int nbArcs  = tree_->getNumberOfSuperArcs();
+   const int nbLevel = samplingLevel;
+
+   // value range of each arc
+   vector<double> arcMin(nbArcs), arcDelta(nbArcs);
+   // number of non empty samples and of sampled vertices of each arc
+   vector<int> nbArcSamples(nbArcs + 1, 0), nbArcVertices(nbArcs + 1, 0);
+
+   // count
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      SuperArc* a = tree_->getSuperArc(i);
+
+      if (a->isPruned() || !a->getNumberOfRegularNodes() || !nbLevel)
+         continue;
+
+      int nodeMaxId, nodeMinId;
+      if (treeType_ == TreeType::SPLIT_TREE) {
+         nodeMaxId = a->getDownNodeId();
+         nodeMinId = a->getUpNodeId();
+      } else {
+         nodeMaxId = a->getUpNodeId();
+         nodeMinId = a->getDownNodeId();
+      }
 
-      if (!a->isPruned()) {
-         for (unsigned int j = 0; j < samplingLevel; ++j) {
-            sampleList[j].clear();
-         }
+      const double fmax = scalars[tree_->getNode(nodeMaxId)->getVertexId()];
+      const double fmin = scalars[tree_->getNode(nodeMinId)->getVertexId()];
+      arcMin[i]         = fmin;
+      arcDelta[i]       = (fmax - fmin) / nbLevel;
+
+      vector<int> sampleSize(nbLevel, 0);
+      const int   nbRegular = a->getNumberOfRegularNodes();
+      for (int j = 0; j < nbRegular; ++j) {
+         if (a->isMasqued(j))
+            continue;
+         const double f = scalars[a->getRegularNodeId(j)];
+         ++sampleSize[getSampleId(f, fmin, arcDelta[i], nbLevel)];
+         ++nbArcVertices[i + 1];
+      }
+      for (int k = 0; k < nbLevel; ++k) {
+         if (sampleSize[k])
+            ++nbArcSamples[i + 1];
+      }
+   }
 
-         double fmax, fmin;
-         int nodeMaxId, nodeMinId;
-         int nodeMaxVId, nodeMinVId;
-         double delta;
-         if (a->getNumberOfRegularNodes()) {
-            if (treeType_ == TreeType::SPLIT_TREE) {
-               nodeMaxId = a->getDownNodeId();
-               nodeMinId = a->getUpNodeId();
-            } else {
-               nodeMaxId = a->getUpNodeId();
-               nodeMinId = a->getDownNodeId();
-            }
+   for (int i = 0; i < nbArcs; ++i) {
+      nbArcSamples[i + 1] += nbArcSamples[i];
+      nbArcVertices[i + 1] += nbArcVertices[i];
+   }
 
-            nodeMaxVId = tree_->getNode(nodeMaxId)->getVertexId();
-            nodeMinVId = tree_->getNode(nodeMinId)->getVertexId();
-
-            fmax = (*vertexScalars_)[nodeMaxVId];
-            fmin = (*vertexScalars_)[nodeMinVId];
-
-            delta = (fmax - fmin) / samplingLevel;
-
-            double f;
-            int nodeId;
-            int vertexId;
-            for (int j = 0; j < a->getNumberOfRegularNodes(); ++j) {
-               nodeId   = a->getRegularNodeId(j);
-               if(a->isMasqued(j)) continue;
-               vertexId = nodeId;
-               f        = (*vertexScalars_)[vertexId];
-
-               for (unsigned int k = 0; k < samplingLevel; ++k) {
-                  if (f <= (k + 1) * delta + fmin) {
-                     sampleList[k].push_back(nodeId);
-                     break;
-                  }
-               }
-            }
+   arcSampleOffsets_->swap(nbArcSamples);
+   sampleOffsets_->resize(arcSampleOffsets_->back() + 1);
+   sampleVertices_->resize(nbArcVertices.back());
+   (*sampleOffsets_)[arcSampleOffsets_->back()] = nbArcVertices.back();
+
+   // fill: bucket the vertices of each arc by value
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      if (nbArcVertices[i] == nbArcVertices[i + 1])
+         continue;
+
+      SuperArc* a = tree_->getSuperArc(i);
+
+      vector<int> sampleSize(nbLevel, 0);
+      const int   nbRegular = a->getNumberOfRegularNodes();
+      for (int j = 0; j < nbRegular; ++j) {
+         if (a->isMasqued(j))
+            continue;
+         const double f = scalars[a->getRegularNodeId(j)];
+         ++sampleSize[getSampleId(f, arcMin[i], arcDelta[i], nbLevel)];
+      }
 
-            // update the arc
-            for (unsigned int j = 0; j < sampleList.size(); ++j)
-               (*samples_)[static_cast<int>(treeType_)][i].push_back(sampleList[j]);
-         }
+      // sizes to positions, and non empty samples offsets
+      vector<int> samplePos(nbLevel);
+      int         pos      = nbArcVertices[i];
+      int         sampleId = (*arcSampleOffsets_)[i];
+      for (int k = 0; k < nbLevel; ++k) {
+         samplePos[k] = pos;
+         if (sampleSize[k])
+            (*sampleOffsets_)[sampleId++] = pos;
+         pos += sampleSize[k];
+      }
+
+      for (int j = 0; j < nbRegular; ++j) {
+         if (a->isMasqued(j))
+            continue;
+         const int    vertexId = a->getRegularNodeId(j);
+         const double f        = scalars[vertexId];
+         (*sampleVertices_)[samplePos[getSampleId(f, arcMin[i], arcDelta[i], nbLevel)]++] =
+             vertexId;
       }
    }
 
@@ -1483,42 +1657,26 @@ int vtkContourForests::sample(unsigned int samplingLevel)
 
 int vtkContourForests::computeBarycenters()
 {
-   barycenters_->resize(3);
-   (*barycenters_)[static_cast<int>(treeType_)].resize(tree_->getNumberOfSuperArcs());
-   vector<double> barycenter(3);
-   int vertexId;
-
-   const SuperArc* a;
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      a = tree_->getSuperArc(i);
-      if (!a->isPruned()) {
-         for (unsigned int j = 0; j < (*samples_)[static_cast<int>(treeType_)][i].size(); ++j) {
-            vector<int>& sample = (*samples_)[static_cast<int>(treeType_)][i][j];
-
-            for (unsigned int k = 0; k < 3; ++k)
-               barycenter[k] = 0;
-
-            for (unsigned int k = 0; k < sample.size(); ++k) {
-               vertexId = sample[k];
-
-
-               for (unsigned int l = 0; l < 3; ++l)
-                  barycenter[l] += (*vertexPositions_)[vertexId][l];
-            }
-            if (sample.size()) {
-               for (unsigned int k = 0; k < 3; ++k)
-                  barycenter[k] /= sample.size();
+   const int nbSamples = sampleOffsets_->size() - 1;
+   barycenters_->resize(3 * nbSamples);
 
-               // update the arc
-               unsigned int nbBar = (*barycenters_)[static_cast<int>(treeType_)][i].size();
-               (*barycenters_)[static_cast<int>(treeType_)][i].resize(nbBar + 1);
-               (*barycenters_)[static_cast<int>(treeType_)][i][nbBar].resize(3);
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_)
+#endif
+   for (int s = 0; s < nbSamples; ++s) {
+      const int sampleBegin = (*sampleOffsets_)[s];
+      const int sampleEnd   = (*sampleOffsets_)[s + 1];
 
-               for (unsigned int k = 0; k < 3; ++k)
-                  (*barycenters_)[static_cast<int>(treeType_)][i][nbBar][k] = barycenter[k];
-            }
-         }
+      double barycenter[3] = {0, 0, 0};
+      double point[3];
+      for (int k = sampleBegin; k < sampleEnd; ++k) {
+         getVertexPosition((*sampleVertices_)[k], point);
+         for (unsigned int l = 0; l < 3; ++l)
+            barycenter[l] += point[l];
       }
+
+      for (unsigned int k = 0; k < 3; ++k)
+         (*barycenters_)[3 * s + k] = barycenter[k] / (sampleEnd - sampleBegin);
    }
 
    return 0;
@@ -1532,23 +1690,30 @@ void vtkContourForests::computeSkeleton(unsigned int arcRes)
 
 void vtkContourForests::smoothSkeleton(unsigned int skeletonSmoothing)
 {
+   const int      nbArcs = tree_->getNumberOfSuperArcs();
+   vector<double> smoothed(barycenters_->size());
+
    for (unsigned int i = 0; i < skeletonSmoothing; i++) {
-      for (unsigned int j = 0; j < tree_->getNumberOfSuperArcs(); j++) {
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+      for (int j = 0; j < nbArcs; j++) {
          if (!tree_->getSuperArc(j)->isPruned()) {
-            smooth(j, !(treeType_ == TreeType::SPLIT_TREE));
+            smooth(j, !(treeType_ == TreeType::SPLIT_TREE), smoothed.data());
          }
       }
+      barycenters_->swap(smoothed);
    }
 }
 
-void vtkContourForests::smooth(const int idArc, bool order)
+void vtkContourForests::smooth(const int idArc, bool order, double* smoothed)
 {
-   int N = (*barycenters_)[static_cast<int>(treeType_)][idArc].size();
+   const int offset = 3 * (*arcSampleOffsets_)[idArc];
+   const int N      = (*arcSampleOffsets_)[idArc + 1] - (*arcSampleOffsets_)[idArc];
    if (N) {
       /// init ///
-      vector<vector<double>> barycenterList(N);
-      for (unsigned int i = 0; i < barycenterList.size(); ++i)
-         barycenterList[i].resize(3);
+      const double* barycenterList = barycenters_->data() + offset;
+      double*       smoothedList   = smoothed + offset;
 
       int up_vId;
       int down_vId;
@@ -1562,39 +1727,27 @@ void vtkContourForests::smooth(const int idArc, bool order)
 
       double p0[3];
       double p1[3];
-      for (unsigned int k = 0; k < 3; ++k) {
-         p0[k] = (*vertexPositions_)[down_vId][k];
-         p1[k] = (*vertexPositions_)[up_vId][k];
-      }
+      getVertexPosition(down_vId, p0);
+      getVertexPosition(up_vId, p1);
 
       /// filtering ///
       if (N > 1) {
          // first
          for (unsigned int k = 0; k < 3; ++k)
-            barycenterList[0][k] =
-                (p0[k] + (*barycenters_)[static_cast<int>(treeType_)][idArc][1][k]) * 0.5;
+            smoothedList[k] = (p0[k] + barycenterList[3 + k]) * 0.5;
 
          // main
          for (int i = 1; i < N - 1; ++i) {
             for (unsigned int k = 0; k < 3; ++k)
-               barycenterList[i][k] =
-                   ((*barycenters_)[static_cast<int>(treeType_)][idArc][i - 1][k] +
-                    (*barycenters_)[static_cast<int>(treeType_)][idArc][i + 1][k]) *
-                   0.5;
+               smoothedList[3 * i + k] =
+                   (barycenterList[3 * (i - 1) + k] + barycenterList[3 * (i + 1) + k]) * 0.5;
          }
          // last
          for (unsigned int k = 0; k < 3; ++k)
-            barycenterList[N - 1][k] =
-                (p1[k] + (*barycenters_)[static_cast<int>(treeType_)][idArc][N - 1][k]) * 0.5;
+            smoothedList[3 * (N - 1) + k] = (p1[k] + barycenterList[3 * (N - 1) + k]) * 0.5;
       } else {
          for (unsigned int k = 0; k < 3; ++k)
-            barycenterList[0][k] = (p0[k] + p1[k]) * 0.5;
-      }
-
-      /// copy ///
-      for (int i = 0; i < N; ++i) {
-         for (unsigned int k = 0; k < 3; ++k)
-            (*barycenters_)[static_cast<int>(treeType_)][idArc][i][k] = barycenterList[i][k];
+            smoothedList[k] = (p0[k] + p1[k]) * 0.5;
       }
    }
 }
@@ -1634,105 +1787,93 @@ void vtkContourForests::getSegmentation(vtkDataSet* input)
 {
    Timer t;
 
+   if (!segmentation_) {
+      segmentation_ = input->NewInstance();
+      segmentation_->ShallowCopy(input);
+   }
+
    // field
-   int regionId{};
    vtkSmartPointer<vtkIntArray> scalarsRegionId = vtkSmartPointer<vtkIntArray>::New();
    scalarsRegionId->SetName("SegmentationId");
-   scalarsRegionId->SetNumberOfTuples(vertexScalars_->size());
-
-   int regionType{};
-   vtkSmartPointer<vtkIntArray> scalarsRegionType = vtkSmartPointer<vtkIntArray>::New();
-   scalarsRegionType->SetName("RegionType");
-   scalarsRegionType->SetNumberOfTuples(vertexScalars_->size());
-
-   int regionSize{};
-   vtkSmartPointer<vtkIntArray> scalarsRegionSize = vtkSmartPointer<vtkIntArray>::New();
-   scalarsRegionSize->SetName("RegionSize");
-   scalarsRegionSize->SetNumberOfTuples(vertexScalars_->size());
-
-   double regionSpan{};
-   vtkSmartPointer<vtkDoubleArray> scalarsRegionSpan = vtkSmartPointer<vtkDoubleArray>::New();
-   scalarsRegionSpan->SetName("RegionSpan");
-   scalarsRegionSpan->SetNumberOfTuples(vertexScalars_->size());
-
-   int currentZone{};
+   scalarsRegionId->SetNumberOfTuples(numberOfVertices_);
+   int* regionIds = scalarsRegionId->GetPointer(0);
+
+   vtkSmartPointer<vtkIntArray> scalarsRegionType;
+   int* regionTypes{};
+   if (showRegionType_) {
+      scalarsRegionType = vtkSmartPointer<vtkIntArray>::New();
+      scalarsRegionType->SetName("RegionType");
+      scalarsRegionType->SetNumberOfTuples(numberOfVertices_);
+      regionTypes = scalarsRegionType->GetPointer(0);
+   }
 
-   if (!segmentation_) {
-      segmentation_ = input->NewInstance();
-      segmentation_->ShallowCopy(input);
+   vtkSmartPointer<vtkIntArray> scalarsRegionSize;
+   int* regionSizes{};
+   if (showRegionSize_) {
+      scalarsRegionSize = vtkSmartPointer<vtkIntArray>::New();
+      scalarsRegionSize->SetName("RegionSize");
+      scalarsRegionSize->SetNumberOfTuples(numberOfVertices_);
+      regionSizes = scalarsRegionSize->GetPointer(0);
    }
 
-   for (unsigned int i = 0; i < numberOfVertices_; i++) {
-      scalarsRegionId->SetTuple1(i, -1);
+   vtkSmartPointer<vtkDoubleArray> scalarsRegionSpan;
+   double* regionSpans{};
+   if (showRegionSpan_) {
+      scalarsRegionSpan = vtkSmartPointer<vtkDoubleArray>::New();
+      scalarsRegionSpan->SetName("RegionSpan");
+      scalarsRegionSpan->SetNumberOfTuples(numberOfVertices_);
+      regionSpans = scalarsRegionSpan->GetPointer(0);
    }
 
-   // nodes
-   for (unsigned int it = 0; it < criticalPoints_->size(); ++it) {
-      int nodeId   = (*criticalPoints_)[it];
-      int vertexId = tree_->getNode(nodeId)->getVertexId();
+   const int nbVertices = numberOfVertices_;
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_)
+#endif
+   for (int i = 0; i < nbVertices; i++) {
+      regionIds[i] = -1;
+      if (regionTypes)
+         regionTypes[i] = -1;
+      if (regionSizes)
+         regionSizes[i] = -1;
+      if (regionSpans)
+         regionSpans[i] = -1;
+   }
 
-      // RegionType
-      regionType = -1;
-      scalarsRegionType->SetTuple1(vertexId, regionType);
+   // region identifiers follow the order of the visible arcs
+   const int nbArcs = tree_->getNumberOfSuperArcs();
+   vector<int> arcRegionId(nbArcs, -1);
+   int currentZone{};
+   for (int i = 0; i < nbArcs; ++i) {
+      if (tree_->getSuperArc(i)->isVisible())
+         arcRegionId[i] = currentZone++;
    }
 
-   // arcs
-   for (unsigned int i = 0; i < tree_->getNumberOfSuperArcs(); ++i) {
-      auto a = tree_->getSuperArc(i);
-      if (a->isVisible()) {
-         int      upNodeId   = tree_->getSuperArc(i)->getUpNodeId();
-         NodeType upNodeType = getNodeType(upNodeId);
-         int      upVertex   = tree_->getNode(upNodeId)->getVertexId();
-         float    coordUp[3];
-         triangulation_->getVertexPoint(upVertex, coordUp[0], coordUp[1], coordUp[2]);
-
-         int      downNodeId   = tree_->getSuperArc(i)->getDownNodeId();
-         NodeType downNodeType = getNodeType(downNodeId);
-         int      downVertex   = tree_->getNode(downNodeId)->getVertexId();
-         float    coordDown[3];
-         triangulation_->getVertexPoint(downVertex, coordDown[0], coordDown[1], coordDown[2]);
-
-         regionSize = tree_->getNumberOfVisibleRegularNode(i);
+   // arcs: each regular vertex belongs to a single arc
+#ifdef withOpenMP
+#pragma omp parallel for num_threads(threadNumber_) schedule(dynamic)
+#endif
+   for (int i = 0; i < nbArcs; ++i) {
+      if (arcRegionId[i] == -1)
+         continue;
+
+      SuperArc* a = tree_->getSuperArc(i);
+
+      const int regionId   = arcRegionId[i];
+      const int regionSize = (regionSizes) ? tree_->getNumberOfVisibleRegularNode(i) : 0;
+      double    regionSpan{};
+      if (regionSpans) {
+         double coordUp[3];
+         double coordDown[3];
+         getVertexPosition(tree_->getNode(a->getUpNodeId())->getVertexId(), coordUp);
+         getVertexPosition(tree_->getNode(a->getDownNodeId())->getVertexId(), coordDown);
          regionSpan = Geometry::distance(coordUp, coordDown);
-         regionId   = currentZone++;
-         //regionId = i;
-
-         //cout << "arc : " << tree_->printArc(i);
-         //cout << " span : " << regionSpan;
-         //cout << " coords : ";
-         //cout << coordDown[0] << ",";
-         //cout << coordDown[1] << ",";
-         //cout << coordDown[2] << " || ";
-         //cout << coordUp[0] << ",";
-         //cout << coordUp[1] << ",";
-         //cout << coordUp[2] << endl;
-
-         scalarsRegionId->SetTuple1(tree_->getNode(downNodeId)->getVertexId(), regionId);
-         scalarsRegionId->SetTuple1(tree_->getNode(upNodeId)->getVertexId(), regionId);
-
-         scalarsRegionSize->SetTuple1(tree_->getNode(downNodeId)->getVertexId(), regionSize);
-         scalarsRegionSize->SetTuple1(tree_->getNode(upNodeId)->getVertexId(), regionSize);
-
-         scalarsRegionSpan->SetTuple1(tree_->getNode(downNodeId)->getVertexId(), regionSpan);
-         scalarsRegionSpan->SetTuple1(tree_->getNode(upNodeId)->getVertexId(), regionSpan);
-
-         for (int j = 0; j < tree_->getSuperArc(i)->getNumberOfRegularNodes(); ++j) {
-            int nodeId   = tree_->getSuperArc(i)->getRegularNodeId(j);
-            int vertexId = nodeId;
-            // cout << vertexId << ", ";
-            if(tree_->getSuperArc(i)->isMasqued(j)) {
-               // cout << vertexId << ", ";
-               continue;
-            }
-
-            //cout << vertexId << ", ";
-            scalarsRegionId->SetTuple1(vertexId, regionId);
-            scalarsRegionSize->SetTuple1(vertexId, regionSize);
-            scalarsRegionSpan->SetTuple1(vertexId, regionSpan);
-         }
-         //cout << endl;
+      }
 
-         // RegionType
+      // RegionType
+      int regionType{};
+      if (regionTypes) {
+         NodeType upNodeType   = (*nodeTypes_)[a->getUpNodeId()];
+         NodeType downNodeType = (*nodeTypes_)[a->getDownNodeId()];
          if (upNodeType == NodeType::LOCAL_MINIMUM && downNodeType == NodeType::LOCAL_MAXIMUM)
             regionType = static_cast<int>(ArcType::MIN_ARC);
          else if (upNodeType == NodeType::LOCAL_MINIMUM || downNodeType == NodeType::LOCAL_MINIMUM)
@@ -1745,24 +1886,59 @@ void vtkContourForests::getSegmentation(vtkDataSet* input)
             regionType = static_cast<int>(ArcType::SADDLE2_ARC);
          else
             regionType = static_cast<int>(ArcType::SADDLE1_SADDLE2_ARC);
+      }
 
-         for (int j = 0; j < tree_->getSuperArc(i)->getNumberOfRegularNodes(); ++j) {
-            int nodeId   = tree_->getSuperArc(i)->getRegularNodeId(j);
-            if(tree_->getSuperArc(i)->isMasqued(j)){
-                // Ignore masqued ones
-                continue;
-            }
-            int vertexId = nodeId;
-            scalarsRegionType->SetTuple1(vertexId, regionType);
-         }
+      const int nbRegular = a->getNumberOfRegularNodes();
+      for (int j = 0; j < nbRegular; ++j) {
+         if (a->isMasqued(j))
+            continue;
+
+         const int vertexId = a->getRegularNodeId(j);
+         regionIds[vertexId] = regionId;
+         if (regionTypes)
+            regionTypes[vertexId] = regionType;
+         if (regionSizes)
+            regionSizes[vertexId] = regionSize;
+         if (regionSpans)
+            regionSpans[vertexId] = regionSpan;
+      }
+   }
+
+   // nodes are shared by several arcs: the last visible arc wins
+   for (int i = 0; i < nbArcs; ++i) {
+      if (arcRegionId[i] == -1)
+         continue;
+
+      const SuperArc* a          = tree_->getSuperArc(i);
+      const int       upVertex   = tree_->getNode(a->getUpNodeId())->getVertexId();
+      const int       downVertex = tree_->getNode(a->getDownNodeId())->getVertexId();
+
+      regionIds[downVertex] = regionIds[upVertex] = arcRegionId[i];
+      if (regionSizes)
+         regionSizes[downVertex] = regionSizes[upVertex] = tree_->getNumberOfVisibleRegularNode(i);
+      if (regionSpans) {
+         double coordUp[3];
+         double coordDown[3];
+         getVertexPosition(upVertex, coordUp);
+         getVertexPosition(downVertex, coordDown);
+         regionSpans[downVertex] = regionSpans[upVertex] = Geometry::distance(coordUp, coordDown);
       }
    }
 
    // output
    segmentation_->GetPointData()->AddArray(scalarsRegionId);
-   segmentation_->GetPointData()->AddArray(scalarsRegionType);
-   segmentation_->GetPointData()->AddArray(scalarsRegionSize);
-   segmentation_->GetPointData()->AddArray(scalarsRegionSpan);
+   if (showRegionType_)
+      segmentation_->GetPointData()->AddArray(scalarsRegionType);
+   else
+      segmentation_->GetPointData()->RemoveArray("RegionType");
+   if (showRegionSize_)
+      segmentation_->GetPointData()->AddArray(scalarsRegionSize);
+   else
+      segmentation_->GetPointData()->RemoveArray("RegionSize");
+   if (showRegionSpan_)
+      segmentation_->GetPointData()->AddArray(scalarsRegionSpan);
+   else
+      segmentation_->GetPointData()->RemoveArray("RegionSpan");
 
    // ce qui est fait n'est plus à faire
    toComputeSegmentation_ = false;
@@ -1771,8 +1947,9 @@ void vtkContourForests::getSegmentation(vtkDataSet* input)
       stringstream msg;
       msg << "[vtkContourForests] Topological segmentation built in " << t.getElapsedTime()
           << "s :" << endl;
-      msg << "[vtkContourForests]   RegionType: " << boolalpha
-          << (bool)scalarsRegionType->GetNumberOfTuples() << endl;
+      msg << "[vtkContourForests]   RegionType: " << boolalpha << showRegionType_ << endl;
+      msg << "[vtkContourForests]   RegionSize: " << boolalpha << showRegionSize_ << endl;
+      msg << "[vtkContourForests]   RegionSpan: " << boolalpha << showRegionSpan_ << endl;
       msg << "[vtkContourForests]   SegmentationId: " << boolalpha
           << (bool)scalarsRegionId->GetNumberOfTuples() << endl;
       dMsg(cout, msg.str(), timeMsg);
@@ -1784,18 +1961,101 @@ void vtkContourForests::getTree()
    // set ContourTree input and call
    setDebugLevel(debugLevel_);
    contourTree_->setTriangulation(triangulation_);
-   contourTree_->setVertexScalars(vertexScalars_->data());
    contourTree_->setPartitionNum(partitionNum_);
    contourTree_->setSimplificationMethod(simplificationType_);
-   contourTree_->build<double>(treeType_ == TreeType::CONTOUR_TREE, calculSegmentation_,
-                               simplificationThreshold_);
+   contourTree_->setTreeSelection(static_cast<int>(treeType_));
+   // build directly on the native buffer of the active field
+   // time-varying values on a fixed mesh: keep what the next update needs
+   const bool updatable = varyingDataValues_ && !varyingMeshConnectivity_ &&
+                          treeType_ == TreeType::CONTOUR_TREE;
+   contourTree_->setIncrementalUpdate(updatable);
+   switch (vertexScalars_->GetDataType()) {
+      vtkTemplateMacro({
+         contourTree_->setVertexScalars((VTK_TT*)vertexScalars_->GetVoidPointer(0));
+         contourTree_->build<VTK_TT>(treeType_ == TreeType::CONTOUR_TREE, calculSegmentation_,
+                                     simplificationThreshold_);
+      });
+   }
    setDebugLevel(1);
 
+   previousScalars_->clear();
+   if (updatable) {
+      const char* scalars = (const char*)vertexScalars_->GetVoidPointer(0);
+      previousScalars_->assign(
+          scalars, scalars + (size_t)numberOfVertices_ * vertexScalars_->GetDataTypeSize());
+      previousScalarsType_ = vertexScalars_->GetDataType();
+      previousThreshold_   = simplificationThreshold_;
+   }
+
    // ce qui est fait n'est plus à faire
    toComputeContourTree_    = false;
    toComputeSimplification_ = false;
 }
 
+int vtkContourForests::getUpdatedTree()
+{
+   const int typeSize = vertexScalars_->GetDataTypeSize();
+
+   if (treeType_ != TreeType::CONTOUR_TREE || vertexScalars_->GetDataType() != previousScalarsType_ ||
+       previousScalars_->size() != (size_t)numberOfVertices_ * typeSize ||
+       simplificationThreshold_ != previousThreshold_) {
+      return -1;
+   }
+
+   // vertices whose value changed since the last tree
+   const char*         scalars  = (const char*)vertexScalars_->GetVoidPointer(0);
+   char*               previous = previousScalars_->data();
+   vector<vector<int>> threadChanged(threadNumber_);
+
+#ifdef withOpenMP
+#pragma omp parallel num_threads(threadNumber_)
+#endif
+   {
+#ifdef withOpenMP
+      vector<int>& changed = threadChanged[omp_get_thread_num()];
+#pragma omp for schedule(static)
+#else
+      vector<int>& changed = threadChanged[0];
+#endif
+      for (int i = 0; i < (int)numberOfVertices_; ++i) {
+         const size_t offset = (size_t)i * typeSize;
+         if (memcmp(scalars + offset, previous + offset, typeSize)) {
+            memcpy(previous + offset, scalars + offset, typeSize);
+            changed.push_back(i);
+         }
+      }
+   }
+
+   vector<int> changedVertices;
+   for (const auto& changed : threadChanged)
+      changedVertices.insert(changedVertices.end(), changed.begin(), changed.end());
+
+   {
+      stringstream msg;
+      msg << "[vtkContourForests] " << changedVertices.size() << " vertices changed." << endl;
+      dMsg(cout, msg.str(), infoMsg);
+   }
+
+   if (changedVertices.size()) {
+      tree_ = nullptr;
+      setDebugLevel(debugLevel_);
+      switch (vertexScalars_->GetDataType()) {
+         vtkTemplateMacro({
+            contourTree_->setVertexScalars((VTK_TT*)vertexScalars_->GetVoidPointer(0));
+            contourTree_->update<VTK_TT>(changedVertices, simplificationThreshold_);
+         });
+      }
+      setDebugLevel(1);
+
+      mergePairs_->clear();
+      splitPairs_->clear();
+      pairs_->clear();
+   }
+
+   toComputeSimplification_ = false;
+   return 0;
+}
+
 void vtkContourForests::updateTree()
 {
    // polymorphic tree
@@ -1898,7 +2158,8 @@ int vtkContourForests::doIt(vtkDataSet* input, vtkPolyData* outputSkeletonNodes,
    else {
 
       // conversion
-      vtkDataSetToStdVector(input);
+      if (vtkDataSetToStdVector(input))
+         return -1;
 
        if(simplificationType_ == 0){
           simplificationThreshold_ = simplificationThresholdBuffer_ * deltaScalar_;
@@ -1924,8 +2185,11 @@ int vtkContourForests::doIt(vtkDataSet* input, vtkPolyData* outputSkeletonNodes,
       /// ContourTree ///
       if (varyingMeshGeometry_ || varyingMeshConnectivity_ || varyingDataValues_ ||
           toComputeContourTree_) {
-         clearTree();
-         getTree();
+         // same mesh: only the vertices whose value changed are processed
+         if (toComputeContourTree_ || varyingMeshConnectivity_ || getUpdatedTree()) {
+            clearTree();
+            getTree();
+         }
          //getCurves();
       }
 
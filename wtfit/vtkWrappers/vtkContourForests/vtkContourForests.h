@@ -21,39 +21,41 @@
 #include <vtkTriangulation.h>
 
 // VTK includes
-#include <vtkAppendPolyData.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
 #include <vtkConnectivityFilter.h>
+#include <vtkDataArray.h>
 #include <vtkDataSet.h>
 #include <vtkDataSetAlgorithm.h>
 #include <vtkDoubleArray.h>
 #include <vtkGenericCell.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkIdTypeArray.h>
 #include <vtkIntArray.h>
 #include <vtkLine.h>
-#include <vtkLineSource.h>
 #include <vtkMath.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPointSet.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
 #include <vtkTable.h>
 
 struct _persistenceCmp2 {
-   _persistenceCmp2(const vector<double>* vertexScalars)
+   _persistenceCmp2(vtkDataArray* vertexScalars)
    {
       vertexScalars_ = vertexScalars;
    }
 
    bool operator()(const pair<pair<int, int>, double>& p0, const pair<pair<int, int>, double>& p1)
    {
-      return (*vertexScalars_)[p0.first.first] < (*vertexScalars_)[p1.first.first];
+      return vertexScalars_->GetTuple1(p0.first.first) < vertexScalars_->GetTuple1(p1.first.first);
    }
 
-   const vector<double>* vertexScalars_;
+   vtkDataArray* vertexScalars_;
 };
 
 enum class TreeComponent { ARC = -1, LOCAL_MINIMUM, SADDLE1, SADDLE2, LOCAL_MAXIMUM };
@@ -62,7 +64,7 @@ enum class TreeType { MERGE_TREE = 0, SPLIT_TREE = 1, CONTOUR_TREE = 2 };
 
 enum class ArcType { MIN_ARC = 0, MAX_ARC, SADDLE1_ARC, SADDLE2_ARC, SADDLE1_SADDLE2_ARC };
 
-enum class NodeType { LOCAL_MINIMUM = 0, SADDLE1, SADDLE2, LOCAL_MAXIMUM, REGULAR };
+enum class NodeType : char { LOCAL_MINIMUM = 0, SADDLE1, SADDLE2, LOCAL_MAXIMUM, REGULAR };
 
 class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, public Wrapper
 {
@@ -103,11 +105,23 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    void ShowSaddle1(bool state);
    void ShowSaddle2(bool state);
    void ShowSegmentation(bool segm);
+   void ShowRegionType(bool state);
+   void ShowRegionSize(bool state);
+   void ShowRegionSpan(bool state);
 
    void ShowArc(bool state);
    void SetArcResolution(int arcResolution);
    void SetPartitionNumber(int partitionNum);
    void SetLessPartition(bool l);
+   void SetPartitionsPerThread(int p);
+   void SetPartitionGroups(int g);
+   void SetPruneOnTheFly(bool p);
+   void SetPartitionSort(bool p);
+   void SetWorkBalance(bool b);
+   void SetOverlapWeight(double w);
+   void SetThreadPool(bool p);
+   void SetNumaReplication(bool r);
+   void SetThreadAffinity(string affinity);
 
    void SetSkeletonSmoothing(double skeletonSmooth);
 
@@ -120,6 +134,17 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
 
    void SetSimplifyPersistenceDiagram(bool state);
 
+   // write the last computed tree and its persistence pairs
+   // (see MergeTree::writeBinary)
+   int WriteTree(string fileName);
+
+   // reuse the sorted vertices of a previous run on the same field
+   // (see MergeTree::setSortCacheDirectory), empty to disable
+   void SetSortCacheDirectory(string directory);
+   // reuse the edges and vertex neighbors of a previous run on the same
+   // unstructured mesh (see ExplicitTriangulation::setCacheDirectory)
+   void SetMeshCacheDirectory(string directory);
+
   protected:
    vtkContourForests();
    ~vtkContourForests();
@@ -133,10 +158,25 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    /// Base ///
    int vtkDataSetToStdVector(vtkDataSet* input);
    int check(vtkDataSet* input);
-   bool isCoincident(double p1[], double p2[]);
+   bool isCoincident(const double p1[], const double p2[]);
+   // positions are read from the triangulation: the vtkPoints buffer is not
+   // copied and image data coordinates are computed implicitly
+   inline void getVertexPosition(const int& vertexId, double point[3]) const
+   {
+      if (pointInput_) {
+         pointInput_->GetPoint(vertexId, point);
+         return;
+      }
+
+      float p[3];
+      triangulation_->getVertexPoint(vertexId, p[0], p[1], p[2]);
+      for (unsigned int k = 0; k < 3; ++k)
+         point[k] = p[k];
+   }
 
    /// ContourTree ///
    void getTree();
+   int getUpdatedTree();
    void updateTree();
    NodeType getNodeType(int id);
    NodeType getNodeType(int id, TreeType type, MergeTree* tree);
@@ -148,8 +188,10 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    void clearSkeleton();
    void getSkeletonNodes();
    void getSkeletonArcs();
-   int getSkeletonScalars(const vector<double>& scalars,
-                          vector<vector<double> >& skeletonScalars) const;
+   // typed buffer of the field: GetTuple1() is not thread safe
+   template <typename scalarType>
+   int getSkeletonScalars(const scalarType* scalars, const int arcId,
+                          vector<double>& arcScalars) const;
 
    /// Segmentation ///
    void getSegmentation(vtkDataSet* input);
@@ -168,12 +210,16 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    void getPersistenceDiagram(TreeType type);
    void getDiagrams();
 
+   int getSampleId(const double f, const double fmin, const double delta,
+                   const int samplingLevel) const;
    int sample(unsigned int samplingLevel);
+   template <typename scalarType>
+   int sample(const scalarType* scalars, unsigned int samplingLevel);
 
    int computeBarycenters();
    void computeSkeleton(unsigned int arcRes);
    void smoothSkeleton(unsigned int skeletonSmoothing);
-   void smooth(const int idArc, bool order);
+   void smooth(const int idArc, bool order, double* smoothed);
 
   private:
    /// Base ///
@@ -184,6 +230,16 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    bool isLoaded_;
    bool calculSegmentation_;
    bool lessPartition_;
+   int partitionsPerThread_;
+   int partitionGroups_;
+   bool pruneOnTheFly_;
+   bool partitionSort_;
+   bool workBalance_;
+   double overlapWeight_;
+   bool threadPool_;
+   ThreadPoolExecutor* threadPoolExecutor_;
+   bool numaReplication_;
+   string threadAffinity_;
    MergeTree* tree_;
    ParallelContourTree* contourTree_;
    vtkPolyData* skeletonNodes_;
@@ -216,6 +272,9 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    bool showSaddle1_;
    bool showSaddle2_;
    bool showArc_;
+   bool showRegionType_;
+   bool showRegionSize_;
+   bool showRegionSpan_;
    unsigned int arcResolution_;
    int partitionNum_;
    unsigned int skeletonSmoothing_;
@@ -223,6 +282,8 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    double simplificationThreshold_;
    double simplificationThresholdBuffer_;
    bool simplifyPersistenceDiagram_;
+   string sortCacheDirectory_;
+   string meshCacheDirectory_;
 
    /// Computation handles
    bool toUpdateVertexSoSoffsets_;
@@ -239,20 +300,33 @@ class VTKFILTERSCORE_EXPORT vtkContourForests : public vtkDataSetAlgorithm, publ
    unsigned int originalNumberOfCriticalPoints_;
    unsigned int numberOfVertices_;
    vtkTriangulation* triangulation_;
+   // input read for the positions when its points are not float (the
+   // triangulation reads them as float)
+   vtkDataSet* pointInput_;
    vector<vector<int>>* vertexNeighbors_;
-   vector<vector<double>>* vertexPositions_;
    vector<int>* vertexSoSoffsets_;
    vector<int>* criticalPoints_;
-   vector<double>* vertexScalars_;
-   vector<vector<double>>* inputScalars_;
+   // type of each node of tree_, REGULAR for the non critical ones
+   vector<NodeType>* nodeTypes_;
+   vtkDataArray* vertexScalars_;
+   vector<vtkDataArray*>* inputScalars_;
    vector<string>* inputScalarsName_;
    vector<pair<pair<int, int>, double>>* mergePairs_;
    vector<pair<pair<int, int>, double>>* splitPairs_;
    vector<pair<pair<int, int>, double>>* pairs_;
 
-   // treeType, SuperArc, several vertices list.
-   vector<vector<vector<vector<int>>>>*    samples_;
-   vector<vector<vector<vector<double>>>>* barycenters_;
+   // skeleton of the current tree, flat: arc -> non empty samples -> vertices
+   vector<int>*    arcSampleOffsets_;
+   vector<int>*    sampleOffsets_;
+   vector<int>*    sampleVertices_;
+   // one barycenter (x, y, z) per sample
+   vector<double>* barycenters_;
+
+   // active field of the last contour tree: on a fixed mesh, the next tree
+   // only processes the vertices whose value changed (empty: full build)
+   vector<char>* previousScalars_;
+   int           previousScalarsType_;
+   double        previousThreshold_;
 
    /// base code features ///
    bool needsToAbort();